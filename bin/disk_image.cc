@@ -0,0 +1,450 @@
+/// Rutinas para leer y modificar imágenes de disco de Nachos.
+///
+/// Ver `disk_image.hh`.
+
+
+#include "disk_image.hh"
+#include "filesys/raw_directory.hh"
+#include "filesys/raw_super_block.hh"
+#include "machine/disk.hh"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+
+void
+Fail(const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    fprintf(stderr, "error: ");
+    vfprintf(stderr, format, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+    exit(1);
+}
+
+Image
+OpenImage(const char *path, bool writable)
+{
+    int fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd == -1) {
+        Fail("no se puede abrir %s: %s", path, strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t) st.st_size < LABEL_SIZE) {
+        Fail("%s no es un disco de Nachos", path);
+    }
+
+    Image img;
+    img.size = st.st_size;
+    img.base = (char *) mmap(nullptr, img.size,
+                             PROT_READ | (writable ? PROT_WRITE : 0),
+                             MAP_SHARED, fd, 0);
+    close(fd);
+    if (img.base == MAP_FAILED) {
+        Fail("no se puede mapear %s: %s", path, strerror(errno));
+    }
+
+    const unsigned *label = (const unsigned *) img.base;
+    if (label[0] == MAGIC_NUMBER) {
+        img.headerSize      = MAGIC_SIZE;
+        img.sectorsPerTrack = SECTORS_PER_TRACK;
+        img.numTracks       = NUM_TRACKS;
+    } else if (label[0] == LABEL_MAGIC_NUMBER) {
+        img.headerSize      = LABEL_SIZE;
+        img.sectorsPerTrack = label[1];
+        img.numTracks       = label[2];
+    } else {
+        Fail("%s no es un disco de Nachos (etiqueta 0x%X)", path, label[0]);
+    }
+    img.numSectors = img.sectorsPerTrack * img.numTracks;
+    if (img.numSectors <= SUPER_BLOCK_SECTOR
+          || img.size < img.headerSize
+                        + (size_t) img.numSectors * SECTOR_SIZE) {
+        Fail("%s está truncado", path);
+    }
+
+    const RawSuperBlock *sb
+      = (const RawSuperBlock *) img.Sector(SUPER_BLOCK_SECTOR);
+    img.hasSuperBlock   = sb->magic == SUPER_BLOCK_MAGIC;
+    img.sectorsPerBlock = 1;
+    if (img.hasSuperBlock && sb->sectorsPerBlock != 0) {
+        img.sectorsPerBlock = sb->sectorsPerBlock;
+    }
+    return img;
+}
+
+Image
+CreateImage(const char *path, unsigned sectorsPerTrack, unsigned numTracks)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        Fail("no se puede crear %s: %s", path, strerror(errno));
+    }
+
+    Image img;
+    img.headerSize      = LABEL_SIZE;
+    img.sectorsPerTrack = sectorsPerTrack;
+    img.numTracks       = numTracks;
+    img.numSectors      = sectorsPerTrack * numTracks;
+    img.sectorsPerBlock = 1;
+    img.hasSuperBlock   = true;
+    img.size = img.headerSize + (size_t) img.numSectors * SECTOR_SIZE;
+    if (ftruncate(fd, img.size) == -1) {
+        Fail("no se puede agrandar %s: %s", path, strerror(errno));
+    }
+    img.base = (char *) mmap(nullptr, img.size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED, fd, 0);
+    close(fd);
+    if (img.base == MAP_FAILED) {
+        Fail("no se puede mapear %s: %s", path, strerror(errno));
+    }
+
+    unsigned *label = (unsigned *) img.base;
+    label[0] = LABEL_MAGIC_NUMBER;
+    label[1] = sectorsPerTrack;
+    label[2] = numTracks;
+    return img;
+}
+
+void
+CloseImage(Image &img)
+{
+    msync(img.base, img.size, MS_SYNC);
+    munmap(img.base, img.size);
+}
+
+unsigned
+BlockSector(const Image &img, const RawFileHeader *raw, unsigned block)
+{
+    unsigned i = block / BLOCKS_PER_INDIRECT;
+    unsigned j = block / NUM_DIRECT % NUM_DIRECT;
+    unsigned k = block % NUM_DIRECT;
+    return img.Node(img.Node(raw->dataSectors[i])->dataSectors[j])
+              ->dataSectors[k];
+}
+
+unsigned
+ReadAt(const Image &img, unsigned header, char *data, unsigned size,
+       unsigned offset)
+{
+    const RawFileHeader *raw = img.Header(header);
+    if (offset >= raw->numBytes) {
+        return 0;
+    }
+    size = std::min(size, raw->numBytes - offset);
+
+    unsigned blockSize = img.BlockSize();
+    for (unsigned done = 0; done < size;) {
+        unsigned pos = offset + done;
+        unsigned n = std::min(blockSize - pos % blockSize, size - done);
+        memcpy(data + done,
+               img.Sector(BlockSector(img, raw, pos / blockSize))
+                 + pos % blockSize, n);
+        done += n;
+    }
+    return size;
+}
+
+std::vector<char>
+ReadFile(const Image &img, unsigned header)
+{
+    std::vector<char> data(img.Header(header)->numBytes);
+    ReadAt(img, header, data.data(), data.size(), 0);
+    return data;
+}
+
+bool
+LooksLikeFile(const Image &img, unsigned header)
+{
+    const RawFileHeader *raw = img.Header(header);
+    unsigned blockSize = img.BlockSize();
+    if (raw->numSectors > NUM_INDIRECT * BLOCKS_PER_INDIRECT
+          || raw->numBytes > (unsigned long) raw->numSectors * blockSize) {
+        return false;
+    }
+    for (unsigned b = 0; b < raw->numSectors; b++) {
+        unsigned i = b / BLOCKS_PER_INDIRECT;
+        unsigned j = b / NUM_DIRECT % NUM_DIRECT;
+        unsigned l1 = raw->dataSectors[i];
+        if (l1 >= img.numSectors) {
+            return false;
+        }
+        unsigned l2 = img.Node(l1)->dataSectors[j];
+        if (l2 >= img.numSectors) {
+            return false;
+        }
+        unsigned s = img.Node(l2)->dataSectors[b % NUM_DIRECT];
+        if (s + img.sectorsPerBlock > img.numSectors) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+ValidEntry(const Image &img, const DirectoryEntry *e)
+{
+    unsigned char inUse = *(const unsigned char *) &e->inUse;
+    unsigned char isDir = *(const unsigned char *) &e->isDir;
+    if (inUse > 1 || isDir > 1) {
+        return false;
+    }
+    size_t len = strnlen(e->name, FILE_NAME_MAX_LEN + 1);
+    if (len == 0 || len > FILE_NAME_MAX_LEN) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if ((unsigned char) e->name[i] < ' ' || e->name[i] == '/') {
+            return false;
+        }
+    }
+    return e->sector > SUPER_BLOCK_SECTOR && e->sector < img.numSectors;
+}
+
+std::vector<DirectoryEntry>
+ReadEntries(const Image &img, unsigned header)
+{
+    std::vector<char> data = ReadFile(img, header);
+    unsigned n = std::min((unsigned) (data.size() / sizeof (DirectoryEntry)),
+                          MAX_DIR_ENTRIES);
+    std::vector<DirectoryEntry> entries;
+    for (unsigned i = 0; i < n; i++) {
+        DirectoryEntry e;
+        memcpy(&e, data.data() + i * sizeof e, sizeof e);
+        if (*(const unsigned char *) &e.inUse == 0) {
+            break;
+        }
+        entries.push_back(e);
+    }
+    return entries;
+}
+
+Allocator::Allocator(unsigned n)
+  : map(DivRoundUp(n, BITS_IN_WORD)), numSectors(n), cursor(0)
+{}
+
+Allocator::Allocator(const Image &img)
+  : Allocator(img.numSectors)
+{
+    std::vector<char> data = ReadFile(img, FREE_MAP_SECTOR);
+    memcpy(map.data(), data.data(),
+           std::min(data.size(), map.size() * sizeof (unsigned)));
+}
+
+bool
+Allocator::Test(unsigned s) const
+{
+    return map[s / BITS_IN_WORD] & (1u << s % BITS_IN_WORD);
+}
+
+void
+Allocator::Mark(unsigned s)
+{
+    map[s / BITS_IN_WORD] |= 1u << s % BITS_IN_WORD;
+}
+
+void
+Allocator::Clear(unsigned s)
+{
+    map[s / BITS_IN_WORD] &= ~(1u << s % BITS_IN_WORD);
+}
+
+unsigned
+Allocator::NumMarked() const
+{
+    unsigned n = 0;
+    for (unsigned s = 0; s < numSectors; s++) {
+        n += Test(s);
+    }
+    return n;
+}
+
+int
+Allocator::Find(unsigned count)
+{
+    // Primero desde el cursor hasta el final y después desde el comienzo.
+    unsigned from = DivRoundUp(cursor, count) * count;
+    for (unsigned pass = 0; pass < 2; pass++) {
+        unsigned to = pass == 0 ? numSectors : from;
+        for (unsigned s = pass == 0 ? from : 0; s + count <= to;
+             s += count) {
+            unsigned n = 0;
+            while (n < count && !Test(s + n)) {
+                n++;
+            }
+            if (n == count) {
+                for (n = 0; n < count; n++) {
+                    Mark(s + n);
+                }
+                cursor = s + count;
+                return s;
+            }
+        }
+    }
+    return -1;
+}
+
+void
+SaveFreeMap(Image &img, const Allocator &alloc)
+{
+    WriteAt(img, FREE_MAP_SECTOR, (const char *) alloc.map.data(),
+            img.Header(FREE_MAP_SECTOR)->numBytes, 0);
+}
+
+void
+InitFile(Image &img, unsigned header)
+{
+    memset(img.Sector(header), 0, SECTOR_SIZE);
+}
+
+/// Reserva un sector para un nodo indirecto y lo deja en cero.
+static int
+AllocateNode(Image &img, Allocator &alloc)
+{
+    int s = alloc.Find(1);
+    if (s != -1) {
+        memset(img.Sector(s), 0, SECTOR_SIZE);
+    }
+    return s;
+}
+
+/// Agrega el bloque `block`, y los nodos que le falten, al final del
+/// archivo.  Si no hay lugar, libera lo que haya reservado.
+static bool
+AddBlock(Image &img, Allocator &alloc, RawFileHeader *raw, unsigned block)
+{
+    unsigned i = block / BLOCKS_PER_INDIRECT;
+    unsigned j = block / NUM_DIRECT % NUM_DIRECT;
+    bool newL1 = block % BLOCKS_PER_INDIRECT == 0;
+    bool newL2 = block % NUM_DIRECT == 0;
+
+    if (newL1) {
+        int s = AllocateNode(img, alloc);
+        if (s == -1) {
+            return false;
+        }
+        raw->dataSectors[i] = s;
+    }
+    RawIndirectNode *l1 = img.Node(raw->dataSectors[i]);
+    if (newL2) {
+        int s = AllocateNode(img, alloc);
+        if (s == -1) {
+            if (newL1) {
+                alloc.Clear(raw->dataSectors[i]);
+            }
+            return false;
+        }
+        l1->dataSectors[j] = s;
+    }
+    RawIndirectNode *l2 = img.Node(l1->dataSectors[j]);
+    int s = alloc.Find(img.sectorsPerBlock);
+    if (s == -1) {
+        if (newL2) {
+            alloc.Clear(l1->dataSectors[j]);
+        }
+        if (newL1) {
+            alloc.Clear(raw->dataSectors[i]);
+        }
+        return false;
+    }
+    l2->dataSectors[block % NUM_DIRECT] = s;
+    memset(img.Sector(s), 0, img.BlockSize());
+    return true;
+}
+
+/// Saca el último bloque del archivo y los nodos que queden vacíos.
+static void
+RemoveLastBlock(Image &img, Allocator &alloc, RawFileHeader *raw)
+{
+    assert(raw->numSectors > 0);
+    unsigned block = --raw->numSectors;
+    unsigned i = block / BLOCKS_PER_INDIRECT;
+    unsigned j = block / NUM_DIRECT % NUM_DIRECT;
+    RawIndirectNode *l1 = img.Node(raw->dataSectors[i]);
+    RawIndirectNode *l2 = img.Node(l1->dataSectors[j]);
+
+    unsigned s = l2->dataSectors[block % NUM_DIRECT];
+    for (unsigned n = 0; n < img.sectorsPerBlock; n++) {
+        alloc.Clear(s + n);
+    }
+    if (block % NUM_DIRECT == 0) {
+        alloc.Clear(l1->dataSectors[j]);
+    }
+    if (block % BLOCKS_PER_INDIRECT == 0) {
+        alloc.Clear(raw->dataSectors[i]);
+    }
+}
+
+bool
+ResizeFile(Image &img, Allocator &alloc, unsigned header, unsigned size)
+{
+    RawFileHeader *raw = img.Header(header);
+    unsigned blockSize = img.BlockSize();
+    unsigned oldBlocks = raw->numSectors;
+    unsigned newBlocks = DivRoundUp(size, blockSize);
+    if (newBlocks > NUM_INDIRECT * BLOCKS_PER_INDIRECT) {
+        return false;
+    }
+
+    // Los nodos de un archivo nuevo van pegados a su header.
+    if (oldBlocks == 0) {
+        alloc.cursor = header;
+    }
+    while (raw->numSectors < newBlocks) {
+        if (!AddBlock(img, alloc, raw, raw->numSectors)) {
+            while (raw->numSectors > oldBlocks) {
+                RemoveLastBlock(img, alloc, raw);
+            }
+            return false;
+        }
+        raw->numSectors++;
+    }
+    while (raw->numSectors > newBlocks) {
+        RemoveLastBlock(img, alloc, raw);
+    }
+
+    // Al achicar, lo que queda del último bloque después del final se
+    // borra para que no reaparezca si el archivo vuelve a crecer.
+    if (size < raw->numBytes && size % blockSize != 0) {
+        char *last = img.Sector(BlockSector(img, raw, size / blockSize));
+        memset(last + size % blockSize, 0, blockSize - size % blockSize);
+    }
+    raw->numBytes = size;
+    return true;
+}
+
+void
+FreeFile(Image &img, Allocator &alloc, unsigned header)
+{
+    ResizeFile(img, alloc, header, 0);
+    alloc.Clear(header);
+}
+
+void
+WriteAt(Image &img, unsigned header, const char *data, unsigned size,
+        unsigned offset)
+{
+    const RawFileHeader *raw = img.Header(header);
+    assert(offset + size <= raw->numBytes);
+
+    unsigned blockSize = img.BlockSize();
+    for (unsigned done = 0; done < size;) {
+        unsigned pos = offset + done;
+        unsigned n = std::min(blockSize - pos % blockSize, size - done);
+        memcpy(img.Sector(BlockSector(img, raw, pos / blockSize))
+                 + pos % blockSize, data + done, n);
+        done += n;
+    }
+}
@@ -0,0 +1,145 @@
+/// Acceso directo a imágenes de disco de Nachos.
+///
+/// Lee y modifica el archivo `DISK` mapeándolo en memoria, con las mismas
+/// estructuras en disco que `filesys/`: superbloque, bitmap, headers con
+/// doble indirección y directorios.  Lo usan `nachosfs` y el cliente FUSE.
+/// Ninguno de los dos puede usarse sobre un disco mientras Nachos lo tiene
+/// abierto.
+///
+/// No usa `FileHeader`, `FreeMap` ni `Directory`: pasan por `synchDisk` y
+/// toman locks, así que necesitan el disco simulado y los threads.  Con
+/// ellos comparte las estructuras en disco (`Raw*`, `DirectoryEntry`) y
+/// las constantes de la etiqueta y la geometría.
+
+#ifndef NACHOS_BIN_DISKIMAGE__HH
+#define NACHOS_BIN_DISKIMAGE__HH
+
+
+#include "filesys/directory_entry.hh"
+#include "filesys/raw_file_header.hh"
+
+#include <stddef.h>
+
+#include <vector>
+
+
+/// Bloques de datos que direcciona cada nodo de primer nivel.
+static const unsigned BLOCKS_PER_INDIRECT = NUM_DIRECT * NUM_DIRECT;
+
+
+/// Imagen de disco mapeada en memoria.
+struct Image {
+    char *base;
+    size_t size;
+    unsigned headerSize;
+    unsigned sectorsPerTrack;
+    unsigned numTracks;
+    unsigned numSectors;
+    unsigned sectorsPerBlock;
+    bool hasSuperBlock;
+
+    char *Sector(unsigned sector) const
+    {
+        return base + headerSize + (size_t) sector * SECTOR_SIZE;
+    }
+
+    RawFileHeader *Header(unsigned sector) const
+    {
+        return (RawFileHeader *) Sector(sector);
+    }
+
+    RawIndirectNode *Node(unsigned sector) const
+    {
+        return (RawIndirectNode *) Sector(sector);
+    }
+
+    unsigned BlockSize() const
+    {
+        return sectorsPerBlock * SECTOR_SIZE;
+    }
+};
+
+/// Imprime un error y termina.
+void Fail(const char *format, ...);
+
+/// Mapea un disco existente y lee su geometría de la etiqueta y del
+/// superbloque.
+Image OpenImage(const char *path, bool writable);
+
+/// Crea un disco vacío con la geometría dada, como lo haría `Disk` la
+/// primera vez.
+Image CreateImage(const char *path, unsigned sectorsPerTrack,
+                  unsigned numTracks);
+
+void CloseImage(Image &img);
+
+/// Primer sector del bloque `block` del archivo cuyo header es `raw`.
+unsigned BlockSector(const Image &img, const RawFileHeader *raw,
+                     unsigned block);
+
+/// Si los punteros del header de `header` están dentro del disco.  El
+/// resto de las funciones de lectura suponen que sí.
+bool LooksLikeFile(const Image &img, unsigned header);
+
+/// Lee el contenido completo de un archivo.
+std::vector<char> ReadFile(const Image &img, unsigned header);
+
+/// Lee hasta `size` bytes desde `offset`.  Devuelve cuántos leyó.
+unsigned ReadAt(const Image &img, unsigned header, char *data,
+                unsigned size, unsigned offset);
+
+/// Si una entrada tiene un nombre válido y apunta a un header del disco.
+bool ValidEntry(const Image &img, const DirectoryEntry *e);
+
+/// Entradas en uso de un directorio, contadas como lo hace `Directory`:
+/// hasta la primera libre y como mucho `MAX_DIR_ENTRIES`.
+std::vector<DirectoryEntry> ReadEntries(const Image &img, unsigned header);
+
+
+/// Bitmap de sectores y cursor de asignación.  Los sectores se buscan
+/// desde el cursor, así que lo que se reserva seguido queda contiguo y en
+/// el mismo orden que le daría `FileHeader::Allocate`: header, nodos y
+/// bloques de datos.
+struct Allocator {
+    std::vector<unsigned> map;
+    unsigned numSectors;
+    unsigned cursor;
+
+    /// Bitmap vacío.
+    Allocator(unsigned n);
+
+    /// Bitmap guardado en el disco.
+    Allocator(const Image &img);
+
+    bool Test(unsigned s) const;
+    void Mark(unsigned s);
+    void Clear(unsigned s);
+    unsigned NumMarked() const;
+
+    /// Reserva `count` sectores libres alineados a `count`, buscando desde
+    /// el cursor.  Devuelve -1 si no hay.
+    int Find(unsigned count);
+};
+
+/// Guarda el bitmap en su archivo, que ya tiene que tener el tamaño justo.
+void SaveFreeMap(Image &img, const Allocator &alloc);
+
+/// Deja en `header` el header de un archivo vacío.
+void InitFile(Image &img, unsigned header);
+
+/// Cambia el tamaño de un archivo, reservando o liberando bloques y
+/// nodos.  Lo agregado se lee como ceros.  Si no hay lugar devuelve
+/// `false` y deja el archivo como estaba.
+bool ResizeFile(Image &img, Allocator &alloc, unsigned header,
+                unsigned size);
+
+/// Libera los bloques, los nodos y el header de un archivo.
+void FreeFile(Image &img, Allocator &alloc, unsigned header);
+
+/// Escribe `size` bytes desde `offset`.  El archivo ya tiene que tener el
+/// tamaño necesario.
+void WriteAt(Image &img, unsigned header, const char *data, unsigned size,
+             unsigned offset);
+
+
+#endif
@@ -0,0 +1,435 @@
+/// A FUSE client the Nachos file system.
+///
+/// FUSE (Filesystem in Userspace) is a mechanism for integrating custom
+/// file systems from userspace in POSIX operating systems.  This program
+/// allows the user to mount Nachos' file system in a directory and then
+/// access it using all the standard tools (e.g. commands like `ls` and
+/// `cat`, or graphical file managers).
+///
+/// El cliente trabaja directamente sobre el archivo `DISK`, mapeado en
+/// memoria con las rutinas de `bin/disk_image.hh`, en lugar de correr
+/// `nachos` en cada operación.  Los caminos ya resueltos se guardan en un
+/// cache, así que un `stat` es una búsqueda en memoria.  Se pueden leer,
+/// escribir, crear, truncar y borrar archivos, y crear y borrar directorios
+/// vacíos; el tipo de cada entrada se toma del campo `isDir`.  Nachos no
+/// tiene que estar corriendo sobre el mismo disco mientras está montado.
+///
+/// Another limitation is that the `DISK` file, which contains the whole
+/// simulated disk content, must be available in the same directory where
+/// the FUSE client is executed.  It is recommended to set up a symbolic
+/// link to the original in the `filesys` directory.  If you launch the
+/// client with `make mount`, the link gets created automatically.
+///
+/// Copyright (c) 2018-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#define FUSE_USE_VERSION 26
+#include <fuse.h>
+#include <unistd.h>
+
+#include "bin/disk_image.hh"
+#include "filesys/raw_directory.hh"
+#include "filesys/raw_super_block.hh"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+
+#define DISK_NAME  "DISK"
+
+/// Un archivo o directorio ya encontrado.
+struct Node {
+    unsigned header;
+    bool isDir;
+};
+
+static Image image;
+static Allocator *freeMap;
+
+/// Caminos ya resueltos.  Se vacía cada vez que cambia algún directorio.
+static std::map<std::string, Node> lookupCache;
+
+/// FUSE atiende pedidos desde varios threads.
+static std::mutex fsLock;
+
+/// Busca un camino absoluto.  Devuelve 0 o `-ENOENT`.
+static int
+Lookup(const std::string &path, Node *node)
+{
+    if (path == "/") {
+        *node = {DIRECTORY_SECTOR, true};
+        return 0;
+    }
+    auto cached = lookupCache.find(path);
+    if (cached != lookupCache.end()) {
+        *node = cached->second;
+        return 0;
+    }
+
+    size_t slash = path.rfind('/');
+    std::string parentPath = slash == 0 ? "/" : path.substr(0, slash);
+    std::string name = path.substr(slash + 1);
+    Node parent;
+    int status = Lookup(parentPath, &parent);
+    if (status != 0) {
+        return status;
+    }
+    if (!parent.isDir) {
+        return -ENOTDIR;
+    }
+
+    for (const DirectoryEntry &e : ReadEntries(image, parent.header)) {
+        if (ValidEntry(image, &e) && name == e.name
+              && LooksLikeFile(image, e.sector)) {
+            *node = {e.sector, e.isDir != 0};
+            lookupCache[path] = *node;
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+/// Separa un camino en el directorio que lo contiene y el nombre.
+static int
+LookupParent(const char *path, Node *parent, std::string *name)
+{
+    std::string p = path;
+    size_t slash = p.rfind('/');
+    *name = p.substr(slash + 1);
+    int status = Lookup(slash == 0 ? "/" : p.substr(0, slash), parent);
+    if (status == 0 && !parent->isDir) {
+        status = -ENOTDIR;
+    }
+    return status;
+}
+
+/// `MAX_FILE_SIZE` cuenta bloques, que en este disco pueden ser de varios
+/// sectores.
+static unsigned long
+MaxFileSize()
+{
+    return (unsigned long) MAX_FILE_SIZE * image.sectorsPerBlock;
+}
+
+/// Guarda el bitmap y baja los cambios al archivo `DISK`.
+static void
+Sync()
+{
+    SaveFreeMap(image, *freeMap);
+    msync(image.base, image.size, MS_ASYNC);
+}
+
+static int
+do_getattr(const char *path, struct stat *st)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    Node node;
+    int status = Lookup(path, &node);
+    if (status != 0) {
+        return status;
+    }
+
+    const RawFileHeader *raw = image.Header(node.header);
+    time_t t = time(NULL);
+    memset(st, 0, sizeof *st);
+    st->st_ino = node.header;
+    st->st_uid = getuid();
+    st->st_gid = getgid();
+    st->st_atime = t;
+    st->st_mtime = t;
+    st->st_size = raw->numBytes;
+    st->st_blksize = image.BlockSize();
+    st->st_blocks = (blkcnt_t) raw->numSectors * image.BlockSize() / 512;
+    if (node.isDir) {
+        st->st_mode = S_IFDIR | 0755;
+        st->st_nlink = 2;
+    } else {
+        st->st_mode = S_IFREG | 0644;
+        st->st_nlink = 1;
+    }
+    return 0;
+}
+
+static int
+do_readdir(const char *path, void *buffer, fuse_fill_dir_t fill,
+           off_t offset, struct fuse_file_info *fi)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    Node node;
+    int status = Lookup(path, &node);
+    if (status != 0) {
+        return status;
+    }
+    if (!node.isDir) {
+        return -ENOTDIR;
+    }
+
+    (*fill)(buffer, ".", NULL, 0);
+    (*fill)(buffer, "..", NULL, 0);
+    for (const DirectoryEntry &e : ReadEntries(image, node.header)) {
+        if (ValidEntry(image, &e)) {
+            (*fill)(buffer, e.name, NULL, 0);
+        }
+    }
+    return 0;
+}
+
+static int
+do_open(const char *path, struct fuse_file_info *fi)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    Node node;
+    int status = Lookup(path, &node);
+    if (status == 0 && node.isDir) {
+        status = -EISDIR;
+    }
+    return status;
+}
+
+static int
+do_read(const char *path, char *buffer, size_t size, off_t offset,
+        struct fuse_file_info *fi)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    Node node;
+    int status = Lookup(path, &node);
+    if (status != 0) {
+        return status;
+    }
+    if (offset < 0 || (unsigned long) offset >= MaxFileSize()) {
+        return 0;
+    }
+    return ReadAt(image, node.header, buffer, size, offset);
+}
+
+/// Cambia el tamaño de un archivo ya encontrado.
+static int
+Resize(const Node &node, off_t size)
+{
+    if (size < 0 || (unsigned long) size > MaxFileSize()) {
+        return -EFBIG;
+    }
+    if (!ResizeFile(image, *freeMap, node.header, size)) {
+        return -ENOSPC;
+    }
+    Sync();
+    return 0;
+}
+
+static int
+do_write(const char *path, const char *buffer, size_t size, off_t offset,
+         struct fuse_file_info *fi)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    Node node;
+    int status = Lookup(path, &node);
+    if (status != 0) {
+        return status;
+    }
+    if (offset < 0 || (unsigned long) offset + size > MaxFileSize()) {
+        return -EFBIG;
+    }
+    if (offset + size > image.Header(node.header)->numBytes) {
+        status = Resize(node, offset + size);
+        if (status != 0) {
+            return status;
+        }
+    }
+    WriteAt(image, node.header, buffer, size, offset);
+    return size;
+}
+
+static int
+do_truncate(const char *path, off_t size)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    Node node;
+    int status = Lookup(path, &node);
+    if (status != 0) {
+        return status;
+    }
+    return node.isDir ? -EISDIR : Resize(node, size);
+}
+
+/// Agrega al directorio padre una entrada nueva para `path`, con un header
+/// vacío.
+static int
+AddEntry(const char *path, bool isDir)
+{
+    Node parent, node;
+    std::string name;
+    int status = LookupParent(path, &parent, &name);
+    if (status != 0) {
+        return status;
+    }
+    if (Lookup(path, &node) == 0) {
+        return -EEXIST;
+    }
+    if (name.empty()
+          || name.size() >= (isDir ? DIR_NAME_MAX_LEN : FILE_NAME_MAX_LEN)) {
+        return -ENAMETOOLONG;
+    }
+
+    // Las entradas en uso tienen que quedar al comienzo y seguidas de una
+    // libre, así que la nueva va al final y el directorio no puede llenarse.
+    unsigned index = ReadEntries(image, parent.header).size();
+    if (index >= MAX_DIR_ENTRIES - 1) {
+        return -ENOSPC;
+    }
+    unsigned entryEnd = (index + 1) * sizeof (DirectoryEntry);
+    if (entryEnd > image.Header(parent.header)->numBytes
+          && !ResizeFile(image, *freeMap, parent.header, entryEnd)) {
+        return -ENOSPC;
+    }
+    freeMap->cursor = parent.header;
+    int header = freeMap->Find(1);
+    if (header == -1) {
+        return -ENOSPC;
+    }
+    InitFile(image, header);
+
+    DirectoryEntry e;
+    memset(&e, 0, sizeof e);
+    e.inUse  = true;
+    e.isDir  = isDir;
+    e.sector = header;
+    strncpy(e.name, name.c_str(), FILE_NAME_MAX_LEN);
+    WriteAt(image, parent.header, (const char *) &e, sizeof e,
+            index * sizeof e);
+    Sync();
+    lookupCache.clear();
+    return 0;
+}
+
+/// Saca del directorio padre la entrada de `path` y libera su header.
+static int
+RemoveEntry(const char *path, bool isDir)
+{
+    Node parent, node;
+    std::string name;
+    int status = LookupParent(path, &parent, &name);
+    if (status == 0) {
+        status = Lookup(path, &node);
+    }
+    if (status != 0) {
+        return status;
+    }
+    if (node.isDir != isDir) {
+        return isDir ? -ENOTDIR : -EISDIR;
+    }
+    if (isDir && !ReadEntries(image, node.header).empty()) {
+        return -ENOTEMPTY;
+    }
+
+    // La última entrada pasa al lugar de la borrada, para que las que están
+    // en uso sigan seguidas.
+    std::vector<DirectoryEntry> entries = ReadEntries(image, parent.header);
+    unsigned last = entries.size() - 1;
+    for (unsigned i = 0; i <= last; i++) {
+        if (entries[i].sector == node.header) {
+            WriteAt(image, parent.header, (const char *) &entries[last],
+                    sizeof (DirectoryEntry), i * sizeof (DirectoryEntry));
+            break;
+        }
+    }
+    DirectoryEntry unused;
+    memset(&unused, 0, sizeof unused);
+    WriteAt(image, parent.header, (const char *) &unused, sizeof unused,
+            last * sizeof unused);
+
+    FreeFile(image, *freeMap, node.header);
+    Sync();
+    lookupCache.clear();
+    return 0;
+}
+
+static int
+do_create(const char *path, mode_t mode, struct fuse_file_info *fi)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    return AddEntry(path, false);
+}
+
+static int
+do_mkdir(const char *path, mode_t mode)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    return AddEntry(path, true);
+}
+
+static int
+do_unlink(const char *path)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    return RemoveEntry(path, false);
+}
+
+static int
+do_rmdir(const char *path)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    return RemoveEntry(path, true);
+}
+
+/// Nachos no guarda fechas; se acepta para que anden `touch` y `cp -p`.
+static int
+do_utimens(const char *path, const struct timespec tv[2])
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    Node node;
+    return Lookup(path, &node);
+}
+
+static int
+do_fsync(const char *path, int datasync, struct fuse_file_info *fi)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    msync(image.base, image.size, MS_SYNC);
+    return 0;
+}
+
+static void
+do_destroy(void *data)
+{
+    std::lock_guard<std::mutex> guard(fsLock);
+    Sync();
+    CloseImage(image);
+    delete freeMap;
+}
+
+int
+main(int argc, char *argv[])
+{
+    image = OpenImage(DISK_NAME, true);
+    if (!LooksLikeFile(image, FREE_MAP_SECTOR)
+          || !LooksLikeFile(image, DIRECTORY_SECTOR)) {
+        Fail("%s no tiene un sistema de archivos de Nachos", DISK_NAME);
+    }
+    freeMap = new Allocator(image);
+
+    struct fuse_operations operations;
+    memset(&operations, 0, sizeof operations);
+    operations.getattr  = do_getattr;
+    operations.readdir  = do_readdir;
+    operations.open     = do_open;
+    operations.read     = do_read;
+    operations.write    = do_write;
+    operations.truncate = do_truncate;
+    operations.create   = do_create;
+    operations.mkdir    = do_mkdir;
+    operations.unlink   = do_unlink;
+    operations.rmdir    = do_rmdir;
+    operations.utimens  = do_utimens;
+    operations.fsync    = do_fsync;
+    operations.destroy  = do_destroy;
+    return fuse_main(argc, argv, &operations, NULL);
+}
@@ -0,0 +1,554 @@
+/// Herramienta para manipular imágenes de disco de Nachos sin correr el
+/// simulador.
+///
+/// Trabaja directamente sobre el archivo `DISK`, mapeado en memoria, con
+/// las mismas estructuras en disco que `filesys/`: superbloque, bitmap,
+/// headers con doble indirección y directorios.  Como no simula la
+/// latencia del disco, armar un disco con miles de archivos o verificarlo
+/// lleva milisegundos.
+///
+/// Uso:
+///
+///     nachosfs mkfs DISK DIR [-geom S:T:N] [-bs N]
+///         Crea un disco nuevo con el contenido del directorio DIR del host.
+///         `-geom` y `-bs` son las mismas opciones que acepta `nachos -f`.
+///     nachosfs dump DISK [DIR]
+///         Lista el árbol de archivos.  Con DIR además los copia al host.
+///     nachosfs check DISK
+///         Verifica los headers y que el bitmap coincida con los sectores
+///         que usan.  Termina con 1 si encuentra errores.
+
+
+#include "disk_image.hh"
+#include "filesys/free_map.hh"
+#include "filesys/raw_directory.hh"
+#include "filesys/raw_super_block.hh"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+// `mkfs`: importa un árbol del host.
+
+static unsigned
+AllocateSector(Allocator &alloc)
+{
+    int s = alloc.Find(1);
+    if (s == -1) {
+        Fail("el disco se llenó");
+    }
+    return s;
+}
+
+/// Arma el header de un archivo de `size` bytes en el sector `header` y
+/// reserva sus nodos y bloques.
+static void
+AllocateFile(Image &img, Allocator &alloc, unsigned header, unsigned size)
+{
+    InitFile(img, header);
+    if (!ResizeFile(img, alloc, header, size)) {
+        Fail("no hay lugar para un archivo de %u bytes", size);
+    }
+}
+
+static bool
+ReadHostFile(const std::string &path, std::vector<char> &data)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    data.clear();
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+/// Importa el directorio `hostPath` en el directorio de Nachos cuyo header
+/// está en `header`.  Devuelve la cantidad de entradas que no se pudieron
+/// importar.
+static unsigned
+ImportDirectory(Image &img, Allocator &alloc, const std::string &hostPath,
+                unsigned header, unsigned &numFiles, unsigned &numDirs)
+{
+    DIR *dir = opendir(hostPath.c_str());
+    if (dir == nullptr) {
+        Fail("no se puede abrir %s: %s", hostPath.c_str(), strerror(errno));
+    }
+
+    struct Child {
+        std::string name;
+        bool isDir;
+    };
+    std::vector<Child> children;
+    unsigned skipped = 0;
+    for (struct dirent *d; (d = readdir(dir)) != nullptr;) {
+        std::string name = d->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        std::string path = hostPath + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) == -1
+              || !(S_ISDIR(st.st_mode) || S_ISREG(st.st_mode))) {
+            fprintf(stderr, "nachosfs: salteo %s: no es un archivo "
+                    "regular ni un directorio\n", path.c_str());
+            skipped++;
+            continue;
+        }
+        bool isDir = S_ISDIR(st.st_mode);
+        // Los mismos límites que `Create` y `MkDir`.
+        if (name.size() >= FILE_NAME_MAX_LEN
+              || (isDir && name.size() >= DIR_NAME_MAX_LEN)) {
+            fprintf(stderr, "nachosfs: salteo %s: nombre demasiado largo\n",
+                    path.c_str());
+            skipped++;
+            continue;
+        }
+        children.push_back({name, isDir});
+    }
+    closedir(dir);
+
+    std::sort(children.begin(), children.end(),
+              [](const Child &a, const Child &b) { return a.name < b.name; });
+    // Un directorio con `MAX_DIR_ENTRIES` entradas en uso no deja la libre
+    // que marca el final.
+    if (children.size() >= MAX_DIR_ENTRIES) {
+        for (size_t i = MAX_DIR_ENTRIES - 1; i < children.size(); i++) {
+            fprintf(stderr, "nachosfs: salteo %s/%s: directorio lleno\n",
+                    hostPath.c_str(), children[i].name.c_str());
+        }
+        skipped += children.size() - (MAX_DIR_ENTRIES - 1);
+        children.resize(MAX_DIR_ENTRIES - 1);
+    }
+
+    // El contenido del directorio va pegado a su header; las entradas se
+    // escriben al final, cuando se conocen los headers de los hijos.
+    std::vector<DirectoryEntry> entries(children.size());
+    AllocateFile(img, alloc, header, entries.size() * sizeof (DirectoryEntry));
+
+    std::vector<char> data;
+    for (size_t i = 0; i < children.size(); i++) {
+        std::string path = hostPath + "/" + children[i].name;
+        DirectoryEntry &e = entries[i];
+        memset(&e, 0, sizeof e);
+        e.inUse  = true;
+        e.isDir  = children[i].isDir;
+        e.sector = AllocateSector(alloc);
+        strncpy(e.name, children[i].name.c_str(), FILE_NAME_MAX_LEN);
+
+        if (children[i].isDir) {
+            skipped += ImportDirectory(img, alloc, path, e.sector,
+                                       numFiles, numDirs);
+            numDirs++;
+        } else {
+            if (!ReadHostFile(path, data)) {
+                Fail("no se puede leer %s: %s", path.c_str(),
+                     strerror(errno));
+            }
+            if (data.size() > (size_t) MAX_FILE_SIZE * img.sectorsPerBlock) {
+                Fail("%s es demasiado grande", path.c_str());
+            }
+            AllocateFile(img, alloc, e.sector, data.size());
+            WriteAt(img, e.sector, data.data(), data.size(), 0);
+            numFiles++;
+        }
+    }
+    WriteAt(img, header, (const char *) entries.data(),
+            entries.size() * sizeof (DirectoryEntry), 0);
+    return skipped;
+}
+
+static int
+Mkfs(int argc, char **argv)
+{
+    if (argc < 2) {
+        Fail("uso: nachosfs mkfs DISK DIR [-geom S:T:N] [-bs N]");
+    }
+    const char *diskPath = argv[0];
+    const char *hostPath = argv[1];
+    unsigned sectorsPerTrack = SECTORS_PER_TRACK;
+    unsigned numTracks = NUM_TRACKS;
+    unsigned sectorsPerBlock = 1;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "-geom") && i + 1 < argc) {
+            unsigned sectorSize;
+            if (sscanf(argv[++i], "%u:%u:%u", &sectorSize,
+                       &sectorsPerTrack, &numTracks) != 3
+                  || sectorSize != SECTOR_SIZE
+                  || sectorsPerTrack == 0 || numTracks == 0) {
+                Fail("geometría inválida: %s", argv[i]);
+            }
+        } else if (!strcmp(argv[i], "-bs") && i + 1 < argc) {
+            sectorsPerBlock = atoi(argv[++i]);
+        } else {
+            Fail("opción desconocida: %s", argv[i]);
+        }
+    }
+    // Las mismas condiciones que `FileSystem` al formatear.
+    if ((sectorsPerBlock != 1 && sectorsPerBlock != 2
+           && sectorsPerBlock != 4 && sectorsPerBlock != 8)
+          || sectorsPerTrack % sectorsPerBlock != 0) {
+        Fail("tamaño de bloque inválido: %u", sectorsPerBlock);
+    }
+
+    Image img = CreateImage(diskPath, sectorsPerTrack, numTracks);
+    img.sectorsPerBlock = sectorsPerBlock;
+
+    Allocator alloc(img.numSectors);
+    alloc.Mark(FREE_MAP_SECTOR);
+    alloc.Mark(DIRECTORY_SECTOR);
+    alloc.Mark(SUPER_BLOCK_SECTOR);
+
+    unsigned freeMapSize
+      = DivRoundUp(img.numSectors, BITS_IN_WORD) * sizeof (unsigned);
+    RawSuperBlock *sb = (RawSuperBlock *) img.Sector(SUPER_BLOCK_SECTOR);
+    sb->magic           = SUPER_BLOCK_MAGIC;
+    sb->sectorSize      = SECTOR_SIZE;
+    sb->sectorsPerTrack = sectorsPerTrack;
+    sb->numTracks       = numTracks;
+    sb->numSectors      = img.numSectors;
+    sb->tracksPerGroup  = TRACKS_PER_GROUP;
+    sb->freeMapSize     = freeMapSize;
+    sb->sectorsPerBlock = sectorsPerBlock;
+
+    AllocateFile(img, alloc, FREE_MAP_SECTOR, freeMapSize);
+
+    unsigned numFiles = 0, numDirs = 0;
+    unsigned skipped = ImportDirectory(img, alloc, hostPath,
+                                       DIRECTORY_SECTOR, numFiles, numDirs);
+
+    // El bitmap se escribe último, cuando ya no se reservan más sectores.
+    SaveFreeMap(img, alloc);
+    CloseImage(img);
+
+    printf("%u archivos y %u directorios importados en %s "
+           "(%u sectores usados de %u).\n",
+           numFiles, numDirs, diskPath, alloc.NumMarked(), img.numSectors);
+    if (skipped > 0) {
+        printf("%u entradas salteadas.\n", skipped);
+    }
+    return skipped > 0 ? 1 : 0;
+}
+
+
+// `dump`: lista el árbol y opcionalmente lo extrae.
+
+static void
+DumpDirectory(const Image &img, unsigned header, const std::string &path,
+              const char *hostPath, std::vector<bool> &visited)
+{
+    for (const DirectoryEntry &e : ReadEntries(img, header)) {
+        std::string name = path + e.name;
+        if (!ValidEntry(img, &e) || !LooksLikeFile(img, e.sector)
+              || visited[e.sector]) {
+            printf("%-32s  (entrada inválida, header %u)\n",
+                   name.c_str(), e.sector);
+            continue;
+        }
+        visited[e.sector] = true;
+
+        std::string hostName = hostPath ? std::string(hostPath) + name : "";
+        if (e.isDir) {
+            printf("%-32s  %10s  header %u\n",
+                   (name + "/").c_str(), "directorio", e.sector);
+            if (hostPath && mkdir(hostName.c_str(), 0755) == -1
+                  && errno != EEXIST) {
+                Fail("no se puede crear %s: %s", hostName.c_str(),
+                     strerror(errno));
+            }
+            DumpDirectory(img, e.sector, name + "/", hostPath, visited);
+        } else {
+            printf("%-32s  %10u  header %u\n",
+                   name.c_str(), img.Header(e.sector)->numBytes, e.sector);
+            if (hostPath) {
+                std::vector<char> data = ReadFile(img, e.sector);
+                FILE *f = fopen(hostName.c_str(), "wb");
+                if (f == nullptr
+                      || fwrite(data.data(), 1, data.size(), f)
+                           != data.size()) {
+                    Fail("no se puede escribir %s", hostName.c_str());
+                }
+                fclose(f);
+            }
+        }
+    }
+}
+
+static int
+Dump(int argc, char **argv)
+{
+    if (argc < 1) {
+        Fail("uso: nachosfs dump DISK [DIR]");
+    }
+    Image img = OpenImage(argv[0], false);
+    const char *hostPath = argc > 1 ? argv[1] : nullptr;
+    if (hostPath && mkdir(hostPath, 0755) == -1 && errno != EEXIST) {
+        Fail("no se puede crear %s: %s", hostPath, strerror(errno));
+    }
+
+    printf("Disco de %u pistas de %u sectores, bloques de %u sectores%s.\n",
+           img.numTracks, img.sectorsPerTrack, img.sectorsPerBlock,
+           img.hasSuperBlock ? "" : " (sin superbloque)");
+    if (!LooksLikeFile(img, DIRECTORY_SECTOR)) {
+        Fail("el header del directorio raíz es inválido");
+    }
+    std::vector<bool> visited(img.numSectors);
+    visited[DIRECTORY_SECTOR] = true;
+    printf("%-32s  %10s  header %u\n", "/", "directorio", DIRECTORY_SECTOR);
+    DumpDirectory(img, DIRECTORY_SECTOR, "/", hostPath, visited);
+    CloseImage(img);
+    return 0;
+}
+
+
+// `check`: verificación de consistencia.
+
+/// Estado de la verificación.  `owner` guarda, para cada sector, el header
+/// del archivo que lo usa.
+struct Checker {
+    const Image &img;
+    std::vector<int> owner;
+    unsigned numErrors;
+    unsigned numWarnings;
+    unsigned numFiles;
+    unsigned numDirs;
+
+    Checker(const Image &i)
+      : img(i), owner(i.numSectors, -1),
+        numErrors(0), numWarnings(0), numFiles(0), numDirs(0)
+    {}
+
+    void Error(const char *format, ...)
+    {
+        va_list ap;
+        va_start(ap, format);
+        printf("error: ");
+        vprintf(format, ap);
+        printf("\n");
+        va_end(ap);
+        numErrors++;
+    }
+
+    void Warning(const char *format, ...)
+    {
+        va_list ap;
+        va_start(ap, format);
+        printf("aviso: ");
+        vprintf(format, ap);
+        printf("\n");
+        va_end(ap);
+        numWarnings++;
+    }
+
+    /// Registra que `count` sectores desde `sector` son de `header`.
+    bool Claim(unsigned sector, unsigned count, unsigned header,
+               const char *path, const char *what)
+    {
+        if (sector >= img.numSectors || count > img.numSectors - sector) {
+            Error("%s: %s en el sector %u, fuera del disco",
+                  path, what, sector);
+            return false;
+        }
+        bool ok = true;
+        for (unsigned s = sector; s < sector + count; s++) {
+            if (owner[s] != -1) {
+                Error("%s: %s en el sector %u, que ya usa el header %d",
+                      path, what, s, owner[s]);
+                ok = false;
+            } else {
+                owner[s] = header;
+            }
+        }
+        return ok;
+    }
+
+    /// Verifica el header de `header` y todos sus nodos y bloques.
+    bool CheckFile(unsigned header, const char *path)
+    {
+        if (!Claim(header, 1, header, path, "header")) {
+            return false;
+        }
+        const RawFileHeader *raw = img.Header(header);
+        unsigned spb = img.sectorsPerBlock;
+        if (raw->numSectors > NUM_INDIRECT * BLOCKS_PER_INDIRECT) {
+            Error("%s: %u bloques, más que el máximo", path, raw->numSectors);
+            return false;
+        }
+        if (raw->numBytes > (unsigned long) raw->numSectors * spb
+                              * SECTOR_SIZE) {
+            Error("%s: %u bytes no entran en %u bloques",
+                  path, raw->numBytes, raw->numSectors);
+        }
+
+        bool ok = true;
+        const RawIndirectNode *l1 = nullptr;
+        const RawIndirectNode *l2 = nullptr;
+        for (unsigned b = 0; b < raw->numSectors; b++) {
+            if (b % BLOCKS_PER_INDIRECT == 0) {
+                unsigned s = raw->dataSectors[b / BLOCKS_PER_INDIRECT];
+                if (!Claim(s, 1, header, path, "nodo indirecto")) {
+                    return false;
+                }
+                l1 = img.Node(s);
+            }
+            if (b % NUM_DIRECT == 0) {
+                unsigned s = l1->dataSectors[b / NUM_DIRECT % NUM_DIRECT];
+                if (!Claim(s, 1, header, path, "nodo indirecto")) {
+                    return false;
+                }
+                l2 = img.Node(s);
+            }
+            unsigned s = l2->dataSectors[b % NUM_DIRECT];
+            if (s % spb != 0) {
+                Error("%s: el bloque %u empieza en el sector %u, que no "
+                      "está alineado a %u", path, b, s, spb);
+                ok = false;
+            }
+            ok = Claim(s, spb, header, path, "bloque de datos") && ok;
+        }
+        return ok;
+    }
+
+    void CheckDirectory(unsigned header, const std::string &path)
+    {
+        numDirs++;
+        if (!LooksLikeFile(img, header)) {
+            return;  // El error ya lo informó `CheckFile`.
+        }
+        for (const DirectoryEntry &e : ReadEntries(img, header)) {
+            std::string name = path + e.name;
+            if (!ValidEntry(img, &e)) {
+                Error("%s: entrada inválida (header %u)",
+                      (path + "?").c_str(), e.sector);
+                continue;
+            }
+            if (owner[e.sector] != -1) {
+                Error("%s: el header %u ya lo usa el header %d",
+                      name.c_str(), e.sector, owner[e.sector]);
+                continue;
+            }
+            if (!CheckFile(e.sector, name.c_str())) {
+                continue;
+            }
+            if (e.isDir) {
+                CheckDirectory(e.sector, name + "/");
+            } else {
+                numFiles++;
+            }
+        }
+    }
+};
+
+static int
+Check(int argc, char **argv)
+{
+    if (argc < 1) {
+        Fail("uso: nachosfs check DISK");
+    }
+    Image img = OpenImage(argv[0], false);
+    Checker c(img);
+
+    unsigned freeMapSize
+      = DivRoundUp(img.numSectors, BITS_IN_WORD) * sizeof (unsigned);
+    if (img.hasSuperBlock) {
+        const RawSuperBlock *sb
+          = (const RawSuperBlock *) img.Sector(SUPER_BLOCK_SECTOR);
+        if (sb->sectorSize != SECTOR_SIZE
+              || sb->sectorsPerTrack != img.sectorsPerTrack
+              || sb->numTracks != img.numTracks
+              || sb->numSectors != img.numSectors) {
+            c.Error("la geometría del superbloque no coincide con la del "
+                    "disco");
+        }
+        if (sb->freeMapSize != freeMapSize) {
+            c.Error("el superbloque dice que el bitmap ocupa %u bytes, "
+                    "deberían ser %u", sb->freeMapSize, freeMapSize);
+        }
+        unsigned spb = img.sectorsPerBlock;
+        if ((spb != 1 && spb != 2 && spb != 4 && spb != 8)
+              || img.sectorsPerTrack % spb != 0) {
+            c.Error("tamaño de bloque inválido: %u sectores", spb);
+            CloseImage(img);
+            return 1;
+        }
+        c.owner[SUPER_BLOCK_SECTOR] = SUPER_BLOCK_SECTOR;
+    }
+
+    // El bitmap y el directorio raíz.
+    if (!c.CheckFile(FREE_MAP_SECTOR, "[bitmap]")) {
+        printf("El header del bitmap es inválido; no sigo.\n");
+        CloseImage(img);
+        return 1;
+    }
+    if (img.Header(FREE_MAP_SECTOR)->numBytes != freeMapSize) {
+        c.Error("[bitmap]: %u bytes, deberían ser %u",
+                img.Header(FREE_MAP_SECTOR)->numBytes, freeMapSize);
+    }
+    if (c.CheckFile(DIRECTORY_SECTOR, "/")) {
+        c.CheckDirectory(DIRECTORY_SECTOR, "/");
+    }
+
+    // Cruzo los sectores usados contra el bitmap.
+    if (!LooksLikeFile(img, FREE_MAP_SECTOR)) {
+        printf("No se puede leer el bitmap; no sigo.\n");
+        CloseImage(img);
+        return 1;
+    }
+    std::vector<char> bitmap = ReadFile(img, FREE_MAP_SECTOR);
+    bitmap.resize(freeMapSize);
+    const unsigned *words = (const unsigned *) bitmap.data();
+    unsigned numUsed = 0;
+    for (unsigned s = 0; s < img.numSectors; s++) {
+        bool marked = words[s / BITS_IN_WORD] & (1u << s % BITS_IN_WORD);
+        bool used = c.owner[s] != -1;
+        if (marked) {
+            numUsed++;
+        }
+        if (used && !marked) {
+            c.Error("el sector %u lo usa el header %d pero está libre en el "
+                    "bitmap", s, c.owner[s]);
+        } else if (marked && !used) {
+            c.Warning("el sector %u está marcado en el bitmap pero no lo "
+                      "usa ningún archivo", s);
+        }
+    }
+
+    printf("%u archivos, %u directorios, %u sectores usados de %u.\n",
+           c.numFiles, c.numDirs, numUsed, img.numSectors);
+    printf("%u errores, %u avisos.\n", c.numErrors, c.numWarnings);
+    CloseImage(img);
+    return c.numErrors > 0 ? 1 : 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    if (argc >= 2 && !strcmp(argv[1], "mkfs")) {
+        return Mkfs(argc - 2, argv + 2);
+    } else if (argc >= 2 && !strcmp(argv[1], "dump")) {
+        return Dump(argc - 2, argv + 2);
+    } else if (argc >= 2 && !strcmp(argv[1], "check")) {
+        return Check(argc - 2, argv + 2);
+    }
+    fprintf(stderr,
+            "Usage: %s mkfs DISK DIR [-geom S:T:N] [-bs N]\n"
+            "       %s dump DISK [DIR]\n"
+            "       %s check DISK\n", argv[0], argv[0], argv[0]);
+    return 1;
+}
@@ -0,0 +1,276 @@
+/// Rutinas del desfragmentador.
+///
+/// Ver `defragmenter.hh`.
+
+
+#include "defragmenter.hh"
+#include "directory.hh"
+#include "file_header.hh"
+#include "threads/condition.hh"
+#include "threads/lock.hh"
+#include "threads/system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+
+unsigned
+FragStats::Percent() const
+{
+    if (blocks <= files) {
+        return 0;
+    }
+    return (fragments - files) * 100 / (blocks - files);
+}
+
+Defragmenter::Defragmenter()
+{
+    lock    = new Lock("DefragLock");
+    changed = new Condition("DefragChanged", lock);
+    pending = false;
+    started = false;
+}
+
+Defragmenter::~Defragmenter()
+{
+    delete changed;
+    delete lock;
+}
+
+FragStats
+Defragmenter::Measure()
+{
+    FragStats frag;
+    memset(&frag, 0, sizeof frag);
+    Walk("root", false, false, &frag);
+    frag.freeRuns = fileSystem->GetFreeMap()->CountFreeRuns();
+    return frag;
+}
+
+static void
+PrintStats(const char *title, const FragStats &frag)
+{
+    printf("%s: %u archivos, %u bloques en %u fragmentos (%u%%), "
+           "espacio libre en %u tiras.\n",
+           title, frag.files, frag.blocks, frag.fragments,
+           frag.Percent(), frag.freeRuns);
+}
+
+void
+Defragmenter::Run(bool compact)
+{
+    FragStats before = Measure();
+    PrintStats("Antes", before);
+
+    FragStats pass;
+    memset(&pass, 0, sizeof pass);
+    Walk("root", true, compact, &pass);
+
+    FragStats after = Measure();
+    PrintStats("Después", after);
+    printf("Archivos movidos: %u.\n", pass.moved);
+}
+
+void
+Defragmenter::Start()
+{
+    ASSERT(!started);
+    started = true;
+    Thread *worker = new Thread("Defragmenter", false, 0);
+    // Es un thread del kernel: comparte el pid de quien lo crea, así no
+    // cuenta como un proceso más en la `space_table`.
+    worker->SetPid(currentThread->GetPid());
+    worker->Fork(Worker, this);
+}
+
+void
+Defragmenter::Notify()
+{
+    if (!started) {
+        return;
+    }
+    lock->Acquire();
+    pending = true;
+    changed->Signal();
+    lock->Release();
+}
+
+void
+Defragmenter::Worker(void *arg)
+{
+    Defragmenter *defrag = (Defragmenter *) arg;
+    ASSERT(defrag != nullptr);
+
+    for (;;) {
+        defrag->lock->Acquire();
+        while (!defrag->pending) {
+            defrag->changed->Wait();
+        }
+        defrag->pending = false;
+        defrag->lock->Release();
+
+        FragStats frag = defrag->Measure();
+        DEBUG('f', "Fragmentación: %u%%.\n", frag.Percent());
+        if (frag.Percent() >= DEFRAG_THRESHOLD) {
+            memset(&frag, 0, sizeof frag);
+            defrag->Walk("root", true, false, &frag);
+            DEBUG('f', "Desfragmentador: %u archivos movidos.\n",
+                  frag.moved);
+        }
+    }
+}
+
+/// Si el directorio `name` de la `dirTable` es el que tiene su header en
+/// `sector`.
+static bool
+IsLoadedDir(const char *name, unsigned sector)
+{
+    return dirTable->CheckDirInTable(name) != -1
+             && dirTable->GetDir(name)->GetSector() == sector;
+}
+
+void
+Defragmenter::Walk(const char *dirName, bool relocate, bool compact,
+                   FragStats *frag)
+{
+    ASSERT(dirName != nullptr);
+    ASSERT(frag != nullptr);
+
+    if (dirTable->CheckDirInTable(dirName) == -1
+          || dirTable->getToDelete(dirName)) {
+        return;
+    }
+
+    dirTable->DirLock(dirName, ACQUIRE);
+    OpenFile *dirFile = dirTable->GetDir(dirName);
+    Directory *dir = new Directory(dirTable->GetNumEntries(dirName));
+    dir->FetchFrom(dirFile);
+    const RawDirectory *raw = dir->GetRaw();
+
+    // Los subdirectorios cargados se recorren después, cada uno con su
+    // propio lock.
+    List<char *> subdirs;
+    for (unsigned i = 0; i < raw->tableSize; i++) {
+        const DirectoryEntry *e = &raw->table[i];
+        if (!e->inUse) {
+            continue;
+        }
+        if (IsLoadedDir(e->name, e->sector)) {
+            char *name = new char [FILE_NAME_MAX_LEN + 1];
+            strcpy(name, e->name);
+            subdirs.Append(name);
+        } else {
+            Visit(e->name, e->sector, relocate, compact, frag);
+        }
+    }
+    // El archivo del directorio mismo.
+    Visit(dirName, dirFile->GetSector(), relocate, compact, frag);
+    dirTable->DirLock(dirName, RELEASE);
+    delete dir;
+
+    while (!subdirs.IsEmpty()) {
+        char *name = subdirs.Pop();
+        Walk(name, relocate, compact, frag);
+        delete [] name;
+    }
+}
+
+/// Si `name` está abierto en la `fileTable` y es el archivo con header en
+/// `sector`.
+static bool
+IsOpenFile(const char *name, unsigned sector)
+{
+    return fileTable->CheckFileInTable(name) != -1
+             && !fileTable->GetClosed(name)
+             && !fileTable->isDeleted(name)
+             && fileTable->GetFile(name)->GetSector() == sector;
+}
+
+void
+Defragmenter::Visit(const char *name, unsigned sector, bool relocate,
+                    bool compact, FragStats *frag)
+{
+    // Un archivo abierto se toma con el lock de abrir y borrar, así no se
+    // cierra mientras tanto, y como escritor, así nadie lo lee ni lo
+    // escribe.
+    bool open = IsOpenFile(name, sector);
+    if (open) {
+        fileTable->FileORLock(name, ACQUIRE);
+        if (!IsOpenFile(name, sector)) {
+            fileTable->FileORLock(name, RELEASE);
+            return;
+        }
+        fileTable->BeginWrite(name);
+    }
+
+    FileHeader *hdr = new FileHeader;
+    hdr->FetchFrom(sector);
+    unsigned numBlocks = hdr->GetRaw()->numSectors;
+    unsigned sectorsPerBlock = FileHeader::GetSectorsPerBlock();
+
+    unsigned fragments = numBlocks > 0 ? 1 : 0;
+    for (unsigned b = 1; b < numBlocks; b++) {
+        if (hdr->GetBlockSector(b)
+              != hdr->GetBlockSector(b - 1) + sectorsPerBlock) {
+            fragments++;
+        }
+    }
+    if (numBlocks > 0) {
+        frag->files++;
+        frag->blocks += numBlocks;
+        frag->fragments += fragments;
+    }
+
+    FreeMap *freeMap = fileSystem->GetFreeMap();
+    int target = -1;
+    if (relocate && fragments > 1) {
+        target = freeMap->FindRun(numBlocks * sectorsPerBlock,
+                                  sectorsPerBlock,
+                                  fileSystem->GetNumSectors());
+    } else if (relocate && compact && fragments == 1) {
+        target = freeMap->FindRun(numBlocks * sectorsPerBlock,
+                                  sectorsPerBlock, hdr->GetBlockSector(0));
+    }
+
+    if (target != -1) {
+        DEBUG('f', "Muevo los %u bloques de %s al sector %d.\n",
+              numBlocks, name, target);
+
+        // Primero se copian los datos, después se cambian los punteros y
+        // recién al final se liberan los bloques viejos.
+        unsigned *old = new unsigned [numBlocks];
+        char *buffer = new char [FileHeader::GetBlockSize()];
+        for (unsigned b = 0; b < numBlocks; b++) {
+            unsigned to = target + b * sectorsPerBlock;
+            old[b] = hdr->GetBlockSector(b);
+            synchDisk->ReadSectors(old[b], sectorsPerBlock, buffer);
+            synchDisk->WriteSectors(to, sectorsPerBlock, buffer);
+            hdr->SetBlockSector(b, to);
+        }
+        hdr->WriteBack(sector);
+
+        for (unsigned b = 0; b < numBlocks; b++) {
+            for (unsigned n = 0; n < sectorsPerBlock; n++) {
+                freeMap->Clear(old[b] + n);
+            }
+        }
+        freeMap->WriteBack(fileTable->GetFile("freeMap"));
+        delete [] buffer;
+        delete [] old;
+        frag->moved++;
+
+        // Los `OpenFile` del archivo tienen los punteros viejos en memoria.
+        if (open) {
+            fileTable->GetFile(name)->GetFileHeader()->FetchFrom(sector);
+        }
+        if (IsLoadedDir(name, sector)) {
+            dirTable->GetDir(name)->GetFileHeader()->FetchFrom(sector);
+        }
+    }
+    delete hdr;
+
+    if (open) {
+        fileTable->EndWrite(name);
+        fileTable->FileORLock(name, RELEASE);
+    }
+}
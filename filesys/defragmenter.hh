@@ -0,0 +1,105 @@
+/// Desfragmentador del sistema de archivos.
+///
+/// Con el tiempo, los archivos que crecen con `FileHeader::AddSectors` y
+/// los que se borran dejan los datos de cada archivo repartidos por el
+/// disco.  El desfragmentador recorre los directorios cargados en la
+/// `dirTable` (siempre está `root`) y mueve los bloques de datos de cada
+/// archivo fragmentado a una tira contigua de sectores libres.  Los
+/// headers y los nodos de indirección quedan donde están; sólo cambian los
+/// punteros de los nodos.
+///
+/// Un archivo se mueve con el lock de su directorio tomado, así nadie lo
+/// crea, lo abre ni lo borra mientras tanto.  Si está abierto se toma
+/// además como escritor (`FileTable::BeginWrite`), y al terminar se
+/// vuelven a leer los headers que tienen en memoria sus `OpenFile`.  Los
+/// datos se copian antes de cambiar los punteros y los bloques viejos se
+/// liberan al final, así que en ningún momento un puntero lleva a datos
+/// inválidos.
+///
+/// Se usa de dos formas:
+///
+/// * `nachos -defrag` hace una pasada completa y además compacta el
+///   espacio libre, moviendo cada archivo a la primera tira que le alcance
+///   si está antes que la actual.
+/// * Con `-defragd` corre un thread del kernel de prioridad mínima que se
+///   despierta cada vez que se borra un archivo y desfragmenta si la
+///   fragmentación pasa de `DEFRAG_THRESHOLD`.
+
+#ifndef NACHOS_FILESYS_DEFRAGMENTER__HH
+#define NACHOS_FILESYS_DEFRAGMENTER__HH
+
+
+class Lock;
+class Condition;
+
+
+/// Porcentaje de fragmentación a partir del cual el thread de fondo
+/// desfragmenta.
+static const unsigned DEFRAG_THRESHOLD = 10;
+
+
+/// Medida de la fragmentación.  Un fragmento es una tira de bloques de un
+/// archivo que están seguidos en el disco; un archivo sin fragmentar tiene
+/// uno solo.
+struct FragStats {
+    unsigned files;      ///< Archivos con datos.
+    unsigned blocks;     ///< Bloques de datos en total.
+    unsigned fragments;  ///< Fragmentos en total.
+    unsigned freeRuns;   ///< Tiras de sectores libres.
+    unsigned moved;      ///< Archivos movidos en la pasada.
+
+    /// Porcentaje de bloques que no siguen al anterior de su archivo.
+    unsigned Percent() const;
+};
+
+
+class Defragmenter {
+public:
+
+    Defragmenter();
+
+    ~Defragmenter();
+
+    /// Hace una pasada e imprime la fragmentación antes y después.  Con
+    /// `compact` también mueve archivos contiguos hacia el comienzo del
+    /// disco.
+    void Run(bool compact);
+
+    /// Crea el thread de fondo.
+    void Start();
+
+    /// Avisa al thread de fondo que algo cambió en el disco.
+    void Notify();
+
+    /// Mide la fragmentación sin mover nada.
+    FragStats Measure();
+
+private:
+
+    /// Recorre el directorio `dirName` y sus subdirectorios cargados.  Si
+    /// `relocate`, mueve los archivos fragmentados (y con `compact` los
+    /// que tengan lugar más adelante).
+    void Walk(const char *dirName, bool relocate, bool compact,
+              FragStats *frag);
+
+    /// Mide y, si hace falta, mueve un archivo.  Se llama con el lock del
+    /// directorio que lo contiene tomado.
+    void Visit(const char *name, unsigned sector, bool relocate,
+               bool compact, FragStats *frag);
+
+    /// Cuerpo del thread de fondo.
+    static void Worker(void *arg);
+
+    Lock *lock;
+
+    /// Se señala en `Notify`.
+    Condition *changed;
+
+    /// Si hubo cambios desde la última pasada del thread de fondo.
+    bool pending;
+
+    bool started;
+};
+
+
+#endif
@@ -25,6 +25,8 @@
 #include "file_header.hh"
 #include "lib/utility.hh"
 
+#include <algorithm>
+
 #include <stdio.h>
 #include <string.h>
 
@@ -60,14 +62,12 @@ Directory::FetchFrom(OpenFile *file)
     file->ReadAt((char *) raw.table,
                 raw.tableSize * sizeof (DirectoryEntry), 0);
     
-    if (raw.tableSize < NUM_SECTORS){
-        DEBUG('f', "Traje el directorio el cual tiene %u entradas\n", raw.tableSize);
-        DEBUG('f', "Entradas:\n");
-        for (unsigned i = 0; i < raw.tableSize; i++){
-            DEBUG('f', "Archivo %s\n", raw.table[i].name);
-            DEBUG('f', "Sector del header: %u\n", raw.table[i].sector);
-            DEBUG('f', "En uso: %u\n", raw.table[i].inUse);
-        }
+    DEBUG('f', "Traje el directorio el cual tiene %u entradas\n", raw.tableSize);
+    DEBUG('f', "Entradas:\n");
+    for (unsigned i = 0; i < raw.tableSize; i++){
+        DEBUG('f', "Archivo %s\n", raw.table[i].name);
+        DEBUG('f', "Sector del header: %u\n", raw.table[i].sector);
+        DEBUG('f', "En uso: %u\n", raw.table[i].inUse);
     }
 }
 
@@ -81,14 +81,12 @@ Directory::WriteBack(OpenFile *file)
     file->WriteAt((char *) raw.table,
                   raw.tableSize * sizeof (DirectoryEntry), 0);
     
-    if (raw.tableSize < NUM_SECTORS){
-        DEBUG('f', "Guardé el directorio el cual tiene %u entradas\n", raw.tableSize);
-        DEBUG('f', "Entradas:\n");
-        for (unsigned i = 0; i < raw.tableSize; i++){
-            DEBUG('f', "Archivo %s\n", raw.table[i].name);
-            DEBUG('f', "Sector del header: %u\n", raw.table[i].sector);
-            DEBUG('f', "En uso: %u\n", raw.table[i].inUse);
-        }
+    DEBUG('f', "Guardé el directorio el cual tiene %u entradas\n", raw.tableSize);
+    DEBUG('f', "Entradas:\n");
+    for (unsigned i = 0; i < raw.tableSize; i++){
+        DEBUG('f', "Archivo %s\n", raw.table[i].name);
+        DEBUG('f', "Sector del header: %u\n", raw.table[i].sector);
+        DEBUG('f', "En uso: %u\n", raw.table[i].inUse);
     }
     
 }
@@ -135,8 +133,9 @@ Directory::Find(const char *name)
 ///
 /// * `name` is the name of the file being added.
 /// * `newSector` is the disk sector containing the added file's header.
+/// * `isDir` es si el archivo agregado es un directorio.
 bool
-Directory::Add(const char *name, int newSector)
+Directory::Add(const char *name, int newSector, bool isDir)
 {
     DEBUG('f', "Añadiendo el archivo %s al directorio\n", name);
     ASSERT(name != nullptr);
@@ -158,6 +157,7 @@ Directory::Add(const char *name, int newSector)
     
     // Agregamos el nuevo archivo:
     newTable[raw.tableSize].inUse = true;
+    newTable[raw.tableSize].isDir = isDir;
     strncpy(newTable[raw.tableSize].name, name, strlen(name) + 1);
     newTable[raw.tableSize].sector = newSector;
 
@@ -252,3 +252,63 @@ Directory::GetRaw() const
 {
     return &raw;
 }
+
+DirectoryIterator::DirectoryIterator(OpenFile *dirFile, unsigned entries)
+{
+    ASSERT(dirFile != nullptr);
+
+    file = dirFile;
+    numEntries = std::min(entries,
+                          (unsigned) (file->Length() / sizeof (DirectoryEntry)));
+    next = 0;
+    buffer = new char [FileHeader::GetBlockSize()];
+    bufferStart = 0;
+    bufferLength = 0;
+}
+
+DirectoryIterator::~DirectoryIterator()
+{
+    delete [] buffer;
+}
+
+bool
+DirectoryIterator::Fill(unsigned position)
+{
+    unsigned blockSize = FileHeader::GetBlockSize();
+    unsigned fileLength = file->Length();
+    if (position >= fileLength) {
+        return false;
+    }
+    bufferStart = DivRoundDown(position, blockSize) * blockSize;
+    bufferLength = std::min(blockSize, fileLength - bufferStart);
+    file->ReadAt(buffer, bufferLength, bufferStart);
+    return true;
+}
+
+bool
+DirectoryIterator::Next(DirectoryEntry *entry)
+{
+    ASSERT(entry != nullptr);
+
+    if (next >= numEntries) {
+        return false;
+    }
+
+    // Una entrada puede quedar partida entre dos bloques.
+    unsigned position = next * sizeof (DirectoryEntry);
+    unsigned copied = 0;
+    while (copied < sizeof (DirectoryEntry)) {
+        unsigned at = position + copied;
+        if (at < bufferStart || at >= bufferStart + bufferLength) {
+            if (!Fill(at)) {
+                return false;
+            }
+        }
+        unsigned count = std::min((unsigned) sizeof (DirectoryEntry) - copied,
+                                  bufferStart + bufferLength - at);
+        memcpy((char *) entry + copied, &buffer[at - bufferStart], count);
+        copied += count;
+    }
+    next++;
+    return true;
+}
@@ -46,8 +46,9 @@ public:
     /// Find the sector number of the `FileHeader` for file: `name`.
     int Find(const char *name);
 
-    /// Add a file name into the directory.
-    bool Add(const char *name, int newSector);
+    /// Add a file name into the directory.  `isDir` marca los
+    /// subdirectorios.
+    bool Add(const char *name, int newSector, bool isDir = false);
 
     /// Remove a file from the directory.
     bool Remove(const char *name);
@@ -73,4 +74,44 @@ private:
 };
 
 
+/// Recorre las entradas de un directorio en disco sin traer la tabla
+/// entera: lee el archivo de a un bloque, a través de la caché, y copia
+/// una entrada por vez.  Así listar o contar un directorio grande usa
+/// siempre la misma memoria.
+///
+/// Como el resto de la clase `Directory`, supone que el que llama tiene
+/// el lock del directorio.
+class DirectoryIterator {
+public:
+
+    /// Recorre las primeras `numEntries` entradas de `file`, o todas las
+    /// que tenga el archivo si son menos.
+    DirectoryIterator(OpenFile *file, unsigned numEntries);
+
+    ~DirectoryIterator();
+
+    /// Copia en `entry` la siguiente entrada, esté en uso o no.  Devuelve
+    /// falso cuando no quedan más.
+    bool Next(DirectoryEntry *entry);
+
+private:
+
+    /// Trae el bloque del archivo que contiene el byte `position`.
+    /// Devuelve falso si está más allá del final.
+    bool Fill(unsigned position);
+
+    OpenFile *file;
+    unsigned numEntries;
+
+    /// Índice de la próxima entrada.
+    unsigned next;
+
+    /// El bloque leído, que empieza en el byte `bufferStart` del archivo y
+    /// tiene `bufferLength` bytes válidos.
+    char *buffer;
+    unsigned bufferStart;
+    unsigned bufferLength;
+};
+
+
 #endif
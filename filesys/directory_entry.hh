@@ -21,6 +21,10 @@ class DirectoryEntry {
 public:
     /// Is this directory entry in use?
     bool inUse;
+    /// Si la entrada es un subdirectorio.  Lo fija `MkDir`; el kernel
+    /// no lo necesita, pero sin él las herramientas de `bin/` no pueden
+    /// distinguir un directorio vacío de un archivo vacío.
+    bool isDir;
     /// Location on disk to find the `FileHeader` for this file. -> 'FileHeader' es i-nodo.
     /// Es la ubicación en el disco para encontrar el i-nodo ya que en NachOS es 1:1, no tenemos tabla de i-nodos.
     /// Cada i-nodo entra en exactamente 1 sector. Tienen el mismo tamaño.
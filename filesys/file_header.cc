@@ -37,64 +37,59 @@
 #include <stdio.h>
 
 
+unsigned FileHeader::sectorsPerBlock = 1;
+
+void
+FileHeader::SetSectorsPerBlock(unsigned n)
+{
+    ASSERT(n == 1 || n == 2 || n == 4 || n == 8);
+    sectorsPerBlock = n;
+}
+
+unsigned
+FileHeader::GetSectorsPerBlock()
+{
+    return sectorsPerBlock;
+}
+
+unsigned
+FileHeader::GetBlockSize()
+{
+    return sectorsPerBlock * SECTOR_SIZE;
+}
+
 /// Initialize a fresh file header for a newly created file.  Allocate data
 /// blocks for the file out of the map of free disk blocks.  Return false if
 /// there are not enough free blocks to accomodate the new file.
 ///
 /// * `freeMap` is the bit map of free disk sectors.
 /// * `fileSize` is the bit map of free disk sectors.
+/// * `goal` es el sector a partir del cual buscar lugar.  Cada indirección
+///   se ubica justo antes de los datos que mapea.
 bool
-FileHeader::Allocate(Bitmap *freeMap, unsigned fileSize)
+FileHeader::Allocate(FreeMap *freeMap, unsigned fileSize, unsigned goal)
 {
 
     ASSERT(freeMap != nullptr);
     
     // Con doble indirección MAX_FILE_SIZE es DISK_SIZE.
-    if (fileSize > MAX_FILE_SIZE) {
+    if (fileSize > MAX_FILE_SIZE * sectorsPerBlock) {
         return false;
     }
 
     raw.numBytes = fileSize;
-    raw.numSectors = DivRoundUp(fileSize, SECTOR_SIZE);
-    
-    unsigned cantIndirects1 = DivRoundUp(raw.numSectors, NUM_DIRECT*NUM_DIRECT);
-    unsigned cantIndirects2 = DivRoundUp(raw.numSectors, NUM_DIRECT);
-    unsigned cantIndirectsTotal = cantIndirects1 + cantIndirects2;
-    if (freeMap->CountClear() < raw.numSectors + cantIndirectsTotal) {
-        return false;  // Not enough space.
-    }
-    
-    DEBUG('f', "Hay espacio para %u sectores\n", raw.numSectors);
-    DEBUG('f', "En el bitmap hay disponibles %u sectores\n", freeMap->CountClear());
-
-    // Para ejercicio 2:
-    // Ahora tengo NUM_INDIRECT punteros que pueden 
-    // contener NUM_DIRECT punteros los cuales cada uno de ellos
-    // contiene NUM_DIRECT sectores.
-    
-
-    unsigned sectorsLeft = raw.numSectors;
+    raw.numSectors = 0;
 
-    
-    for (unsigned i = 0; (i < NUM_INDIRECT && sectorsLeft > 0); i++)
-    {
-        ASSERT((int)(raw.dataSectors[i] = freeMap->Find()) != -1);
-        DEBUG('f', "El sector de la 1er indirección es: %u\n", raw.dataSectors[i]);
-        for (unsigned j = 0; (j < NUM_DIRECT && sectorsLeft > 0); j++)
-        {
-            ASSERT((int)(raw_ind[i].dataSectors[j] = freeMap->Find()) != -1);
-            DEBUG('f', "El sector de la 2da indirección es: %u\n", raw_ind[i].dataSectors[j]);
-            for (unsigned k = 0; k < NUM_DIRECT && sectorsLeft > 0; k++)
-            {
-                ASSERT((int)(raw_ind2[i][j].dataSectors[k] = freeMap->Find()) != -1);
-                DEBUG('f', "El sector directo es: %u\n", raw_ind2[i][j].dataSectors[k]);
-                sectorsLeft -= 1;
-                DEBUG('f', "Sectores allocados: %u\n", raw.numSectors - sectorsLeft);
-                DEBUG('f', "Espacio en bitmap: %u\n", freeMap->CountClear());
-            }
-        }
+    // Cada sector se busca a continuación del anterior, así la indirección
+    // queda pegada a los datos que mapea.
+    if (!AllocateBlocks(freeMap, DivRoundUp(fileSize, GetBlockSize()),
+                        goal)) {
+        raw.numBytes = 0;
+        return false;  // Not enough space.
     }
 
+    DEBUG('f', "Bloques allocados: %u\n", raw.numSectors);
+    DEBUG('f', "Espacio en bitmap: %u\n", freeMap->CountClear());
     return true;
 }
 
@@ -103,7 +98,7 @@ FileHeader::Allocate(Bitmap *freeMap, unsigned fileSize)
 /// * `freeMap` is the bit map of free disk sectors.
 /// Su concurrencia viene dada por Remove de file_system.cc.
 void
-FileHeader::Deallocate(Bitmap *freeMap)
+FileHeader::Deallocate(FreeMap *freeMap)
 {
     // Elimina solo los datos. No el header.
     ASSERT(freeMap != nullptr);
@@ -120,8 +115,10 @@ FileHeader::Deallocate(Bitmap *freeMap)
             synchDisk->ReadSector(raw_ind[i].dataSectors[j], (char*) &raw_ind2[i][j]);
             for (unsigned k = 0; k < NUM_DIRECT && sectorsLeft > 0; k++)
             {
-                ASSERT(freeMap->Test(raw_ind2[i][j].dataSectors[k]));
-                freeMap->Clear(raw_ind2[i][j].dataSectors[k]);
+                for (unsigned n = 0; n < sectorsPerBlock; n++) {
+                    ASSERT(freeMap->Test(raw_ind2[i][j].dataSectors[k] + n));
+                    freeMap->Clear(raw_ind2[i][j].dataSectors[k] + n);
+                }
                 sectorsLeft -= 1;
             }
             ASSERT(freeMap->Test(raw_ind[i].dataSectors[j]));
@@ -133,29 +130,6 @@ FileHeader::Deallocate(Bitmap *freeMap)
    return; 
 }
 
-char*
-FileHeader::GetEntireFile()
-{
-    char all[raw.numSectors*SECTOR_SIZE];
-
-    unsigned sectorsLeft = raw.numSectors;
-    unsigned place = 0;
-    for(unsigned i = 0; i < NUM_INDIRECT && sectorsLeft > 0; i++){
-        for(unsigned j = 0; j < NUM_DIRECT && sectorsLeft > 0; j++){
-            for(unsigned k = 0; k < NUM_DIRECT && sectorsLeft > 0; k++){
-                synchDisk->ReadSector(raw_ind2[i][j].dataSectors[k], (char *) (all + place));
-                place += SECTOR_SIZE;
-                sectorsLeft -= 1;
-            }
-        }
-    }
-
-    char* to = new char[raw.numBytes];
-    for(unsigned i = 0; i < raw.numBytes; i++)
-        to[i] = all[i];
-
-    return to;
-}
 /// Fetch contents of file header from disk.
 ///
 /// * `sector` is the disk sector containing the file header.
@@ -173,7 +147,7 @@ FileHeader::FetchFrom(unsigned sector)
 
     for (unsigned i = 0; i < cantIndirects1; i++){
         synchDisk->ReadSector(raw.dataSectors[i], (char *) &raw_ind[i]);
-        for (unsigned j = 0; j < cantIndirects2; j++){
+        for (unsigned j = 0; j < cantIndirects2 - i * NUM_DIRECT && j < NUM_DIRECT; j++){
             synchDisk->ReadSector(raw_ind[i].dataSectors[j], (char *) &raw_ind2[i][j]);
         }
     }
@@ -198,7 +172,7 @@ FileHeader::WriteBack(unsigned sector)
     
     for (unsigned i = 0; i < cantIndirects1; i++){
         synchDisk->WriteSector(raw.dataSectors[i], (char *) &raw_ind[i]);
-        for (unsigned j = 0; j < cantIndirects2; j++){
+        for (unsigned j = 0; j < cantIndirects2 - i * NUM_DIRECT && j < NUM_DIRECT; j++){
             synchDisk->WriteSector(raw_ind[i].dataSectors[j], (char*) &raw_ind2[i][j]);
         }
     }
@@ -217,15 +191,14 @@ FileHeader::ByteToSector(unsigned offset)
 {
     DEBUG('f', "Trayendo el byte %u\n", offset);
     DEBUG('f', "La cantidad de sectores es: %u\n", raw.numSectors);
-    unsigned numDirect = offset / SECTOR_SIZE;
+    unsigned numDirect = offset / GetBlockSize();
     
     DEBUG('f', "El byte está en el directo %u\n", numDirect);
 
-    unsigned cantIndirects1 = DivRoundUp(raw.numSectors, NUM_DIRECT*NUM_DIRECT);
-    unsigned cantIndirects2 = DivRoundUp(raw.numSectors, NUM_DIRECT);
-    
-    unsigned indirecLevel1 = cantIndirects1 == 0 ? 0 : numDirect % cantIndirects1;
-    unsigned indirecLevel2 = cantIndirects2 == 0 ? 0 : numDirect % cantIndirects2;
+    // Cada nodo del primer nivel cubre NUM_DIRECT * NUM_DIRECT sectores y
+    // cada uno del segundo nivel NUM_DIRECT.
+    unsigned indirecLevel1 = numDirect / (NUM_DIRECT * NUM_DIRECT);
+    unsigned indirecLevel2 = numDirect / NUM_DIRECT % NUM_DIRECT;
     
     DEBUG('f', "El primer nivel de indirección es %u\n", indirecLevel1);
     DEBUG('f', "El segundo nivel de indirección es %u\n", indirecLevel2);
@@ -248,15 +221,14 @@ FileHeader::ByteToSector(unsigned offset)
 bool
 FileHeader::AddSectors(unsigned sector, unsigned addSectors, unsigned addBytes)
 {
-    Bitmap *freeMap = new Bitmap(NUM_SECTORS);
-    freeMap->FetchFrom(fileTable->GetFile("freeMap"));
+    FreeMap *freeMap = fileSystem->GetFreeMap();
 
     // Primero traigo el fileHeader.
     //FetchFrom(sector);
     
     DEBUG('f', "Voy a agregar sectores\n");
 
-    if (raw.numBytes + addBytes > MAX_FILE_SIZE){
+    if (raw.numBytes + addBytes > MAX_FILE_SIZE * sectorsPerBlock){
         DEBUG('f', "No es posible agregar más contenido al archivo.\n");
         return false;
     }
@@ -272,64 +244,228 @@ FileHeader::AddSectors(unsigned sector, unsigned addSectors, unsigned addBytes)
         return false;
     }
 
-    if (raw.numSectors + newSectors > freeMap->CountClear()){
-        DEBUG('f', "No es posible agregar más sectores a este archivo.\n");
-        return false;
-    }
-
     // Tengo que calcular cuál es el último direct utilizado para agregar sectores
     // a partir de ahí.
     // Si bien la información está toda separada en el disco, dentro del fileHeader 
     // sigue un orden y gracias a esto podemos decir que el primer direct va a contener
     // los primeros bytes y el último, los últimos.
     
-    unsigned numDirect = raw.numSectors;
-
-    unsigned cantIndirects1 = DivRoundUp(raw.numSectors, NUM_DIRECT*NUM_DIRECT);
-    unsigned cantIndirects2 = DivRoundUp(raw.numSectors, NUM_DIRECT);
+    // Los sectores nuevos se buscan a continuación del último que tiene
+    // el archivo, para que quede lo más contiguo posible.
+    if (!AllocateBlocks(freeMap, raw.numSectors + newSectors,
+                        LastSector(sector) + 1)) {
+        DEBUG('f', "No es posible agregar más sectores a este archivo.\n");
+        return false;
+    }
 
-    unsigned indirecLevel1 = cantIndirects1 == 0 ? 0 : numDirect % cantIndirects1;
-    unsigned indirecLevel2 = cantIndirects2 == 0 ? 0 : numDirect % cantIndirects2;
-    
-    unsigned direcInLevel = numDirect - (NUM_DIRECT*NUM_DIRECT * indirecLevel1 + NUM_DIRECT*indirecLevel2);
+    freeMap->WriteBack(fileTable->GetFile("freeMap"));
     
-    DEBUG('f', "El nivel de indirección 1 del último sector es %u.\n El nivel de indirección 2 del último sector es %u.\n El directo es el número %u, por lo que empiezo a agregar sectores en el %u.\n", indirecLevel1, indirecLevel2, direcInLevel, direcInLevel + 1);
+    if (debug.IsEnabled('f')) {
+        freeMap->Print();
+    }
 
-    unsigned newCantIndirects1 = DivRoundUp(raw.numSectors + newSectors, NUM_DIRECT*NUM_DIRECT);
-    unsigned newCantIndirects2 = DivRoundUp(raw.numSectors + newSectors, NUM_DIRECT);
-    unsigned leftSectors = newSectors;
-    
-    DEBUG('f', "La nueva primera indirección es %u.\n La nueva segunda indirección es %u\n", newCantIndirects1, newCantIndirects2); 
+    DEBUG('f', "Añadí %u sectores correctamente\n", newSectors);
+    return true;
+}
 
-    for (unsigned i = indirecLevel1; i < newCantIndirects1 && leftSectors > 0; i++){
-        if (i > indirecLevel1 || (raw.numBytes == 0 && i == indirecLevel1)){
-            ASSERT((int)(raw.dataSectors[i] = freeMap->Find()) != -1);
-            DEBUG('f', "Agrego el sector %u en el primer nivel de indirección %u\n", raw.dataSectors[i], i);
+unsigned
+FileHeader::LastSector(unsigned hdrSector) const
+{
+    if (raw.numSectors == 0) {
+        return hdrSector;
+    }
+
+    unsigned last = raw.numSectors - 1;
+    unsigned i = last / (NUM_DIRECT * NUM_DIRECT);
+    unsigned j = (last / NUM_DIRECT) % NUM_DIRECT;
+    unsigned k = last % NUM_DIRECT;
+    return raw_ind2[i][j].dataSectors[k] + sectorsPerBlock - 1;
+}
+
+bool
+FileHeader::Truncate(FreeMap *freeMap, unsigned newLength)
+{
+    ASSERT(freeMap != nullptr);
+
+    if (newLength > raw.numBytes) {
+        return false;
+    }
+
+    unsigned newBlocks = DivRoundUp(newLength, GetBlockSize());
+    DEBUG('f', "Trunco a %u bytes: quedan %u de %u bloques\n",
+          newLength, newBlocks, raw.numSectors);
+
+    ReleaseBlocks(freeMap, newBlocks, raw.numSectors);
+
+    raw.numBytes = newLength;
+    raw.numSectors = newBlocks;
+    return true;
+}
+
+bool
+FileHeader::Reserve(FreeMap *freeMap, unsigned hdrSector, unsigned length)
+{
+    ASSERT(freeMap != nullptr);
+
+    if (length > MAX_FILE_SIZE * sectorsPerBlock) {
+        return false;
+    }
+
+    unsigned newBlocks = DivRoundUp(length, GetBlockSize());
+    if (newBlocks <= raw.numSectors) {
+        return true;
+    }
+
+    unsigned nodes
+      = DivRoundUp(newBlocks, NUM_DIRECT * NUM_DIRECT)
+          - DivRoundUp(raw.numSectors, NUM_DIRECT * NUM_DIRECT)
+      + DivRoundUp(newBlocks, NUM_DIRECT)
+          - DivRoundUp(raw.numSectors, NUM_DIRECT);
+    unsigned dataSectors = (newBlocks - raw.numSectors) * sectorsPerBlock;
+    if (freeMap->CountClear() < nodes + dataSectors) {
+        return false;
+    }
+
+    // Los nodos van al principio de la tira, ocupando bloques enteros para
+    // que los datos queden alineados; lo que sobra se devuelve enseguida.
+    unsigned nodeSpace = DivRoundUp(nodes, sectorsPerBlock) * sectorsPerBlock;
+    int run = freeMap->FindRun(nodeSpace + dataSectors, sectorsPerBlock,
+                               fileSystem->GetNumSectors());
+    unsigned nextNode = run, nextData = run + nodeSpace;
+    if (run != -1) {
+        for (unsigned n = nodes; n < nodeSpace; n++) {
+            freeMap->Clear(run + n);
+        }
+    }
+    DEBUG('f', "Reservo %u bloques y %u nodos en el sector %d\n",
+          newBlocks - raw.numSectors, nodes, run);
+
+    // Sin tira contigua, cada sector se busca a continuación del anterior.
+    if (run == -1) {
+        return AllocateBlocks(freeMap, newBlocks, LastSector(hdrSector) + 1);
+    }
+
+    for (unsigned s = raw.numSectors; s < newBlocks; s++) {
+        unsigned i = s / (NUM_DIRECT * NUM_DIRECT);
+        unsigned j = s / NUM_DIRECT % NUM_DIRECT;
+        unsigned k = s % NUM_DIRECT;
+
+        if (s % (NUM_DIRECT * NUM_DIRECT) == 0) {
+            raw.dataSectors[i] = nextNode++;
+        }
+        if (k == 0) {
+            raw_ind[i].dataSectors[j] = nextNode++;
         }
-        for (unsigned j = indirecLevel2; j < newCantIndirects2 && leftSectors > 0; j++){
-            if (j > indirecLevel2 || (raw.numBytes == 0 && j == indirecLevel2)){
-                ASSERT((int)(raw_ind[i].dataSectors[j] = freeMap->Find()) != -1);
-                DEBUG('f', "Agrego el sector %u en el segundo nivel de indirección %u\n", raw_ind[i].dataSectors[j], j);
+        raw_ind2[i][j].dataSectors[k] = nextData;
+        nextData += sectorsPerBlock;
+    }
+
+    raw.numSectors = newBlocks;
+    return true;
+}
+
+bool
+FileHeader::AllocateBlocks(FreeMap *freeMap, unsigned newBlocks,
+                           unsigned next)
+{
+    ASSERT(freeMap != nullptr);
+    ASSERT(newBlocks >= raw.numSectors);
+
+    unsigned nodes
+      = DivRoundUp(newBlocks, NUM_DIRECT * NUM_DIRECT)
+          - DivRoundUp(raw.numSectors, NUM_DIRECT * NUM_DIRECT)
+      + DivRoundUp(newBlocks, NUM_DIRECT)
+          - DivRoundUp(raw.numSectors, NUM_DIRECT);
+    if (freeMap->CountClear()
+          < nodes + (newBlocks - raw.numSectors) * sectorsPerBlock) {
+        return false;
+    }
+
+    for (unsigned s = raw.numSectors; s < newBlocks; s++) {
+        unsigned i = s / (NUM_DIRECT * NUM_DIRECT);
+        unsigned j = s / NUM_DIRECT % NUM_DIRECT;
+        unsigned k = s % NUM_DIRECT;
+        int node1 = -1, node2 = -1, found = 0;
+
+        // Al empezar un nodo de indirección nuevo hay que buscarle lugar.
+        if (s % (NUM_DIRECT * NUM_DIRECT) == 0) {
+            found = node1 = freeMap->Find(next);
+            raw.dataSectors[i] = node1;
+            next = node1 + 1;
+        }
+        if (k == 0 && found != -1) {
+            found = node2 = freeMap->Find(next);
+            raw_ind[i].dataSectors[j] = node2;
+            next = node2 + 1;
+        }
+        if (found != -1) {
+            found = freeMap->Find(next, sectorsPerBlock);
+            raw_ind2[i][j].dataSectors[k] = found;
+            next = found + sectorsPerBlock;
+        }
+
+        // Aunque haya sectores libres, puede no quedar ningún bloque
+        // alineado.  Se devuelve lo que se tomó y el archivo queda como
+        // estaba.
+        if (found == -1) {
+            DEBUG('f', "No hay un bloque libre para el bloque %u\n", s);
+            if (node2 != -1) {
+                freeMap->Clear(node2);
             }
-            for (unsigned k = direcInLevel; k < NUM_DIRECT && leftSectors > 0; k++){
-                ASSERT((int)(raw_ind2[i][j].dataSectors[k] =  freeMap->Find()) != -1);
-                leftSectors -= 1;
-                DEBUG('f', "Agrego el sector %u en el 1er nivel de indirección %u, 2do nivel de indirección %u y nivel directo %u\n", raw_ind2[i][j].dataSectors[k], i, j, k);
+            if (node1 != -1) {
+                freeMap->Clear(node1);
             }
-            direcInLevel = 0;
+            ReleaseBlocks(freeMap, raw.numSectors, s);
+            return false;
         }
-        indirecLevel2 = 0;
+        DEBUG('f', "Agrego el bloque %u en el sector %u\n",
+              s, raw_ind2[i][j].dataSectors[k]);
     }
 
-    raw.numSectors += newSectors;
+    raw.numSectors = newBlocks;
+    return true;
+}
 
-    freeMap->WriteBack(fileTable->GetFile("freeMap"));
-    
-    freeMap->Print();
-    delete freeMap;
+void
+FileHeader::ReleaseBlocks(FreeMap *freeMap, unsigned first, unsigned last)
+{
+    // Se recorren las copias en memoria de los nodos, sin ir al disco.  Si
+    // el primer bloque que mapea un nodo queda afuera, queda afuera el
+    // nodo entero.
+    for (unsigned s = first; s < last; s++) {
+        unsigned i = s / (NUM_DIRECT * NUM_DIRECT);
+        unsigned j = s / NUM_DIRECT % NUM_DIRECT;
+        unsigned k = s % NUM_DIRECT;
+
+        for (unsigned n = 0; n < sectorsPerBlock; n++) {
+            ASSERT(freeMap->Test(raw_ind2[i][j].dataSectors[k] + n));
+            freeMap->Clear(raw_ind2[i][j].dataSectors[k] + n);
+        }
+        if (k == 0) {
+            freeMap->Clear(raw_ind[i].dataSectors[j]);
+        }
+        if (s % (NUM_DIRECT * NUM_DIRECT) == 0) {
+            freeMap->Clear(raw.dataSectors[i]);
+        }
+    }
+}
 
-    DEBUG('f', "Añadí %u sectores correctamente\n", newSectors);
-    return true;
+unsigned
+FileHeader::GetBlockSector(unsigned block) const
+{
+    ASSERT(block < raw.numSectors);
+    unsigned i = block / (NUM_DIRECT * NUM_DIRECT);
+    unsigned j = block / NUM_DIRECT % NUM_DIRECT;
+    return raw_ind2[i][j].dataSectors[block % NUM_DIRECT];
+}
+
+void
+FileHeader::SetBlockSector(unsigned block, unsigned sector)
+{
+    ASSERT(block < raw.numSectors);
+    unsigned i = block / (NUM_DIRECT * NUM_DIRECT);
+    unsigned j = block / NUM_DIRECT % NUM_DIRECT;
+    raw_ind2[i][j].dataSectors[block % NUM_DIRECT] = sector;
 }
 
 /// Return the number of bytes in the file.
@@ -352,7 +488,8 @@ FileHeader::ChangeLength(unsigned newLength)
 void
 FileHeader::Print(const char *title)
 {
-    char *data = new char[SECTOR_SIZE];
+    unsigned blockSize = GetBlockSize();
+    char *data = new char[blockSize];
 
     if (title == nullptr) {
         printf("File header:\n");
@@ -377,8 +514,8 @@ FileHeader::Print(const char *title)
             located = MIN(NUM_DIRECT, sectorsLeft);
             for (unsigned z = 0; z < located; z++){
                 printf("Contents of block %u:\n", raw_ind2[i][j].dataSectors[z]);
-                synchDisk->ReadSector(raw_ind2[i][j].dataSectors[z], data);
-                for (unsigned n = 0; n < SECTOR_SIZE && k < raw.numBytes; n++, k++){
+                synchDisk->ReadSectors(raw_ind2[i][j].dataSectors[z], sectorsPerBlock, data);
+                for (unsigned n = 0; n < blockSize && k < raw.numBytes; n++, k++){
                     
                     if (isprint(data[n])) {
                         printf("%c", data[n]);
@@ -15,7 +15,7 @@
 
 #include "raw_indirect_node.hh"
 #include "raw_file_header.hh"
-#include "lib/bitmap.hh"
+#include "free_map.hh"
 
 
 /// The following class defines the Nachos "file header" (in UNIX terms, the
@@ -37,10 +37,13 @@ public:
 
     /// Initialize a file header, including allocating space on disk for the
     /// file data.
-    bool Allocate(Bitmap *bitMap, unsigned fileSize);
+    ///
+    /// Los sectores se buscan a partir de `goal` (normalmente el sector del
+    /// header), así los datos quedan en el mismo grupo que el header.
+    bool Allocate(FreeMap *freeMap, unsigned fileSize, unsigned goal = 0);
 
     /// De-allocate this file's data blocks.
-    void Deallocate(Bitmap *bitMap);
+    void Deallocate(FreeMap *freeMap);
 
     /// Initialize file header from disk.
     void FetchFrom(unsigned sectorNumber);
@@ -48,13 +51,29 @@ public:
     /// Write modifications to file header back to disk.
     void WriteBack(unsigned sectorNumber);
 
-    /// Convert a byte offset into the file to the disk sector containing the
-    /// byte.
+    /// Convert a byte offset into the file to the first disk sector of the
+    /// block containing the byte.
     unsigned ByteToSector(unsigned offset);
     
-    // Agrega sectores a un archivo ya creado para poder hacerlo extensible.
+    // Agrega bloques a un archivo ya creado para poder hacerlo extensible.
+    // Los bloques nuevos se buscan a continuación del último sector de
+    // datos del archivo (o del header si todavía no tiene datos).
     bool AddSectors(unsigned sector, unsigned newSectors, unsigned addBytes);
 
+    /// Libera los bloques que quedan después de los primeros `newLength`
+    /// bytes y deja ese tamaño.  Los nodos de indirección que quedan
+    /// vacíos se liberan enteros.  No agranda: devuelve false si
+    /// `newLength` es mayor que el tamaño actual.
+    bool Truncate(FreeMap *freeMap, unsigned newLength);
+
+    /// Reserva bloques hasta cubrir `length` bytes sin cambiar el tamaño
+    /// del archivo.  Los nodos de indirección y los datos nuevos se buscan
+    /// en una sola pasada por el mapa de sectores libres, como una tira
+    /// contigua; si no hay una tira que alcance, se asignan de a uno como
+    /// en `AddSectors`.  Si tampoco así hay lugar, el archivo queda como
+    /// estaba y devuelve false.
+    bool Reserve(FreeMap *freeMap, unsigned hdrSector, unsigned length);
+
     /// Return the length of the file in bytes
     unsigned FileLength() const;
 
@@ -63,20 +82,48 @@ public:
     /// Necesario para archivos extensibles.
     unsigned ChangeLength(unsigned newLength);
     
-    // Trae todos los sectores que tiene y los guarda en to.
-    // Usado para poder saber la cantidad de entradas en un directorio.
-    char* GetEntireFile();
-    
     /// Print the contents of the file.
     void Print(const char *title);
 
+    /// Primer sector del bloque `block`, según la copia en memoria.
+    unsigned GetBlockSector(unsigned block) const;
+
+    /// Mueve el bloque `block` a `sector` en la copia en memoria.  Lo usa
+    /// el desfragmentador, que después escribe el header con `WriteBack`.
+    void SetBlockSector(unsigned block, unsigned sector);
+
     /// Get the raw file header structure.
     ///
     /// NOTE: this should only be used by routines that operate on the file
     /// system at a low level.
     const RawFileHeader *GetRaw() const;
 
+    /// Tamaño de bloque lógico, en sectores (1, 2, 4 u 8).  Se elige al
+    /// formatear y lo fija `FileSystem` antes de abrir cualquier archivo.
+    /// Los datos de los archivos se asignan y transfieren de a bloques; los
+    /// headers y los nodos de indirección ocupan siempre un sector.
+    static void SetSectorsPerBlock(unsigned n);
+    static unsigned GetSectorsPerBlock();
+
+    /// Tamaño de bloque lógico en bytes.
+    static unsigned GetBlockSize();
+
 private:
+    /// Último sector de datos asignado, o `hdrSector` si el archivo está
+    /// vacío.  Es el punto de partida para buscar sectores nuevos.
+    unsigned LastSector(unsigned hdrSector) const;
+
+    /// Asigna de a uno los bloques que faltan hasta tener `newBlocks`,
+    /// buscando cada sector a partir de `next`.  Si en algún momento no
+    /// hay lugar, libera lo que tomó y devuelve false.
+    bool AllocateBlocks(FreeMap *freeMap, unsigned newBlocks, unsigned next);
+
+    /// Libera los bloques `first` a `last - 1` y los nodos de indirección
+    /// que empiezan en alguno de ellos.
+    void ReleaseBlocks(FreeMap *freeMap, unsigned first, unsigned last);
+
+    static unsigned sectorsPerBlock;
+
     RawFileHeader raw;
     // El raw además tiene que contener:
     // numBytes 
@@ -45,20 +45,45 @@
 #include "file_header.hh"
 
 #include "filesys/raw_file_header.hh"
+#include "filesys/raw_super_block.hh"
 #include "threads/system.hh"
 #include <stdio.h>
 #include <string.h>
 #include <cstring>
 
 #define MIN(a,b) a < b ? a : b
-#define MAX_DIR_ENTRIES 50
 
 Lock* CreateLock = new Lock("FSCreateLock");
-/// Sectors containing the file headers for the bitmap of free sectors, and
-/// the directory of files.  These file headers are placed in well-known
-/// sectors, so that they can be located on boot-up.
-static const unsigned FREE_MAP_SECTOR = 0;
-static const unsigned DIRECTORY_SECTOR = 1;
+
+/// Cantidad de entradas del directorio guardado en `file`: las que están
+/// en uso hasta la primera libre.
+static unsigned
+CountEntries(OpenFile *file)
+{
+    DirectoryIterator it(file, MAX_DIR_ENTRIES);
+    DirectoryEntry entry;
+    unsigned count = 0;
+    while (it.Next(&entry) && entry.inUse) {
+        count++;
+    }
+    return count;
+}
+
+/// Imprime las entradas del directorio `name` de la `dirTable`, como
+/// `Directory::List`.  Se llama con el lock del directorio tomado.
+static void
+ListEntries(const char *name)
+{
+    DirectoryIterator it(dirTable->GetDir(name), dirTable->GetNumEntries(name));
+    DirectoryEntry entry;
+    while (it.Next(&entry)) {
+        if (entry.inUse) {
+            printf("> %s\n", entry.name);
+        }
+        else
+            printf("> %s (Removed)\n", entry.name);
+    }
+}
 
 /// Initialize the file system.  If `format == true`, the disk has nothing on
 /// it, and we need to initialize the disk to contain an empty directory, and
@@ -69,14 +94,22 @@ static const unsigned DIRECTORY_SECTOR = 1;
 /// bitmap and the directory.
 ///
 /// * `format` -- should we initialize the disk?
-FileSystem::FileSystem(bool format)
+/// * `sectorsPerBlock` -- tamaño de bloque con el que formatear.
+FileSystem::FileSystem(bool format, unsigned sectorsPerBlock)
 {
     DEBUG('f', "Initializing the file system.\n");
     // Debemos inicializar el disco (de 0)
     if (format) {
         
+        // Un bloque nunca puede cruzar una pista, así se transfiere con un
+        // solo pedido al disco.
+        ASSERT(synchDisk->GetSectorsPerTrack() % sectorsPerBlock == 0);
+        FileHeader::SetSectorsPerBlock(sectorsPerBlock);
+
         // Creamos un bitmap para ir llevando los sectores libres del disco.
-        Bitmap     *freeMap = new Bitmap(NUM_SECTORS);
+        freeMap = new FreeMap(synchDisk->GetNumSectors(),
+                              synchDisk->GetSectorsPerTrack());
+        hasSuperBlock = true;
         
         // No creamos un directorio ya que no vamos a guardar nada.
         // En el directorio se guarda unicamente la tabla de archivos que tiene.
@@ -95,14 +128,29 @@ FileSystem::FileSystem(bool format)
         // Los archivos/directorios se crean dentro de este.
         freeMap->Mark(FREE_MAP_SECTOR);
         freeMap->Mark(DIRECTORY_SECTOR);
+        freeMap->Mark(SUPER_BLOCK_SECTOR);
+
+        // Guardamos la geometría con la que se formateó.
+        char sector[SECTOR_SIZE];
+        memset(sector, 0, SECTOR_SIZE);
+        RawSuperBlock *sb = (RawSuperBlock *) sector;
+        sb->magic           = SUPER_BLOCK_MAGIC;
+        sb->sectorSize      = SECTOR_SIZE;
+        sb->sectorsPerTrack = synchDisk->GetSectorsPerTrack();
+        sb->numTracks       = synchDisk->GetNumTracks();
+        sb->numSectors      = synchDisk->GetNumSectors();
+        sb->tracksPerGroup  = TRACKS_PER_GROUP;
+        sb->freeMapSize     = freeMap->GetFileSize();
+        sb->sectorsPerBlock = sectorsPerBlock;
+        synchDisk->WriteSector(SUPER_BLOCK_SECTOR, sector);
 
         // Second, allocate space for the data blocks containing the contents
         // of the directory and bitmap files.  There better be enough space!
         
         DEBUG('f', "Hago espacio para los datos del bitmap\n");
-        ASSERT(mapH->Allocate(freeMap, FREE_MAP_FILE_SIZE));
+        ASSERT(mapH->Allocate(freeMap, freeMap->GetFileSize()));
         DEBUG('f', "Hago espacio para los datos del directorio\n");
-        ASSERT(dirH->Allocate(freeMap, DIRECTORY_FILE_SIZE));
+        ASSERT(dirH->Allocate(freeMap, DIRECTORY_FILE_SIZE, DIRECTORY_SECTOR));
 
         // Flush the bitmap and directory `FileHeader`s back to disk.
         // We need to do this before we can `Open` the file, since open reads
@@ -142,12 +190,9 @@ FileSystem::FileSystem(bool format)
         if (debug.IsEnabled('f')) {
             freeMap->Print();
             //dir->Print();
-
-            delete freeMap;
-            //delete dir;
-            delete mapH;
-            delete dirH;
         }
+        delete mapH;
+        delete dirH;
     } else {
         // If we are not formatting the disk, just open the files
         // representing the bitmap and directory; these are left open while
@@ -157,14 +202,31 @@ FileSystem::FileSystem(bool format)
         
         // Añadimos el freeMap a la fileTable
         fileTable->Add(freeMapFile, "freeMap");
+
+        // Si hay superbloque tiene que coincidir con la etiqueta del disco.
+        char sector[SECTOR_SIZE];
+        synchDisk->ReadSector(SUPER_BLOCK_SECTOR, sector);
+        const RawSuperBlock *sb = (const RawSuperBlock *) sector;
+        hasSuperBlock = sb->magic == SUPER_BLOCK_MAGIC;
+        if (hasSuperBlock) {
+            ASSERT(sb->sectorSize == SECTOR_SIZE);
+            ASSERT(sb->sectorsPerTrack == synchDisk->GetSectorsPerTrack());
+            ASSERT(sb->numSectors == synchDisk->GetNumSectors());
+            ASSERT(sb->tracksPerGroup == TRACKS_PER_GROUP);
+            if (sb->sectorsPerBlock != 0) {
+                FileHeader::SetSectorsPerBlock(sb->sectorsPerBlock);
+            }
+        } else {
+            DEBUG('f', "Disco sin superbloque, uso la geometría por defecto.\n");
+            ASSERT(synchDisk->GetNumSectors() == NUM_SECTORS);
+        }
+
+        // El bitmap queda en memoria mientras Nachos corre.
+        freeMap = new FreeMap(synchDisk->GetNumSectors(),
+                              synchDisk->GetSectorsPerTrack());
+        freeMap->FetchFrom(freeMapFile);
         
-       unsigned dirEntries = 0;
-        
-       if (directoryFile->GetFileHeader()->GetRaw()->numSectors > 0){
-            Directory* dir = new Directory(MAX_DIR_ENTRIES);
-            dir->FetchFrom(directoryFile);
-            for(; dir->GetRaw()->table[dirEntries].inUse;dirEntries++);
-       }
+        unsigned dirEntries = CountEntries(directoryFile);
 
         // Añadimos el directorio a la dirTable.
         dirTable->Add(directoryFile, "root", nullptr);
@@ -181,6 +243,7 @@ FileSystem::~FileSystem()
 {
     delete fileTable->GetFile("freeMap");
     delete dirTable->GetDir("root");
+    delete freeMap;
     //fileTable->Remove("freeMap");
     // Ver en el ejercicio 4 que pasa al remover directorios.
 }
@@ -251,16 +314,10 @@ FileSystem::AddDirFile(char** path, unsigned subDirectories)
     
     OpenFile* entrySearched = new OpenFile(sub_sector);
 
-    Directory* subDir = new Directory(MAX_DIR_ENTRIES);
-    subDir->FetchFrom(entrySearched);
-    
-    unsigned numSubDirEntries = 0;
-    if(entrySearched->GetFileHeader()->GetRaw()->numSectors != 0)
-        for(;subDir->GetRaw()->table[numSubDirEntries].inUse;numSubDirEntries++);
+    unsigned numSubDirEntries = CountEntries(entrySearched);
     dirTable->Add(entrySearched, path[subDirectories], path[subDirectories-1]);
     dirTable->SetNumEntries(path[subDirectories], numSubDirEntries);
     dirTable->DirLock(path[subDirectories-1], RELEASE);
-    delete subDir;
     delete dir;
     
 
@@ -307,7 +364,7 @@ FileSystem::Create(const char *name, unsigned initialSize)
     ASSERT(name != nullptr);
     unsigned nameLen = strlen(name);
     ASSERT(nameLen < FILE_NAME_MAX_LEN);
-    ASSERT(initialSize < MAX_FILE_SIZE);
+    ASSERT(initialSize <= MAX_FILE_SIZE * FileHeader::GetSectorsPerBlock());
     
 
     // Ahora tomamos el lock del directorio sobre el cual vamos a trabajar.
@@ -330,35 +387,48 @@ FileSystem::Create(const char *name, unsigned initialSize)
         success = true;  // File is already in directory.
     } else {
         
-        Bitmap *freeMap = new Bitmap(NUM_SECTORS);
         OpenFile* freeMapFile = fileTable->GetFile("freeMap");
-        freeMap->FetchFrom(freeMapFile);
-        int sector = freeMap->Find();
+        // El header va en el grupo del directorio padre.
+        int sector = freeMap->Find(dirTable->GetDir(actDir)->GetSector());
           // Find a sector to hold the file header.
         if (sector == -1) {
             DEBUG('f', "Error: no hay lugar para el header del archivo %s\n", name);
             success = false;  // No free block for file header.
         } else if (!dir->Add(name, sector)) {
             DEBUG('f', "Error: no hay espacio en directorio para archivo %s\n", name);
+            freeMap->Clear(sector);
             success = false;  // No space in directory.
+        } else if (!dirTable->GetDir(actDir)->Allocate(
+                       dir->GetRaw()->tableSize * sizeof (DirectoryEntry))) {
+            // El directorio crece al escribirse; se le reserva lugar antes
+            // para no quedarse sin disco con el header ya escrito.
+            DEBUG('f', "Error: no hay lugar para agrandar el directorio %s\n", actDir);
+            freeMap->Clear(sector);
+            success = false;
         } else {
+            // Si el sector era de un archivo borrado, sus páginas no sirven.
+            #ifdef PAGE_CACHE
+            pageCache->Invalidate(sector);
+            #endif
             FileHeader *h = new FileHeader; // Creo el i-nodo
-            success = h->Allocate(freeMap, initialSize);
+            success = h->Allocate(freeMap, initialSize, sector);
               // Fails if no space on disk for data.
             if (success) {
                 DEBUG('f', "Creación del archivo %s exitosa, mandando a disco todo\n", name);
+                // Mientras se escriben el bitmap y el header, las búsquedas
+                // de otros archivos del directorio pueden seguir.  El
+                // directorio mismo se escribe sin lectores, porque puede
+                // crecer y cambiar su header en memoria.
+                dirTable->BeginEntryUpdate(actDir, name);
                 // Escribo el bitmap así se actualiza el sector que le dí al archivo.
                 freeMap->WriteBack(freeMapFile);
 
                 // Everything worked, flush all changes back to disk.
                 DEBUG('f', "Mando a disco el header del archivo %s\n", name);
                 h->WriteBack(sector);
+                dirTable->EndEntryUpdate(actDir);
                 DEBUG('f', "Mando a disco el directorio que contiene el archivo\n");
                 dir->WriteBack(dirTable->GetDir(actDir));
-                DEBUG('f', "Mando a disco el Bitmap\n");
-                // Lo traigo de nuevo para ver si hubo algún cambio.
-                freeMap->FetchFrom(freeMapFile);
-                freeMap->WriteBack(freeMapFile);
                // DEBUG('f', "Ahora quiero imprimir el Bitmap\n");
                // freeMap->Print();
                // DEBUG('f',"Escribo por las dudas:\n");
@@ -366,12 +436,13 @@ FileSystem::Create(const char *name, unsigned initialSize)
                // DEBUG('f', "A ver que tal quedó:\n");
                // dir->FetchFrom(dirTable->GetDir("root"));
             }
-            else
+            else {
                 DEBUG('f', "Error: No hay espacio en el disco para los datos del archivo %s\n", name);
+                freeMap->Clear(sector);
+            }
 
             delete h;
         }
-        delete freeMap;
     }
     delete dir;
     //CreateLock->Release();
@@ -402,14 +473,16 @@ FileSystem::Open(const char *name)
 {
     ASSERT(name != nullptr);
     char* actDir = currentThread->GetDir();
-    Directory *dir = new Directory(dirTable->GetNumEntries(actDir));
     OpenFile  *openFile = nullptr;
 
+    // La búsqueda no modifica el directorio: alcanza con el modo
+    // compartido.
     DEBUG('f', "Opening file %s\n", name);
-    dirTable->DirLock(actDir, ACQUIRE);
+    dirTable->DirLockLookup(actDir, name);
+    Directory *dir = new Directory(dirTable->GetNumEntries(actDir));
     dir->FetchFrom(dirTable->GetDir(actDir));
     int sector = dir->Find(name);
-    dirTable->DirLock(actDir, RELEASE);
+    dirTable->DirLock(actDir, RELEASE_SHARED);
     if (sector >= 0) {
         
         // Primero debo checkear que el archivo no esté en la fileTable.
@@ -542,15 +615,15 @@ FileSystem::Remove(const char *name)
     FileHeader *fileH = new FileHeader;
     fileH->FetchFrom(sector);
     
-    Bitmap *freeMap = new Bitmap(NUM_SECTORS);
     OpenFile* freeMapFile = fileTable->GetFile("freeMap"); 
-    freeMap->FetchFrom(freeMapFile);
 
     fileH->Deallocate(freeMap);  // Remove data blocks.
     freeMap->Clear(sector);      // Remove header block.
     dir->Remove(name);
 
+    dirTable->BeginEntryUpdate(actDir, name);
     freeMap->WriteBack(freeMapFile);  // Flush to disk.
+    dirTable->EndEntryUpdate(actDir);
     dir->WriteBack(directoryFile);    // Flush to disk.
     
     // No hace falta decrementar el número de dirEntries ya que
@@ -558,7 +631,7 @@ FileSystem::Remove(const char *name)
     dirTable->DirLock(actDir, RELEASE);
     delete fileH;
     delete dir;
-    delete freeMap;
+    defragmenter->Notify();
     return true;
 }
 
@@ -575,14 +648,14 @@ FileSystem::RemoveDir(char *path)
 
     DEBUG('f', "Voy a eliminar el directorio: %s\n", path);
 
-    char* dirNames[NUM_SECTORS];
+    char* dirNames[MAX_DIRS + 1];
     dirNames[0] = strtok(path, "/");
 
     unsigned subdirs = 0;
     
     // Voy metiendo los nombres.
     while(dirNames[subdirs] != NULL){
-        ASSERT(subdirs < NUM_SECTORS);
+        ASSERT(subdirs < MAX_DIRS);
         dirNames[subdirs + 1] = strtok(NULL, "/");
         subdirs++;
     }
@@ -661,12 +734,7 @@ FileSystem::RemoveDir(char *path)
     }
     else 
     {
-        Directory* preDir = new Directory(MAX_DIR_ENTRIES);
-        preDir->FetchFrom(delDirFile);
-        unsigned entries = 0;
-        if (delDirFile->GetFileHeader()->GetRaw()->numSectors != 0)
-            for(;preDir->GetRaw()->table[entries].inUse;entries++);
-        delete preDir;
+        unsigned entries = CountEntries(delDirFile);
         delDir = new Directory(entries);
         dirTable->Add(delDirFile, name, actDir);
         dirTable->SetNumEntries(name, entries);
@@ -680,9 +748,7 @@ FileSystem::RemoveDir(char *path)
     
     delDir->FetchFrom(delDirFile);
      
-    Bitmap *freeMap = new Bitmap(NUM_SECTORS);
     OpenFile* freeMapFile = fileTable->GetFile("freeMap"); 
-    freeMap->FetchFrom(freeMapFile);
     
     // Si nadie lo mantiene abierto puedo cerrarlo directamente.
     if(dirTable->getThreadsIn(name) == 0)
@@ -843,10 +909,11 @@ FileSystem::RemoveDir(char *path)
     dir->FetchFrom(directoryFile);
     dir->Remove(name);
     dir->WriteBack(directoryFile);
-    dirTable->SetNumEntries(actDir, dirTable->GetNumEntries(actDir) - 1);
+    // Igual que en `Remove`, la entrada sólo se marca como libre, así que
+    // la cantidad de entradas no cambia.
     dirTable->DirLock(actDir, RELEASE);
     delete delDir;
-    delete freeMap;
+    defragmenter->Notify();
     return true;
 }
 
@@ -857,7 +924,7 @@ FileSystem::MkDir(const char *name, unsigned initialSize)
     //CreateLock->Acquire();
     ASSERT(name != nullptr);
     ASSERT(strlen(name) < DIR_NAME_MAX_LEN);
-    ASSERT(initialSize < MAX_FILE_SIZE);
+    ASSERT(initialSize <= MAX_FILE_SIZE * FileHeader::GetSectorsPerBlock());
     
     // Ahora tomamos el lock del directorio sobre el cual vamos a trabajar.
     // En este caso es root.
@@ -879,20 +946,31 @@ FileSystem::MkDir(const char *name, unsigned initialSize)
         success = false;  // File is already in directory.
     } else {
         
-        Bitmap *freeMap = new Bitmap(NUM_SECTORS);
         OpenFile* freeMapFile = fileTable->GetFile("freeMap");
-        freeMap->FetchFrom(freeMapFile);
-        int sector = freeMap->Find();
+        // Los directorios nuevos se reparten en el grupo con más lugar
+        // libre; los archivos que se creen dentro quedarán en ese grupo.
+        int sector = freeMap->Find(freeMap->PickDirGroup());
           // Find a sector to hold the file header.
         if (sector == -1) {
             DEBUG('f', "Error: no hay lugar para el header del archivo %s\n", name);
             success = false;  // No free block for file header.
-        } else if (!dir->Add(name, sector)) {
+        } else if (!dir->Add(name, sector, true)) {
             DEBUG('f', "Error: no hay espacio en directorio para archivo %s\n", name);
+            freeMap->Clear(sector);
             success = false;  // No space in directory.
+        } else if (!dirTable->GetDir(actDir)->Allocate(
+                       dir->GetRaw()->tableSize * sizeof (DirectoryEntry))) {
+            // El directorio crece al escribirse; se le reserva lugar antes
+            // para no quedarse sin disco con el header ya escrito.
+            DEBUG('f', "Error: no hay lugar para agrandar el directorio %s\n", actDir);
+            freeMap->Clear(sector);
+            success = false;
         } else {
+            #ifdef PAGE_CACHE
+            pageCache->Invalidate(sector);
+            #endif
             FileHeader *h = new FileHeader;
-            success = h->Allocate(freeMap, initialSize);
+            success = h->Allocate(freeMap, initialSize, sector);
               // Fails if no space on disk for data.
             if (success) {
 
@@ -900,31 +978,32 @@ FileSystem::MkDir(const char *name, unsigned initialSize)
                 dirTable->Add(newDirFile, name, actDir);
 
                 DEBUG('f', "Creación del directorio %s exitosa, mandando a disco todo\n", name);
+                dirTable->BeginEntryUpdate(actDir, name);
                 // Escribo el bitmap así se actualiza el sector que le dí al archivo.
                 freeMap->WriteBack(freeMapFile);
 
                 // Everything worked, flush all changes back to disk.
                 DEBUG('f', "Mando a disco el header del archivo %s\n", name);
                 h->WriteBack(sector);
+                dirTable->EndEntryUpdate(actDir);
                 DEBUG('f', "Mando a disco el directorio que contiene el archivo\n");
                 dir->WriteBack(dirTable->GetDir(actDir));
-                DEBUG('f', "Mando a disco el Bitmap\n");
-                // Lo traigo de nuevo para ver si hubo algún cambio.
-                freeMap->FetchFrom(freeMapFile);
-                freeMap->WriteBack(freeMapFile);
                 DEBUG('f', "Ahora quiero imprimir el Bitmap\n");
-                freeMap->Print();
+                if (debug.IsEnabled('f')) {
+                    freeMap->Print();
+                }
                 DEBUG('f',"Escribo por las dudas:\n");
                 dir->WriteBack(dirTable->GetDir(actDir));
                 DEBUG('f', "A ver que tal quedó:\n");
                 dir->FetchFrom(dirTable->GetDir(actDir));
             }
-            else
+            else {
                 DEBUG('f', "Error: No hay espacio en el disco para los datos del archivo %s\n", name);
+                freeMap->Clear(sector);
+            }
 
             delete h;
         }
-        delete freeMap;
     }
     delete dir;
     //CreateLock->Release();
@@ -950,14 +1029,14 @@ FileSystem::Ls(char* path)
     DEBUG('f', "Voy a listar el directorio %s.\n", path);
     ASSERT(path != nullptr);
 
-    char* dirNames[NUM_SECTORS];
+    char* dirNames[MAX_DIRS + 1];
     dirNames[0] = strtok(path, "/");
 
     unsigned subdirs = 0;
     
     // Voy metiendo los nombres.
     while(dirNames[subdirs] != NULL){
-        ASSERT(subdirs < NUM_SECTORS);
+        ASSERT(subdirs < MAX_DIRS);
         dirNames[subdirs + 1] = strtok(NULL, "/");
         subdirs++;
     }
@@ -1022,12 +1101,9 @@ FileSystem::Ls(char* path)
     }
     if(!dirTable->getToDelete(name)){ 
         DEBUG('f', "A punto de listar el directorio %s\n", name);
-        dirTable->DirLock(name, ACQUIRE);
-        Directory *dir = new Directory (dirTable->GetNumEntries(name));
-        dir->FetchFrom(dirTable->GetDir(name));
-        dir->List();
-        dirTable->DirLock(name, RELEASE);
-        delete dir;
+        dirTable->DirLock(name, ACQUIRE_SHARED);
+        ListEntries(name);
+        dirTable->DirLock(name, RELEASE_SHARED);
         DEBUG('f', "Terminé de listar.\n");
     }
     delete [] name;
@@ -1038,13 +1114,9 @@ FileSystem::Ls(char* path)
 void
 FileSystem::List()
 {
-    dirTable->DirLock("root", ACQUIRE);
-    Directory *dir = new Directory(dirTable->GetNumEntries("root"));
-
-    dir->FetchFrom(dirTable->GetDir("root"));
-    dir->List();
-    dirTable->DirLock("root", RELEASE);
-    delete dir;
+    dirTable->DirLock("root", ACQUIRE_SHARED);
+    ListEntries("root");
+    dirTable->DirLock("root", RELEASE_SHARED);
 }
 
 static bool
@@ -1073,7 +1145,7 @@ CheckForError(bool value, const char *message)
 static bool
 CheckSector(unsigned sector, Bitmap *shadowMap)
 {
-    if (CheckForError(sector < NUM_SECTORS,
+    if (CheckForError(sector < shadowMap->GetNumBits(),
                       "sector number too big.  Skipping bitmap check.")) {
         return true;
     }
@@ -1121,7 +1193,7 @@ static bool
 CheckBitmaps(const Bitmap *freeMap, const Bitmap *shadowMap)
 {
     bool error = false;
-    for (unsigned i = 0; i < NUM_SECTORS; i++) {
+    for (unsigned i = 0; i < freeMap->GetNumBits(); i++) {
         DEBUG('f', "Checking sector %u. Original: %u, shadow: %u.\n",
               i, freeMap->Test(i), shadowMap->Test(i));
         error |= CheckForError(freeMap->Test(i) == shadowMap->Test(i),
@@ -1192,10 +1264,14 @@ FileSystem::Check()
     DEBUG('f', "Performing filesystem check\n");
     bool error = false;
     
-    Bitmap *shadowMap = new Bitmap(NUM_SECTORS);
+    Bitmap *shadowMap = new Bitmap(GetNumSectors());
+    unsigned freeMapSize = freeMap->GetFileSize();
     
     shadowMap->Mark(FREE_MAP_SECTOR);
     shadowMap->Mark(DIRECTORY_SECTOR);
+    if (hasSuperBlock) {
+        shadowMap->Mark(SUPER_BLOCK_SECTOR);
+    }
 
     DEBUG('f', "Checking bitmap's file header.\n");
 
@@ -1204,11 +1280,12 @@ FileSystem::Check()
     bitH->FetchFrom(FREE_MAP_SECTOR);
     DEBUG('f', "  File size: %u bytes, expected %u bytes.\n"
                "  Number of sectors: %u, expected %u.\n",
-          bitRH->numBytes, FREE_MAP_FILE_SIZE,
-          bitRH->numSectors, FREE_MAP_FILE_SIZE / SECTOR_SIZE);
-    error |= CheckForError(bitRH->numBytes == FREE_MAP_FILE_SIZE,
+          bitRH->numBytes, freeMapSize,
+          bitRH->numSectors, DivRoundUp(freeMapSize, SECTOR_SIZE));
+    error |= CheckForError(bitRH->numBytes == freeMapSize,
                            "bad bitmap header: wrong file size.");
-    error |= CheckForError(bitRH->numSectors == FREE_MAP_FILE_SIZE / SECTOR_SIZE,
+    error |= CheckForError(bitRH->numSectors == DivRoundUp(freeMapSize,
+                                                           SECTOR_SIZE),
                            "bad bitmap header: wrong number of sectors.");
     error |= CheckFileHeader(bitRH, FREE_MAP_SECTOR, shadowMap);
     delete bitH;
@@ -1221,9 +1298,6 @@ FileSystem::Check()
     error |= CheckFileHeader(dirRH, DIRECTORY_SECTOR, shadowMap);
     delete dirH;
 
-    Bitmap *freeMap = new Bitmap(NUM_SECTORS);
-    OpenFile* freeMapFile = fileTable->GetFile("freeMap");
-    freeMap->FetchFrom(freeMapFile);
     dirTable->DirLock("root", ACQUIRE);
     Directory *dir = new Directory(dirTable->GetNumEntries("root"));
     const RawDirectory *rdir = dir->GetRaw();
@@ -1234,9 +1308,8 @@ FileSystem::Check()
 
     // The two bitmaps should match.
     DEBUG('f', "Checking bitmap consistency.\n");
-    error |= CheckBitmaps(freeMap, shadowMap);
+    error |= CheckBitmaps(freeMap->GetBitmap(), shadowMap);
     delete shadowMap;
-    delete freeMap;
 
     DEBUG('f', error ? "Filesystem check failed.\n"
                      : "Filesystem check succeeded.\n");
@@ -1256,9 +1329,6 @@ FileSystem::Print()
     FileHeader *bitH    = new FileHeader;
     FileHeader *dirH    = new FileHeader;
     
-    Bitmap     *freeMap = new Bitmap(NUM_SECTORS);
-    OpenFile* freeMapFile = fileTable->GetFile("freeMap");
-    
     dirTable->DirLock("root", ACQUIRE);
     Directory   *dir = new Directory(dirTable->GetNumEntries("root"));
     OpenFile* directoryFile = dirTable->GetDir("root");
@@ -1272,7 +1342,6 @@ FileSystem::Print()
     dirH->Print("Directory");
 
     printf("--------------------------------\n");
-    freeMap->FetchFrom(freeMapFile);
     freeMap->Print();
 
     printf("--------------------------------\n");
@@ -1282,7 +1351,18 @@ FileSystem::Print()
 
     delete bitH;
     delete dirH;
-    delete freeMap;
     delete dir;
     dirTable->DirLock("root", RELEASE);
 }
+
+FreeMap *
+FileSystem::GetFreeMap()
+{
+    return freeMap;
+}
+
+unsigned
+FileSystem::GetNumSectors() const
+{
+    return freeMap->GetBitmap()->GetNumBits();
+}
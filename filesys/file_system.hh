@@ -44,7 +44,6 @@
 /// Constant definitions with dummy values.  For the stub filesystem they
 /// are not required, but system information tools expects them to be
 /// defined.
-static const unsigned FREE_MAP_FILE_SIZE = 0;
 static const unsigned NUM_DIR_ENTRIES = 0;
 static const unsigned DIRECTORY_FILE_SIZE = 0;
 
@@ -91,13 +90,16 @@ public:
 
 
 #include "directory_entry.hh"
+#include "free_map.hh"
 #include "machine/disk.hh"
 
 
-/// Initial file sizes for the bitmap and directory; until the file system
-/// supports extensible files, the directory size sets the maximum number of
-/// files that can be loaded onto the disk.
-static const unsigned FREE_MAP_FILE_SIZE = NUM_SECTORS / BITS_IN_BYTE;
+/// Initial file size for the directory; until the file system supports
+/// extensible files, the directory size sets the maximum number of files
+/// that can be loaded onto the disk.
+///
+/// El tamaño del bitmap depende de la geometría del disco (ver
+/// `FreeMap::GetFileSize`).
 
 // Con archivos extensibles podemos hacer esto 0.
 //static const unsigned NUM_DIR_ENTRIES = 10;
@@ -118,7 +120,10 @@ public:
     ///
     /// If `format`, there is nothing on the disk, so initialize the
     /// directory and the bitmap of free blocks.
-    FileSystem(bool format);
+    ///
+    /// Al formatear, `sectorsPerBlock` es el tamaño de bloque lógico de los
+    /// datos (1, 2, 4 u 8 sectores); si no, se lee del superbloque.
+    FileSystem(bool format, unsigned sectorsPerBlock = 1);
 
     ~FileSystem();
 
@@ -157,7 +162,21 @@ public:
     /// List all the files and their contents.
     void Print();
 
+    /// Devuelve el mapa de sectores libres.
+    FreeMap *GetFreeMap();
+
+    /// Cantidad de sectores del disco montado.
+    unsigned GetNumSectors() const;
+
 private:
+    /// Mapa de sectores libres, se mantiene en memoria mientras Nachos
+    /// corre y se manda a disco después de cada modificación.
+    FreeMap *freeMap;
+
+    /// Si el disco tiene superbloque.  Los discos formateados antes de que
+    /// existiera no lo tienen y usan la geometría por defecto.
+    bool hasSuperBlock;
+
     //OpenFile *freeMapFile;  ///< Bit map of free disk blocks, represented as a
                             ///< file.
     //OpenFile *directoryFile;  ///< “Root” directory -- list of file names,
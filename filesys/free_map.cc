@@ -0,0 +1,344 @@
+/// Rutinas para manejar el mapa de sectores libres por grupos.
+///
+/// Ver `free_map.hh` para la descripción de la política de ubicación.
+
+
+#include "free_map.hh"
+#include "threads/lock.hh"
+
+#include <stdio.h>
+
+
+FreeMap::FreeMap(unsigned nitems, unsigned sectorsPerTrack)
+{
+    ASSERT(nitems > 0);
+    ASSERT(sectorsPerTrack > 0);
+
+    numSectors      = nitems;
+    sectorsPerGroup = TRACKS_PER_GROUP * sectorsPerTrack;
+    numGroups       = DivRoundUp(numSectors, sectorsPerGroup);
+    map             = new Bitmap(numSectors);
+
+    groupFree = new unsigned [numGroups];
+    for (unsigned i = 0; i < numGroups; i++) {
+        groupFree[i] = GroupEnd(i) - GroupStart(i);
+    }
+
+    // Todavía no se escribió nada, así que todo el bitmap está sucio.
+    numChunks = DivRoundUp(GetFileSize(), SECTOR_SIZE);
+    dirty     = new bool [numChunks];
+    for (unsigned i = 0; i < numChunks; i++) {
+        dirty[i] = true;
+    }
+
+    groupLocks = new Lock* [numGroups];
+    for (unsigned i = 0; i < numGroups; i++) {
+        groupLocks[i] = new Lock("FreeMapGroupLock");
+    }
+    flushLock = new Lock("FreeMapFlushLock");
+}
+
+FreeMap::~FreeMap()
+{
+    for (unsigned i = 0; i < numGroups; i++) {
+        delete groupLocks[i];
+    }
+    delete [] groupLocks;
+    delete flushLock;
+    delete [] groupFree;
+    delete [] dirty;
+    delete map;
+}
+
+void
+FreeMap::Mark(unsigned which)
+{
+    ASSERT(which < numSectors);
+    Lock *l = groupLocks[GroupOf(which)];
+    l->Acquire();
+    if (!map->Test(which)) {
+        map->Mark(which);
+        groupFree[GroupOf(which)]--;
+        SetDirty(which);
+    }
+    l->Release();
+}
+
+void
+FreeMap::Clear(unsigned which)
+{
+    ASSERT(which < numSectors);
+    Lock *l = groupLocks[GroupOf(which)];
+    l->Acquire();
+    if (map->Test(which)) {
+        map->Clear(which);
+        groupFree[GroupOf(which)]++;
+        SetDirty(which);
+    }
+    l->Release();
+}
+
+bool
+FreeMap::Test(unsigned which) const
+{
+    return map->Test(which);
+}
+
+int
+FreeMap::FindInRange(unsigned group, unsigned from, unsigned to,
+                     unsigned count)
+{
+    unsigned end = GroupEnd(group);
+    unsigned i = from;
+    while (i < to) {
+        int found = map->FindInRange(i, to);
+        if (found == -1) {
+            return -1;
+        }
+
+        // Primer bloque alineado que empieza en o después del libre.
+        unsigned start = DivRoundUp((unsigned) found, count) * count;
+        if (start + count > end) {
+            return -1;
+        }
+        unsigned n = 0;
+        while (n < count && !map->Test(start + n)) {
+            n++;
+        }
+        if (n == count) {
+            for (n = 0; n < count; n++) {
+                map->Mark(start + n);
+                SetDirty(start + n);
+            }
+            groupFree[group] -= count;
+            return start;
+        }
+        i = start + count;
+    }
+    return -1;
+}
+
+void
+FreeMap::SetDirty(unsigned which)
+{
+    dirty[which / BITS_IN_WORD * sizeof (unsigned) / SECTOR_SIZE] = true;
+}
+
+int
+FreeMap::Find(unsigned goal, unsigned count)
+{
+    ASSERT(count > 0 && sectorsPerGroup % count == 0);
+
+    if (goal >= numSectors) {
+        goal = 0;
+    }
+
+    unsigned first = GroupOf(goal);
+    for (unsigned n = 0; n < numGroups; n++) {
+        unsigned g     = (first + n) % numGroups;
+        unsigned start = GroupStart(g);
+        unsigned end   = GroupEnd(g);
+
+        // Los grupos llenos se saltean sin mirar el bitmap.
+        if (groupFree[g] < count) {
+            continue;
+        }
+
+        groupLocks[g]->Acquire();
+        int sector = -1;
+        if (groupFree[g] < count) {
+            sector = -1;  // Se llenó mientras esperaba el lock.
+        } else if (n == 0) {
+            // En el grupo del objetivo empiezo desde `goal` y si no
+            // encuentro vuelvo al comienzo del grupo.
+            sector = FindInRange(g, goal, end, count);
+            if (sector == -1) {
+                sector = FindInRange(g, start, goal, count);
+            }
+        } else {
+            sector = FindInRange(g, start, end, count);
+        }
+        groupLocks[g]->Release();
+
+        if (sector != -1) {
+            DEBUG('f', "Sector %d asignado en el grupo %u (objetivo %u).\n",
+                  sector, g, goal);
+            return sector;
+        }
+    }
+    return -1;
+}
+
+int
+FreeMap::FindRun(unsigned count, unsigned align, unsigned limit)
+{
+    ASSERT(count > 0 && align > 0);
+
+    // La tira puede cruzar grupos, así que se toman todos los locks en
+    // orden; `Find` toma uno solo por vez.
+    for (unsigned g = 0; g < numGroups; g++) {
+        groupLocks[g]->Acquire();
+    }
+
+    int found = -1;
+    unsigned start = 0;
+    while (start < limit && start + count <= numSectors) {
+        unsigned n = 0;
+        while (n < count && !map->Test(start + n)) {
+            n++;
+        }
+        if (n == count) {
+            found = start;
+            break;
+        }
+        // El sector `start + n` está ocupado; la próxima tira posible
+        // empieza después.
+        start = DivRoundUp(start + n + 1, align) * align;
+    }
+
+    if (found != -1) {
+        for (unsigned i = found; i < found + count; i++) {
+            map->Mark(i);
+            groupFree[GroupOf(i)]--;
+            SetDirty(i);
+        }
+        DEBUG('f', "Tira de %u sectores asignada en el sector %d.\n",
+              count, found);
+    }
+
+    for (unsigned g = numGroups; g > 0; g--) {
+        groupLocks[g - 1]->Release();
+    }
+    return found;
+}
+
+unsigned
+FreeMap::CountClear() const
+{
+    unsigned count = 0;
+    for (unsigned g = 0; g < numGroups; g++) {
+        count += groupFree[g];
+    }
+    return count;
+}
+
+unsigned
+FreeMap::CountFreeRuns() const
+{
+    unsigned runs = 0;
+    for (unsigned i = 0; i < numSectors; i++) {
+        if (!map->Test(i) && (i == 0 || map->Test(i - 1))) {
+            runs++;
+        }
+    }
+    return runs;
+}
+
+unsigned
+FreeMap::CountClearInGroup(unsigned group) const
+{
+    ASSERT(group < numGroups);
+    return groupFree[group];
+}
+
+unsigned
+FreeMap::GroupOf(unsigned sector) const
+{
+    return sector / sectorsPerGroup;
+}
+
+unsigned
+FreeMap::GroupStart(unsigned group) const
+{
+    return group * sectorsPerGroup;
+}
+
+unsigned
+FreeMap::GroupEnd(unsigned group) const
+{
+    unsigned end = GroupStart(group) + sectorsPerGroup;
+    return end > numSectors ? numSectors : end;
+}
+
+unsigned
+FreeMap::GetNumGroups() const
+{
+    return numGroups;
+}
+
+unsigned
+FreeMap::GetSectorsPerGroup() const
+{
+    return sectorsPerGroup;
+}
+
+unsigned
+FreeMap::GetFileSize() const
+{
+    return DivRoundUp(numSectors, BITS_IN_WORD) * sizeof (unsigned);
+}
+
+unsigned
+FreeMap::PickDirGroup() const
+{
+    unsigned best = 0;
+    unsigned bestFree = 0;
+    for (unsigned g = 0; g < numGroups; g++) {
+        if (groupFree[g] > bestFree) {
+            best = g;
+            bestFree = groupFree[g];
+        }
+    }
+    return GroupStart(best);
+}
+
+void
+FreeMap::Print() const
+{
+    map->Print();
+}
+
+void
+FreeMap::FetchFrom(OpenFile *file)
+{
+    ASSERT(file != nullptr);
+    flushLock->Acquire();
+    map->FetchFrom(file);
+    for (unsigned g = 0; g < numGroups; g++) {
+        groupFree[g] = 0;
+        for (unsigned i = GroupStart(g); i < GroupEnd(g); i++) {
+            if (!map->Test(i)) {
+                groupFree[g]++;
+            }
+        }
+    }
+    for (unsigned i = 0; i < numChunks; i++) {
+        dirty[i] = false;
+    }
+    flushLock->Release();
+}
+
+void
+FreeMap::WriteBack(OpenFile *file)
+{
+    ASSERT(file != nullptr);
+    flushLock->Acquire();
+    unsigned fileSize = GetFileSize();
+    for (unsigned i = 0; i < numChunks; i++) {
+        if (!dirty[i]) {
+            continue;
+        }
+        dirty[i] = false;
+        unsigned offset   = i * SECTOR_SIZE;
+        unsigned numBytes = fileSize - offset < SECTOR_SIZE
+                              ? fileSize - offset : SECTOR_SIZE;
+        map->WriteBackRange(file, offset, numBytes);
+    }
+    flushLock->Release();
+}
+
+const Bitmap *
+FreeMap::GetBitmap() const
+{
+    return map;
+}
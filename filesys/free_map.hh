@@ -0,0 +1,142 @@
+/// Mapa de sectores libres dividido en grupos de asignación.
+///
+/// El disco se parte en grupos de `TRACKS_PER_GROUP` pistas consecutivas
+/// (al estilo de los cylinder groups de FFS).  Cada archivo nuevo se ubica
+/// en el grupo de su directorio padre, y sus bloques indirectos y de datos
+/// se buscan a partir del último sector asignado, de manera que queden
+/// físicamente cerca y `Disk::TimeToSeek` tenga que mover poco el cabezal.
+///
+/// El bitmap se mantiene en memoria mientras Nachos corre.  Cada grupo tiene
+/// su propio lock, por lo que dos `Create` en grupos distintos no se
+/// serializan.  Escribir el bitmap a disco está protegido por un lock aparte.
+///
+/// Para volúmenes grandes se lleva además la cantidad de sectores libres de
+/// cada grupo, de modo que `Find` saltea los grupos llenos sin recorrerlos, y
+/// se recuerda qué sectores del archivo del bitmap cambiaron para que
+/// `WriteBack` sólo escriba esos.
+
+#ifndef NACHOS_FILESYS_FREEMAP__HH
+#define NACHOS_FILESYS_FREEMAP__HH
+
+
+#include "lib/bitmap.hh"
+#include "machine/disk.hh"
+
+class Lock;
+
+
+/// Cantidad de pistas que forman un grupo de asignación.
+static const unsigned TRACKS_PER_GROUP = 4;
+
+
+class FreeMap {
+public:
+
+    /// Crea un mapa con `nitems` sectores, todos libres.  Los grupos se
+    /// arman con `TRACKS_PER_GROUP` pistas de `sectorsPerTrack` sectores,
+    /// así quedan alineados al comienzo de una pista.
+    FreeMap(unsigned nitems, unsigned sectorsPerTrack = SECTORS_PER_TRACK);
+
+    ~FreeMap();
+
+    /// Marca un sector como usado.
+    void Mark(unsigned which);
+
+    /// Libera un sector.
+    void Clear(unsigned which);
+
+    /// Devuelve si el sector está en uso.
+    bool Test(unsigned which) const;
+
+    /// Busca un sector libre lo más cerca posible de `goal` y lo marca.
+    ///
+    /// Primero recorre el grupo de `goal` desde `goal` hacia adelante, luego
+    /// el comienzo de ese mismo grupo y por último los grupos siguientes.
+    /// Si no hay sectores libres devuelve -1.
+    ///
+    /// Con `count` mayor a 1 busca un bloque de `count` sectores libres
+    /// consecutivos, alineado a `count`, marca todos y devuelve el primero.
+    int Find(unsigned goal = 0, unsigned count = 1);
+
+    /// Busca la primera tira de `count` sectores libres consecutivos que
+    /// empiece en un sector alineado a `align` y antes de `limit`, sin
+    /// importar los grupos, y la marca.  Devuelve su primer sector o -1.
+    /// Lo usa el desfragmentador para juntar los datos de un archivo.
+    int FindRun(unsigned count, unsigned align, unsigned limit);
+
+    /// Cantidad de sectores libres en todo el disco.
+    unsigned CountClear() const;
+
+    /// Cantidad de tiras de sectores libres consecutivos.  Con el espacio
+    /// libre compactado es 1.
+    unsigned CountFreeRuns() const;
+
+    /// Cantidad de sectores libres del grupo `group`.
+    unsigned CountClearInGroup(unsigned group) const;
+
+    /// Grupo al que pertenece un sector.
+    unsigned GroupOf(unsigned sector) const;
+
+    /// Primer sector del grupo `group`.
+    unsigned GroupStart(unsigned group) const;
+
+    unsigned GetNumGroups() const;
+
+    unsigned GetSectorsPerGroup() const;
+
+    /// Tamaño en bytes del archivo que guarda el bitmap.
+    unsigned GetFileSize() const;
+
+    /// Devuelve el primer sector del grupo con más espacio libre.  Se usa
+    /// para repartir los directorios nuevos entre los grupos.
+    unsigned PickDirGroup() const;
+
+    /// Imprime el contenido del bitmap.
+    void Print() const;
+
+    /// Trae el bitmap desde el archivo que lo contiene.
+    void FetchFrom(OpenFile *file);
+
+    /// Manda a disco los sectores del bitmap que cambiaron desde la última
+    /// vez.
+    void WriteBack(OpenFile *file);
+
+    /// Bitmap subyacente.  Sólo para chequeos de consistencia.
+    const Bitmap *GetBitmap() const;
+
+private:
+
+    /// Busca un bloque de `count` sectores libres, alineado a `count`, que
+    /// empiece dentro de `[from, to)` del grupo `group` y lo marca.  Se
+    /// llama con el lock del grupo tomado.
+    int FindInRange(unsigned group, unsigned from, unsigned to,
+                    unsigned count);
+
+    /// Anota que el bit `which` cambió.
+    void SetDirty(unsigned which);
+
+    /// Último sector (exclusivo) del grupo `group`.
+    unsigned GroupEnd(unsigned group) const;
+
+    Bitmap *map;
+    unsigned numSectors;
+    unsigned numGroups;
+    unsigned sectorsPerGroup;
+
+    /// Sectores libres de cada grupo.
+    unsigned *groupFree;
+
+    /// Un booleano por cada sector del archivo del bitmap, indica si hay que
+    /// escribirlo en el próximo `WriteBack`.
+    bool *dirty;
+    unsigned numChunks;
+
+    /// Un lock por grupo, protege los bits de ese grupo.
+    Lock **groupLocks;
+
+    /// Protege la escritura del bitmap en disco.
+    Lock *flushLock;
+};
+
+
+#endif
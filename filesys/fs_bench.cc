@@ -0,0 +1,473 @@
+/// Benchmarks del sistema de archivos.
+///
+/// `PerformanceTest` (`-tf`) sólo escribe y lee un archivo en forma
+/// secuencial.  `nachos -fsbench <nombre>[:<n>[:<tamaño>]]` corre alguno de
+/// estos benchmarks, o todos con `all`:
+///
+/// * `small` -- crea, abre y borra `n` archivos de `tamaño` bytes.
+/// * `random` -- `n` escrituras y `n` lecturas de `tamaño` bytes en
+///   posiciones al azar de un archivo de `RANDOM_FILE_SIZE` bytes.
+/// * `fanout` -- crea `n` subdirectorios de un mismo directorio, entra y
+///   sale de cada uno y los borra.
+/// * `deep` -- crea un camino de `n` directorios anidados, crea y usa un
+///   archivo al final y vuelve a subir borrándolos.
+/// * `concurrent` -- `n` threads, la mitad lectores y la mitad escritores,
+///   hacen `CONCURRENT_OPS` operaciones de `tamaño` bytes sobre un mismo
+///   archivo, con el protocolo de lectores y escritores de la `fileTable`.
+/// * `lookup` -- `n` threads en un mismo directorio: la mitad crea
+///   archivos de `tamaño` bytes y la otra mitad abre y cierra archivos que
+///   ya existen, `LOOKUP_OPS` veces cada uno.
+///
+/// Cada fase imprime una línea CSV con los ticks simulados, las lecturas y
+/// escrituras de disco, las pistas recorridas por el cabezal y el tiempo
+/// real del host en microsegundos.  Las posiciones al azar salen de un
+/// generador propio con semilla fija, así que dos corridas sobre un disco
+/// recién formateado hacen exactamente lo mismo.
+///
+/// La `dirTable` nunca libera lugares, así que entre `fanout` y `deep` no
+/// pueden crearse más de `DirTable::SIZE - 1` directorios en una corrida.
+
+
+#include "file_system.hh"
+#include "open_file.hh"
+#include "lib/utility.hh"
+#include "machine/statistics.hh"
+#include "threads/system.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+
+static const unsigned RANDOM_FILE_SIZE = 16384;
+static const unsigned CONCURRENT_FILE_SIZE = 4096;
+static const unsigned CONCURRENT_OPS = 50;
+static const unsigned LOOKUP_FILES = 8;
+static const unsigned LOOKUP_OPS = 10;
+
+/// Valores por omisión de `n` y `tamaño` de cada benchmark.  Los de
+/// `fanout` y `deep` entran juntos en la `dirTable`.
+static const unsigned SMALL_FILES = 40;
+static const unsigned RANDOM_OPS = 200;
+static const unsigned FANOUT_DIRS = 10;
+static const unsigned DEEP_LEVELS = 8;
+static const unsigned CONCURRENT_THREADS = 4;
+static const unsigned LOOKUP_THREADS = 4;
+static const unsigned DEFAULT_SIZE = 64;
+
+
+/// Contadores al comienzo de una fase.
+struct Sample {
+    unsigned long ticks;
+    unsigned long reads;
+    unsigned long writes;
+    unsigned long seeks;
+    std::chrono::steady_clock::time_point wall;
+};
+
+static Sample
+TakeSample()
+{
+    Sample s;
+    s.ticks  = stats->totalTicks;
+    s.reads  = stats->numDiskReads;
+    s.writes = stats->numDiskWrites;
+    s.seeks  = stats->numDiskSeekTracks;
+    s.wall   = std::chrono::steady_clock::now();
+    return s;
+}
+
+/// Imprime la línea CSV de una fase que empezó en `from`.
+static void
+Report(const char *bench, const char *phase, unsigned n, unsigned size,
+       const Sample &from)
+{
+    Sample to = TakeSample();
+    long long wall = std::chrono::duration_cast<std::chrono::microseconds>(
+                       to.wall - from.wall).count();
+    printf("%s,%s,%u,%u,%lu,%lu,%lu,%lu,%lld\n", bench, phase, n, size,
+           to.ticks - from.ticks, to.reads - from.reads,
+           to.writes - from.writes, to.seeks - from.seeks, wall);
+}
+
+/// Generador congruencial lineal, para no depender de la semilla de `-rs`.
+static unsigned
+NextRandom(unsigned *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 16) & 0x7FFF;
+}
+
+/// Posición al azar para una operación de `size` bytes en un archivo de
+/// `length` bytes.
+static unsigned
+RandomOffset(unsigned *seed, unsigned length, unsigned size)
+{
+    return size >= length ? 0 : NextRandom(seed) % (length - size);
+}
+
+/// Cierra un archivo abierto con `FileSystem::Open`, igual que la syscall
+/// `Close`: el último que lo cierra borra el `OpenFile` y, si estaba
+/// borrado, despierta a quien espera para liberar sus sectores.
+static void
+Close(const char *name, OpenFile *file)
+{
+    fileTable->FileORLock(name, ACQUIRE);
+    bool last = fileTable->GetOpen(name) == 1;
+    fileTable->CloseOne(name);
+    if (last) {
+        if (fileTable->isDeleted(name)) {
+            fileTable->FileRemoveCondition(name, SIGNAL);
+        }
+        fileTable->SetClosed(name, true);
+        delete file;
+    }
+    fileTable->FileORLock(name, RELEASE);
+}
+
+/// Nombre del `i`-ésimo archivo o directorio de un benchmark.  Los números
+/// tienen ancho fijo porque `Directory::Find` compara por prefijo.
+static void
+MakeName(char *name, char prefix, unsigned i)
+{
+    ASSERT(i < 1000);
+    snprintf(name, FILE_NAME_MAX_LEN + 1, "%c%03u", prefix, i % 1000);
+}
+
+/// `Thread::ChangeDir` modifica el camino que recibe.
+static bool
+ChangeDir(const char *name)
+{
+    char path[FILE_NAME_MAX_LEN + 1];
+    strncpy(path, name, FILE_NAME_MAX_LEN);
+    path[FILE_NAME_MAX_LEN] = '\0';
+    return currentThread->ChangeDir(path);
+}
+
+static void
+BenchSmall(unsigned n, unsigned size)
+{
+    char name[FILE_NAME_MAX_LEN + 1];
+
+    Sample s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        MakeName(name, 's', i);
+        if (!fileSystem->Create(name, size)) {
+            fprintf(stderr, "fsbench: no se pudo crear %s\n", name);
+            return;
+        }
+    }
+    Report("small", "create", n, size, s);
+
+    s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        MakeName(name, 's', i);
+        OpenFile *file = fileSystem->Open(name);
+        ASSERT(file != nullptr);
+        Close(name, file);
+    }
+    Report("small", "open", n, size, s);
+
+    s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        MakeName(name, 's', i);
+        if (!fileSystem->Remove(name)) {
+            fprintf(stderr, "fsbench: no se pudo borrar %s\n", name);
+        }
+    }
+    Report("small", "remove", n, size, s);
+}
+
+static void
+BenchRandom(unsigned n, unsigned size)
+{
+    static const char NAME[] = "rnd";
+
+    ASSERT(size > 0 && size <= RANDOM_FILE_SIZE);
+    if (!fileSystem->Create(NAME, RANDOM_FILE_SIZE)) {
+        fprintf(stderr, "fsbench: no se pudo crear %s\n", NAME);
+        return;
+    }
+    OpenFile *file = fileSystem->Open(NAME);
+    ASSERT(file != nullptr);
+    char *buffer = new char [size];
+    memset(buffer, 'r', size);
+    unsigned seed = 1;
+
+    Sample s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        file->WriteAt(buffer, size,
+                      RandomOffset(&seed, RANDOM_FILE_SIZE, size));
+    }
+    Report("random", "write", n, size, s);
+
+    s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        file->ReadAt(buffer, size,
+                     RandomOffset(&seed, RANDOM_FILE_SIZE, size));
+    }
+    Report("random", "read", n, size, s);
+
+    delete [] buffer;
+    Close(NAME, file);
+    fileSystem->Remove(NAME);
+}
+
+static void
+BenchFanout(unsigned n, unsigned size)
+{
+    char name[FILE_NAME_MAX_LEN + 1];
+
+    ASSERT(n < DirTable::SIZE);
+    Sample s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        MakeName(name, 'o', i);
+        if (!fileSystem->MkDir(name, 0)) {
+            fprintf(stderr, "fsbench: no se pudo crear %s\n", name);
+            return;
+        }
+    }
+    Report("fanout", "mkdir", n, size, s);
+
+    s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        MakeName(name, 'o', i);
+        ASSERT(ChangeDir(name));
+        ASSERT(ChangeDir(".."));
+    }
+    Report("fanout", "chdir", n, size, s);
+
+    s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        MakeName(name, 'o', i);
+        if (!fileSystem->RemoveDir(name)) {
+            fprintf(stderr, "fsbench: no se pudo borrar %s\n", name);
+        }
+    }
+    Report("fanout", "rmdir", n, size, s);
+}
+
+static void
+BenchDeep(unsigned n, unsigned size)
+{
+    static const char LEAF[] = "leaf";
+    char name[FILE_NAME_MAX_LEN + 1];
+
+    ASSERT(n > 0 && n < DirTable::SIZE && n < MAX_DIRS - 1);
+    Sample s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        MakeName(name, 'p', i);
+        if (!fileSystem->MkDir(name, 0) || !ChangeDir(name)) {
+            fprintf(stderr, "fsbench: no se pudo entrar a %s\n", name);
+            return;
+        }
+    }
+    Report("deep", "descend", n, size, s);
+
+    s = TakeSample();
+    char *buffer = new char [size];
+    memset(buffer, 'd', size);
+    if (fileSystem->Create(LEAF, 0)) {
+        OpenFile *file = fileSystem->Open(LEAF);
+        ASSERT(file != nullptr);
+        file->WriteAt(buffer, size, 0);
+        file->ReadAt(buffer, size, 0);
+        Close(LEAF, file);
+        fileSystem->Remove(LEAF);
+    } else {
+        fprintf(stderr, "fsbench: no se pudo crear %s\n", LEAF);
+    }
+    delete [] buffer;
+    Report("deep", "leaf", n, size, s);
+
+    // Se sube borrando cada directorio ya vacío.
+    s = TakeSample();
+    for (unsigned i = n; i-- > 0;) {
+        MakeName(name, 'p', i);
+        ASSERT(ChangeDir(".."));
+        if (!fileSystem->RemoveDir(name)) {
+            fprintf(stderr, "fsbench: no se pudo borrar %s\n", name);
+        }
+    }
+    Report("deep", "ascend", n, size, s);
+}
+
+static const char SHARED_NAME[] = "shared";
+
+struct Worker {
+    unsigned index;
+    unsigned size;
+};
+
+/// Cuerpo de cada thread de `concurrent`.  Los de índice par leen y los de
+/// índice impar escriben.
+static void
+ConcurrentWorker(void *arg)
+{
+    Worker *w = (Worker *) arg;
+    OpenFile *file = fileSystem->Open(SHARED_NAME);
+    ASSERT(file != nullptr);
+
+    char *buffer = new char [w->size];
+    memset(buffer, 'a' + w->index % 26, w->size);
+    unsigned seed = w->index + 1;
+    for (unsigned i = 0; i < CONCURRENT_OPS; i++) {
+        unsigned offset = RandomOffset(&seed, CONCURRENT_FILE_SIZE, w->size);
+        if (w->index % 2 == 0) {
+            fileTable->LockedReadAt(SHARED_NAME, buffer, w->size, offset);
+        } else {
+            fileTable->LockedWriteAt(SHARED_NAME, buffer, w->size, offset);
+        }
+    }
+    delete [] buffer;
+    Close(SHARED_NAME, file);
+    currentThread->Finish();
+}
+
+static void
+BenchConcurrent(unsigned n, unsigned size)
+{
+    ASSERT(n > 0);
+    ASSERT(size > 0 && size <= CONCURRENT_FILE_SIZE);
+    if (!fileSystem->Create(SHARED_NAME, CONCURRENT_FILE_SIZE)) {
+        fprintf(stderr, "fsbench: no se pudo crear %s\n", SHARED_NAME);
+        return;
+    }
+
+    Thread **threads = new Thread * [n];
+    Worker *workers = new Worker [n];
+    Sample s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        workers[i].index = i;
+        workers[i].size  = size;
+        threads[i] = new Thread("FsBench", true);
+        int pid = space_table->Add(threads[i]);
+        ASSERT(pid != -1);
+        threads[i]->SetPid(pid);
+        threads[i]->Fork(ConcurrentWorker, &workers[i]);
+    }
+    for (unsigned i = 0; i < n; i++) {
+        threads[i]->Join();
+    }
+    Report("concurrent", "rw", n, size, s);
+
+    delete [] workers;
+    delete [] threads;
+    fileSystem->Remove(SHARED_NAME);
+}
+
+/// Cuerpo de cada thread de `lookup`.  Los de índice par abren y cierran
+/// archivos que ya existen y los de índice impar crean archivos nuevos.
+static void
+LookupWorker(void *arg)
+{
+    Worker *w = (Worker *) arg;
+    char name[FILE_NAME_MAX_LEN + 1];
+    for (unsigned i = 0; i < LOOKUP_OPS; i++) {
+        if (w->index % 2 == 0) {
+            MakeName(name, 'l', (w->index + i) % LOOKUP_FILES);
+            OpenFile *file = fileSystem->Open(name);
+            ASSERT(file != nullptr);
+            Close(name, file);
+        } else {
+            MakeName(name, 'c', w->index / 2 * LOOKUP_OPS + i);
+            if (!fileSystem->Create(name, w->size)) {
+                fprintf(stderr, "fsbench: no se pudo crear %s\n", name);
+            }
+        }
+    }
+    currentThread->Finish();
+}
+
+static void
+BenchLookup(unsigned n, unsigned size)
+{
+    ASSERT(n > 0);
+    char name[FILE_NAME_MAX_LEN + 1];
+    for (unsigned i = 0; i < LOOKUP_FILES; i++) {
+        MakeName(name, 'l', i);
+        if (!fileSystem->Create(name, size)) {
+            fprintf(stderr, "fsbench: no se pudo crear %s\n", name);
+            return;
+        }
+    }
+
+    Thread **threads = new Thread * [n];
+    Worker *workers = new Worker [n];
+    Sample s = TakeSample();
+    for (unsigned i = 0; i < n; i++) {
+        workers[i].index = i;
+        workers[i].size  = size;
+        threads[i] = new Thread("FsBench", true);
+        int pid = space_table->Add(threads[i]);
+        ASSERT(pid != -1);
+        threads[i]->SetPid(pid);
+        threads[i]->Fork(LookupWorker, &workers[i]);
+    }
+    for (unsigned i = 0; i < n; i++) {
+        threads[i]->Join();
+    }
+    Report("lookup", "mixed", n, size, s);
+
+    for (unsigned i = 0; i < LOOKUP_FILES; i++) {
+        MakeName(name, 'l', i);
+        fileSystem->Remove(name);
+    }
+    for (unsigned i = 0; i < n / 2 * LOOKUP_OPS; i++) {
+        MakeName(name, 'c', i);
+        fileSystem->Remove(name);
+    }
+    delete [] workers;
+    delete [] threads;
+}
+
+void
+FsBench(const char *spec)
+{
+    ASSERT(spec != nullptr);
+
+    char bench[16];
+    unsigned n = 0, size = DEFAULT_SIZE;
+    if (sscanf(spec, "%15[^:]:%u:%u", bench, &n, &size) < 1) {
+        fprintf(stderr, "fsbench: benchmark inválido %s\n", spec);
+        return;
+    }
+    // Con `all` cada benchmark usa su `n` por omisión.
+    bool all = !strcmp(bench, "all");
+    if (all) {
+        n = 0;
+    }
+
+    printf("bench,phase,n,size,ticks,disk_reads,disk_writes,seek_tracks,"
+           "wall_us\n");
+    bool found = false;
+    if (all || !strcmp(bench, "small")) {
+        BenchSmall(n ? n : SMALL_FILES, size);
+        found = true;
+    }
+    if (all || !strcmp(bench, "random")) {
+        BenchRandom(n ? n : RANDOM_OPS, size);
+        found = true;
+    }
+    if (all || !strcmp(bench, "fanout")) {
+        BenchFanout(n ? n : FANOUT_DIRS, size);
+        found = true;
+    }
+    if (all || !strcmp(bench, "deep")) {
+        BenchDeep(n ? n : DEEP_LEVELS, size);
+        found = true;
+    }
+    if (all || !strcmp(bench, "concurrent")) {
+        BenchConcurrent(n ? n : CONCURRENT_THREADS, size);
+        found = true;
+    }
+    if (all || !strcmp(bench, "lookup")) {
+        BenchLookup(n ? n : LOOKUP_THREADS, size);
+        found = true;
+    }
+    if (!found) {
+        fprintf(stderr, "fsbench: no existe el benchmark %s\n", bench);
+    }
+}
@@ -62,7 +62,7 @@ Copy(const char *from, const char *to)
     OpenFile *openFile = fileSystem->Open(to);
     DEBUG('f', "Testeando el directorio antes de Haltear\n");
     Directory *dir = new Directory(dirTable->GetNumEntries("root"));
-    Bitmap *freeMap = new Bitmap(NUM_SECTORS);
+    Bitmap *freeMap = new Bitmap(fileSystem->GetNumSectors());
     OpenFile* freeMapFile = new OpenFile(0);
     freeMap->FetchFrom(freeMapFile);
     dir->FetchFrom(dirTable->GetDir("root"));
@@ -75,7 +75,10 @@ Copy(const char *from, const char *to)
     while ((amountRead = fread(buffer, sizeof(char),
                                TRANSFER_SIZE, fp)) > 0){
         DEBUG('f', "Voy a escribir %u bytes\n", amountRead);
-        openFile->Write(buffer, amountRead);
+        if (openFile->Write(buffer, amountRead) < amountRead) {
+            printf("Copy: no space left to write file %s\n", to);
+            break;
+        }
     }
     delete [] buffer;
 
@@ -97,7 +100,7 @@ Copy(const char *from, const char *to)
     DEBUG('f', "Abro bitmap y directorios nuevos antes terminar para checkear:\n");
     OpenFile* lastFreeMapFile = new OpenFile(0);
     Directory *lastDir = new Directory(dirTable->GetNumEntries("root"));
-    Bitmap* lastFreeMap = new Bitmap(NUM_SECTORS);
+    Bitmap* lastFreeMap = new Bitmap(fileSystem->GetNumSectors());
     lastFreeMap->FetchFrom(lastFreeMapFile);
     lastFreeMap->Print();
     lastDir->FetchFrom(dirTable->GetDir("root"));
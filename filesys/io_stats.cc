@@ -0,0 +1,88 @@
+/// Rutinas de los contadores de entrada/salida.
+///
+/// Ver `io_stats.hh`.
+
+
+#include "io_stats.hh"
+#include "lib/list.hh"
+#include "threads/system.hh"
+#include "threads/thread_map.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+
+/// Contadores de un thread que ya terminó.
+struct RetiredIo {
+    char name[32];
+    int pid;
+    IoStats io;
+};
+
+static List<RetiredIo *> retired;
+
+IoStats::IoStats()
+{
+    readBytes = writtenBytes = 0;
+    diskReads = diskWrites = 0;
+    cacheHits = 0;
+    waitTicks = 0;
+}
+
+bool
+IoStats::IsEmpty() const
+{
+    return readBytes == 0 && writtenBytes == 0
+             && diskReads == 0 && diskWrites == 0 && cacheHits == 0;
+}
+
+void
+IoStats::Print(const char *title) const
+{
+    printf("    %s: read %lu bytes, written %lu bytes, disk reads %lu, "
+           "disk writes %lu, cache hits %lu, wait %lu ticks\n",
+           title, readBytes, writtenBytes, diskReads, diskWrites,
+           cacheHits, waitTicks);
+}
+
+void
+RetireIoStats(const char *name, int pid, const IoStats &io)
+{
+    RetiredIo *r = new RetiredIo;
+    strncpy(r->name, name, sizeof r->name - 1);
+    r->name[sizeof r->name - 1] = '\0';
+    r->pid = pid;
+    r->io = io;
+    retired.Append(r);
+}
+
+static void
+PrintProcess(const char *name, int pid, const IoStats &io)
+{
+    if (io.IsEmpty()) {
+        return;
+    }
+    char title[64];
+    snprintf(title, sizeof title, "%d (%s)", pid, name);
+    io.Print(title);
+}
+
+void
+PrintIoStats()
+{
+    printf("I/O by file:\n");
+    fileTable->PrintIoStats();
+
+    printf("I/O by process:\n");
+    while (!retired.IsEmpty()) {
+        RetiredIo *r = retired.Pop();
+        PrintProcess(r->name, r->pid, r->io);
+        delete r;
+    }
+    for (unsigned pid = 0; pid < Table<Thread *>::SIZE; pid++) {
+        Thread *t = space_table->Get(pid);
+        if (t != nullptr) {
+            PrintProcess(t->GetName(), pid, t->io);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/// Contadores de entrada/salida por archivo y por proceso.
+///
+/// `Statistics` sólo lleva los totales del disco.  Para saber quién genera
+/// el tráfico, cada archivo de la `fileTable` (en su `fileStruct`) y cada
+/// thread llevan además sus propios `IoStats`:
+///
+/// * `SynchDisk` carga cada pedido al disco, con los ticks que el thread
+///   estuvo esperando (haciendo cola por el disco y mientras lo atendía),
+///   al thread actual y al archivo que éste está leyendo o escribiendo
+///   (`Thread::ioFile`, que ponen `OpenFile::ReadAt` y `WriteAt`).
+/// * `OpenFile` carga los bytes transferidos y las páginas que encontró en
+///   la caché.
+///
+/// Al apagar la máquina se imprimen los contadores de cada archivo y de
+/// cada proceso, y la syscall `GetIoStats` devuelve los de un archivo
+/// abierto o los del proceso que la llama.
+
+#ifndef NACHOS_FILESYS_IOSTATS__HH
+#define NACHOS_FILESYS_IOSTATS__HH
+
+
+struct IoStats {
+    unsigned long readBytes;     ///< Bytes leídos con `ReadAt`.
+    unsigned long writtenBytes;  ///< Bytes escritos con `WriteAt`.
+    unsigned long diskReads;     ///< Pedidos de lectura al disco.
+    unsigned long diskWrites;    ///< Pedidos de escritura al disco.
+    unsigned long cacheHits;     ///< Páginas leídas de la caché.
+    unsigned long waitTicks;     ///< Ticks esperando al disco.
+
+    /// Todo en cero.
+    IoStats();
+
+    /// Si no hubo ninguna actividad.
+    bool IsEmpty() const;
+
+    /// Imprime una línea con los contadores, precedida por `title`.
+    void Print(const char *title) const;
+};
+
+/// Guarda los contadores de un thread que termina, para imprimirlos al
+/// apagar la máquina.
+void RetireIoStats(const char *name, int pid, const IoStats &io);
+
+/// Imprime los contadores de los archivos de la `fileTable` y de los
+/// procesos, terminados o no.
+void PrintIoStats();
+
+
+#endif
@@ -27,6 +27,7 @@ OpenFile::OpenFile(int sector)
     hdr->FetchFrom(sector);
     seekPosition = 0;
     hdrSector = sector;
+    io = nullptr;
 }
 
 /// Close a Nachos file, de-allocating any in-memory data structures.
@@ -51,6 +52,18 @@ OpenFile::GetFileHeader()
     return hdr;
 }
 
+unsigned
+OpenFile::GetSector() const
+{
+    return hdrSector;
+}
+
+void
+OpenFile::SetIoStats(IoStats *counters)
+{
+    io = counters;
+}
+
 /// OpenFile::Read/Write
 ///
 /// Read/write a portion of a file, starting from `seekPosition`.  Return the
@@ -112,6 +125,22 @@ OpenFile::Write(const char *into, unsigned numBytes)
 
 int
 OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
+{
+    // Los pedidos al disco que se hagan mientras tanto son de este archivo.
+    IoStats *outer = currentThread->ioFile;
+    currentThread->ioFile = io;
+    int result = ReadBlocks(into, numBytes, position);
+    currentThread->ioFile = outer;
+
+    currentThread->io.readBytes += result;
+    if (io != nullptr) {
+        io->readBytes += result;
+    }
+    return result;
+}
+
+int
+OpenFile::ReadBlocks(char *into, unsigned numBytes, unsigned position)
 {
     ASSERT(into != nullptr);
     
@@ -127,7 +156,9 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
         return 0;
 
     unsigned fileLength = hdr->FileLength();
-    unsigned firstSector, lastSector, numSectors;
+    unsigned blockSize = FileHeader::GetBlockSize();
+    unsigned sectorsPerBlock = FileHeader::GetSectorsPerBlock();
+    unsigned firstBlock, lastBlock, numBlocks;
     char *buf;
 
     if (position > fileLength) {
@@ -141,19 +172,47 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
     DEBUG('f', "Reading %u bytes at %u, from file of length %u.\n",
           numBytes, position, fileLength);
 
-    firstSector = DivRoundDown(position, SECTOR_SIZE);
-    lastSector = DivRoundDown(position + numBytes - 1, SECTOR_SIZE);
-    numSectors = 1 + lastSector - firstSector;
-
-    // Read in all the full and partial sectors that we need.
-    buf = new char [numSectors * SECTOR_SIZE];
-    for (unsigned i = firstSector; i <= lastSector; i++) {
-        synchDisk->ReadSector(hdr->ByteToSector(i * SECTOR_SIZE),
-                              &buf[(i - firstSector) * SECTOR_SIZE]);
+    firstBlock = DivRoundDown(position, blockSize);
+    lastBlock = DivRoundDown(position + numBytes - 1, blockSize);
+    numBlocks = 1 + lastBlock - firstBlock;
+
+    // Read in all the full and partial blocks that we need, each one with a
+    // single disk request.
+    buf = new char [numBlocks * blockSize];
+    for (unsigned i = firstBlock; i <= lastBlock; i++) {
+        char *block = &buf[(i - firstBlock) * blockSize];
+
+        #ifdef PAGE_CACHE
+        // Si todas las páginas del bloque están en la caché no se va al
+        // disco.  Una página de archivo es uno de sus sectores.
+        unsigned cached = 0;
+        while (cached < sectorsPerBlock
+                 && pageCache->Read(hdrSector, i * sectorsPerBlock + cached,
+                                    &block[cached * SECTOR_SIZE])) {
+            cached++;
+        }
+        currentThread->io.cacheHits += cached;
+        if (io != nullptr) {
+            io->cacheHits += cached;
+        }
+        if (cached == sectorsPerBlock) {
+            continue;
+        }
+        #endif
+
+        synchDisk->ReadSectors(hdr->ByteToSector(i * blockSize),
+                               sectorsPerBlock, block);
+
+        #ifdef PAGE_CACHE
+        for (unsigned j = 0; j < sectorsPerBlock; j++) {
+            pageCache->Insert(hdrSector, i * sectorsPerBlock + j,
+                              &block[j * SECTOR_SIZE]);
+        }
+        #endif
     }
 
     // Copy the part we want.
-    memcpy(into, &buf[position - firstSector * SECTOR_SIZE], numBytes);
+    memcpy(into, &buf[position - firstBlock * blockSize], numBytes);
     delete [] buf;
     return numBytes;
 }
@@ -165,7 +224,9 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     ASSERT(numBytes > 0);
 
     unsigned fileLength = hdr->FileLength();
-    unsigned firstSector, lastSector, numSectors, neededSectors;
+    unsigned blockSize = FileHeader::GetBlockSize();
+    unsigned sectorsPerBlock = FileHeader::GetSectorsPerBlock();
+    unsigned firstBlock, lastBlock, numBlocks, neededBlocks, newLength;
     bool firstAligned, lastAligned;
     char *buf;
 
@@ -181,31 +242,45 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     DEBUG('f', "Writing %u bytes at %u, from file of length %u.\n",
           numBytes, position, fileLength);
 
-    firstSector = DivRoundDown(position, SECTOR_SIZE);
-    lastSector  = DivRoundDown(position + numBytes - 1, SECTOR_SIZE); // El -1 es porque cuenta la posición actual.
-    neededSectors = DivRoundUp(hdr->GetRaw()->numBytes + numBytes, SECTOR_SIZE) - hdr->GetRaw()->numSectors; 
-    numSectors  = 1 + lastSector - firstSector;
+    IoStats *outer = currentThread->ioFile;
+    currentThread->ioFile = io;
+
+    firstBlock = DivRoundDown(position, blockSize);
+    lastBlock  = DivRoundDown(position + numBytes - 1, blockSize); // El -1 es porque cuenta la posición actual.
+    // El archivo crece sólo si se escribe más allá del final, y puede tener
+    // bloques reservados de antes con `Allocate`.
+    newLength = position + numBytes > fileLength ? position + numBytes
+                                                 : fileLength;
+    neededBlocks = DivRoundUp(newLength, blockSize);
+    neededBlocks = neededBlocks > hdr->GetRaw()->numSectors
+                     ? neededBlocks - hdr->GetRaw()->numSectors : 0;
+    numBlocks  = 1 + lastBlock - firstBlock;
 
     // Si escribo al final, tengo que hacer espacio.
     // La concurrencia se da ya que esto está atomizado por fuera.
     // El proceso que llama a WriteAt solo puede escribir si es 
     // el único manipulando el archivo.
-    DEBUG('f', "El ultimo sector es %u y la cantidad de sectores es %u\n", lastSector, hdr->GetRaw()->numSectors); 
+    DEBUG('f', "El ultimo bloque es %u y la cantidad de bloques es %u\n", lastBlock, hdr->GetRaw()->numSectors); 
     
     bool addedSectors = false;
-    if (neededSectors > 0 && hdrSector != 0){
-        DEBUG('f',"Agrego sectores ya que necesito %u sectores más\n", neededSectors);
-        hdr->AddSectors(hdrSector, neededSectors, numBytes);
-        hdr->ChangeLength(fileLength + numBytes);
+    if (neededBlocks > 0 && hdrSector != 0){
+        DEBUG('f',"Agrego bloques ya que necesito %u bloques más\n", neededBlocks);
+        if (!hdr->AddSectors(hdrSector, neededBlocks,
+                             newLength - fileLength)) {
+            // No hay lugar en el disco: el archivo queda como estaba.
+            currentThread->ioFile = outer;
+            return 0;
+        }
+        hdr->ChangeLength(newLength);
         hdr->WriteBack(hdrSector);
         addedSectors = true;
     }
    
 
-    buf = new char [numSectors * SECTOR_SIZE];
+    buf = new char [numBlocks * blockSize];
 
-    firstAligned = position == firstSector * SECTOR_SIZE;
-    lastAligned  = position + numBytes == (lastSector + 1) * SECTOR_SIZE;
+    firstAligned = position == firstBlock * blockSize;
+    lastAligned  = position + numBytes == (lastBlock + 1) * blockSize;
     
 
     // Read in first and last sector, if they are to be partially modified.
@@ -213,32 +288,79 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     // para mantenerlos en la escritura.
     // Fueron modificados parcialmente entones quiero mantener lo que tenían.
     if (!firstAligned) {
-        ReadAt(buf, SECTOR_SIZE, firstSector * SECTOR_SIZE);
+        ReadBlocks(buf, blockSize, firstBlock * blockSize);
     }
-    if (!lastAligned && (firstSector != lastSector || firstAligned)) {
-        ReadAt(&buf[(lastSector - firstSector) * SECTOR_SIZE],
-               SECTOR_SIZE, lastSector * SECTOR_SIZE);
+    if (!lastAligned && (firstBlock != lastBlock || firstAligned)) {
+        ReadBlocks(&buf[(lastBlock - firstBlock) * blockSize],
+                   blockSize, lastBlock * blockSize);
     }
 
     // Copy in the bytes we want to change.
-    memcpy(&buf[position - firstSector * SECTOR_SIZE], from, numBytes);
-
-    // Write modified sectors back.
-    for (unsigned i = firstSector; i <= lastSector; i++) {
-        synchDisk->WriteSector(hdr->ByteToSector(i * SECTOR_SIZE),
-                               &buf[(i - firstSector) * SECTOR_SIZE]);
+    memcpy(&buf[position - firstBlock * blockSize], from, numBytes);
+
+    // Write modified blocks back, each one with a single disk request.
+    for (unsigned i = firstBlock; i <= lastBlock; i++) {
+        char *block = &buf[(i - firstBlock) * blockSize];
+        synchDisk->WriteSectors(hdr->ByteToSector(i * blockSize),
+                                sectorsPerBlock, block);
+
+        // La caché se escribe de paso, así nunca queda sucia.
+        #ifdef PAGE_CACHE
+        for (unsigned j = 0; j < sectorsPerBlock; j++) {
+            pageCache->Update(hdrSector, i * sectorsPerBlock + j,
+                              &block[j * SECTOR_SIZE]);
+        }
+        #endif
     }
     delete [] buf;
     
     // En el 0 está el FREE_MAP_SECTOR.
     // No hay que cambiar el tamaño del bitmap.
     if (hdrSector != 0 && !addedSectors){
-        hdr->ChangeLength(hdr->FileLength() + numBytes);
+        hdr->ChangeLength(newLength);
         hdr->WriteBack(hdrSector);
     }
+
+    currentThread->ioFile = outer;
+    currentThread->io.writtenBytes += numBytes;
+    if (io != nullptr) {
+        io->writtenBytes += numBytes;
+    }
     return numBytes;
 }
 
+bool
+OpenFile::Truncate(unsigned length)
+{
+    FreeMap *freeMap = fileSystem->GetFreeMap();
+    if (!hdr->Truncate(freeMap, length)) {
+        return false;
+    }
+    hdr->WriteBack(hdrSector);
+    freeMap->WriteBack(fileTable->GetFile("freeMap"));
+
+    // Las páginas que quedaron afuera no se pueden volver a leer de la
+    // caché si el archivo vuelve a crecer.
+    #ifdef PAGE_CACHE
+    pageCache->Invalidate(hdrSector,
+                          DivRoundUp(length, FileHeader::GetBlockSize())
+                            * FileHeader::GetSectorsPerBlock());
+    #endif
+    return true;
+}
+
+bool
+OpenFile::Allocate(unsigned length)
+{
+    FreeMap *freeMap = fileSystem->GetFreeMap();
+    if (!hdr->Reserve(freeMap, hdrSector, length)) {
+        return false;
+    }
+    hdr->WriteBack(hdrSector);
+    freeMap->WriteBack(fileTable->GetFile("freeMap"));
+    return true;
+}
+
 /// Return the number of bytes in the file.
 unsigned
 OpenFile::Length() const
@@ -85,6 +85,7 @@ private:
 
 #else // FILESYS
 class FileHeader;
+struct IoStats;
 
 class OpenFile {
 public:
@@ -97,6 +98,9 @@ public:
     
     /// Trae el FileHeader.
     FileHeader* GetFileHeader();
+
+    /// Sector donde está el header del archivo.
+    unsigned GetSector() const;
     
     /// Set the position from which to start reading/writing -- UNIX `lseek`.
     void Seek(unsigned position);
@@ -116,8 +120,25 @@ public:
     // the UNIX idiom -- `lseek` to end of file, `tell`, `lseek` back).
     unsigned Length() const;
 
+    /// Achica el archivo a `length` bytes y libera los bloques que sobran.
+    /// Devuelve false si `length` es mayor que el tamaño actual.
+    bool Truncate(unsigned length);
+
+    /// Reserva lugar en el disco para los primeros `length` bytes sin
+    /// cambiar el tamaño.  Devuelve false si no hay lugar.
+    bool Allocate(unsigned length);
+
+    /// Contadores de entrada/salida a los que se cargan las lecturas y
+    /// escrituras; los pone la `fileTable`.
+    void SetIoStats(IoStats *counters);
+
   private:
+    /// Lee los bloques sin cargar los bytes a los contadores; `WriteAt` la
+    /// usa para completar los bloques que escribe en parte.
+    int ReadBlocks(char *into, unsigned numBytes, unsigned position);
+
     FileHeader *hdr;  ///< Header for this file.
+    IoStats *io;  ///< Contadores del archivo, o null.
     unsigned seekPosition;  ///< Current position within the file.
     unsigned hdrSector; ///< Sector donde está el header del archivo.
 };
@@ -0,0 +1,71 @@
+/// Rutinas de la caché de páginas de archivos.
+///
+/// Ver `page_cache.hh`.
+
+
+#include "page_cache.hh"
+#include "threads/system.hh"
+
+#include <string.h>
+
+
+PageCache::PageCache()
+{
+    ASSERT(core_map != nullptr);
+}
+
+bool
+PageCache::Read(unsigned fileSector, unsigned page, char *into)
+{
+    ASSERT(into != nullptr);
+
+    int frame = core_map->FindFile(fileSector, page);
+    if (frame == -1) {
+        stats->numPageCacheMisses++;
+        return false;
+    }
+    core_map->Touch(frame);
+    memcpy(into, &machine->mainMemory[frame * PAGE_SIZE], PAGE_SIZE);
+    stats->numPageCacheHits++;
+    return true;
+}
+
+void
+PageCache::Insert(unsigned fileSector, unsigned page, const char *from)
+{
+    ASSERT(from != nullptr);
+
+    int frame = core_map->FindFile(fileSector, page);
+    if (frame == -1) {
+        frame = core_map->FindForFile(fileSector, page);
+    }
+    if (frame == -1) {
+        DEBUG('f', "Sin marcos para la página %u del archivo %u.\n",
+              page, fileSector);
+        return;
+    }
+    memcpy(&machine->mainMemory[frame * PAGE_SIZE], from, PAGE_SIZE);
+}
+
+void
+PageCache::Update(unsigned fileSector, unsigned page, const char *from)
+{
+    ASSERT(from != nullptr);
+
+    int frame = core_map->FindFile(fileSector, page);
+    if (frame != -1) {
+        core_map->Touch(frame);
+        memcpy(&machine->mainMemory[frame * PAGE_SIZE], from, PAGE_SIZE);
+    }
+}
+
+void
+PageCache::Invalidate(unsigned fileSector, unsigned firstPage)
+{
+    for (unsigned i = 0; i < core_map->GetSize(); i++) {
+        if (core_map->IsFilePage(i) && core_map->GetFileSector(i) == fileSector
+              && core_map->GetFilePage(i) >= firstPage) {
+            core_map->Clear(i);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/// Caché de páginas de archivos, unificada con la memoria virtual.
+///
+/// Las páginas de archivo se guardan en marcos de la memoria física,
+/// registrados en el `core_map` con dueño `OWNER_FILE` (sector del header
+/// y número de página) al lado de los de los procesos.  Así los datos de
+/// archivos y las páginas de los procesos compiten por la misma memoria:
+/// la caché usa los marcos libres y los procesos le reclaman marcos cuando
+/// no quedan (ver `CoreMap::FindReclaiming`), y con swap el reemplazo elige
+/// entre ambas.
+///
+/// `OpenFile::ReadAt` se sirve de la caché, y con ella la carga por
+/// demanda de los ejecutables (`AddressSpace::LoadPage`).  Las escrituras
+/// van al disco en el momento y actualizan la copia, así una página de
+/// archivo nunca está sucia y se puede descartar sin escribirla.
+///
+/// Como `PAGE_SIZE` es igual a `SECTOR_SIZE`, una página de archivo es un
+/// sector de sus datos.
+
+#ifndef NACHOS_FILESYS_PAGECACHE__HH
+#define NACHOS_FILESYS_PAGECACHE__HH
+
+
+class PageCache {
+public:
+
+    PageCache();
+
+    /// Copia en `into` la página `page` del archivo cuyo header está en
+    /// `fileSector`.  Devuelve falso si no está en la caché.
+    bool Read(unsigned fileSector, unsigned page, char *into);
+
+    /// Guarda una página recién leída del disco.  Si no hay marcos libres
+    /// reusa el de otra página de archivo; si todos son de procesos, no la
+    /// guarda.
+    void Insert(unsigned fileSector, unsigned page, const char *from);
+
+    /// Actualiza la copia de una página que se escribió, si la hay.
+    void Update(unsigned fileSector, unsigned page, const char *from);
+
+    /// Descarta las páginas de un archivo a partir de `firstPage`.  Se
+    /// llama cuando su sector de header pasa a ser de un archivo nuevo
+    /// (todas) o cuando se trunca (las que quedan afuera).
+    void Invalidate(unsigned fileSector, unsigned firstPage = 0);
+};
+
+
+#endif
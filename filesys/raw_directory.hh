@@ -9,6 +9,11 @@
 
 class DirectoryEntry;
 
+/// Cantidad de entradas que se leen de un directorio que todavía no está
+/// en la `dirTable`.  Sus entradas en uso están al comienzo y se cuentan
+/// hasta la primera libre.
+static const unsigned MAX_DIR_ENTRIES = 50;
+
 struct RawDirectory {
     unsigned tableSize;  ///< Number of directory entries.
     DirectoryEntry *table;  ///< Table of pairs:
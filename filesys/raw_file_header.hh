@@ -7,6 +7,7 @@
 #define NACHOS_FILESYS_RAWFILEHEADER__HH
 
 
+#include "raw_indirect_node.hh"
 #include "machine/disk.hh"
 
 static const unsigned NUM_INDIRECT
@@ -16,13 +17,15 @@ static const unsigned NUM_INDIRECT
 //const unsigned MAX_FILE_SIZE = NUM_DIRECT * SECTOR_SIZE; // El tamaño máximo de un archivo es 3840 Bytes.
 
 // Utilizadas para el ejercicio 2 de FileSystem.
-static const unsigned MAGIC_SIZE = sizeof (int);
-static const unsigned DISK_SIZE = MAGIC_SIZE + NUM_SECTORS * SECTOR_SIZE;
-const unsigned MAX_FILE_SIZE = DISK_SIZE;
+// Con doble indirección el límite lo pone el header y no el disco, que
+// ahora puede tener cualquier tamaño.
+const unsigned MAX_FILE_SIZE
+  = NUM_INDIRECT * NUM_DIRECT * NUM_DIRECT * SECTOR_SIZE;
 
 struct RawFileHeader {
     unsigned numBytes;  ///< Number of bytes in the file.
-    unsigned numSectors;  ///< Number of data sectors in the file.
+    unsigned numSectors;  ///< Number of data blocks in the file (de
+                          ///< `FileHeader::GetSectorsPerBlock` sectores).
     
     // Esto es lo máximo que puede almacenar el fileHeader.
     // Si se quiere aumentar se deben hacer NUM_DIRECT pointers
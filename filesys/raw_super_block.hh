@@ -0,0 +1,37 @@
+/// Superbloque del sistema de archivos.
+///
+/// Guarda la geometría con la que se formateó el disco y los tamaños que
+/// dependen de ella, para poder montarlo sin depender de constantes de
+/// compilación.
+
+#ifndef NACHOS_FILESYS_RAWSUPERBLOCK__HH
+#define NACHOS_FILESYS_RAWSUPERBLOCK__HH
+
+
+/// Sectors containing the file headers for the bitmap of free sectors, and
+/// the directory of files.  These file headers are placed in well-known
+/// sectors, so that they can be located on boot-up.
+static const unsigned FREE_MAP_SECTOR = 0;
+static const unsigned DIRECTORY_SECTOR = 1;
+
+/// Sector del superbloque, con la geometría del disco.
+static const unsigned SUPER_BLOCK_SECTOR = 2;
+
+/// Número mágico para reconocer un superbloque válido.  Los discos
+/// formateados antes de tener superbloque no lo tienen.
+static const unsigned SUPER_BLOCK_MAGIC = 0x4E414348;
+
+struct RawSuperBlock {
+    unsigned magic;            ///< `SUPER_BLOCK_MAGIC`.
+    unsigned sectorSize;       ///< Bytes por sector.
+    unsigned sectorsPerTrack;  ///< Sectores por pista.
+    unsigned numTracks;        ///< Cantidad de pistas.
+    unsigned numSectors;       ///< Cantidad total de sectores.
+    unsigned tracksPerGroup;   ///< Pistas por grupo de asignación.
+    unsigned freeMapSize;      ///< Tamaño en bytes del archivo del bitmap.
+    unsigned sectorsPerBlock;  ///< Sectores por bloque de datos.  0 en
+                               ///< discos anteriores, equivale a 1.
+};
+
+
+#endif
@@ -14,6 +14,7 @@
 
 
 #include "synch_disk.hh"
+#include "threads/system.hh"
 
 
 /// Disk interrupt handler.  Need this to be a C routine, because C++ cannot
@@ -31,11 +32,14 @@ DiskRequestDone(void *arg)
 ///
 /// * `name` is a UNIX file name to be used as storage for the disk data
 ///   (usually, `DISK`).
-SynchDisk::SynchDisk(const char *name)
+/// * `sectorsPerTrack` y `numTracks` son la geometría con la que crear el
+///   disco, o 0 para usar la que ya tiene.
+SynchDisk::SynchDisk(const char *name, unsigned sectorsPerTrack,
+                     unsigned numTracks)
 {
     semaphore = new Semaphore("synch disk", 0);
     lock = new Lock("synch disk lock");
-    disk = new Disk(name, DiskRequestDone, this);
+    disk = new Disk(name, DiskRequestDone, this, sectorsPerTrack, numTracks);
 }
 
 /// De-allocate data structures needed for the synchronous disk abstraction.
@@ -53,13 +57,23 @@ SynchDisk::~SynchDisk()
 /// * `data` is the buffer to hold the contents of the disk sector.
 void
 SynchDisk::ReadSector(int sectorNumber, char *data)
+{
+    ReadSectors(sectorNumber, 1, data);
+}
+
+/// Read `count` consecutive sectors into a buffer with a single disk request.
+/// Return only after the data has been read.
+void
+SynchDisk::ReadSectors(int sectorNumber, unsigned count, char *data)
 {
     ASSERT(data != nullptr);
 
+    unsigned long since = stats->totalTicks;
     lock->Acquire();  // Only one disk I/O at a time.
-    disk->ReadRequest(sectorNumber, data);
+    disk->ReadRequest(sectorNumber, data, count);
     semaphore->P();   // Wait for interrupt.
     lock->Release();
+    Charge(false, since);
 }
 
 /// Write the contents of a buffer into a disk sector.  Return only
@@ -69,13 +83,43 @@ SynchDisk::ReadSector(int sectorNumber, char *data)
 /// * `data` are the new contents of the disk sector.
 void
 SynchDisk::WriteSector(int sectorNumber, const char *data)
+{
+    WriteSectors(sectorNumber, 1, data);
+}
+
+/// Write `count` consecutive sectors with a single disk request.  Return
+/// only after the data has been written.
+void
+SynchDisk::WriteSectors(int sectorNumber, unsigned count, const char *data)
 {
     ASSERT(data != nullptr);
 
+    unsigned long since = stats->totalTicks;
     lock->Acquire();  // only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
+    disk->WriteRequest(sectorNumber, data, count);
     semaphore->P();   // wait for interrupt
     lock->Release();
+    Charge(true, since);
+}
+
+void
+SynchDisk::Charge(bool write, unsigned long since)
+{
+    if (currentThread == nullptr) {
+        return;
+    }
+    IoStats *counters[] = { &currentThread->io, currentThread->ioFile };
+    for (IoStats *c : counters) {
+        if (c == nullptr) {
+            continue;
+        }
+        if (write) {
+            c->diskWrites++;
+        } else {
+            c->diskReads++;
+        }
+        c->waitTicks += stats->totalTicks - since;
+    }
 }
 
 /// Disk interrupt handler.  Wake up any thread waiting for the disk
@@ -85,3 +129,21 @@ SynchDisk::RequestDone()
 {
     semaphore->V();
 }
+
+unsigned
+SynchDisk::GetSectorsPerTrack() const
+{
+    return disk->GetSectorsPerTrack();
+}
+
+unsigned
+SynchDisk::GetNumTracks() const
+{
+    return disk->GetNumTracks();
+}
+
+unsigned
+SynchDisk::GetNumSectors() const
+{
+    return disk->GetNumSectors();
+}
@@ -28,7 +28,10 @@ class SynchDisk {
 public:
 
     /// Initialize a synchronous disk, by initializing the raw Disk.
-    SynchDisk(const char *name);
+    ///
+    /// Si se pasa una geometría, el disco se crea con ella (ver `Disk`).
+    SynchDisk(const char *name, unsigned sectorsPerTrack = 0,
+              unsigned numTracks = 0);
 
     /// De-allocate the synch disk data.
     ~SynchDisk();
@@ -40,11 +43,25 @@ public:
     void ReadSector(int sectorNumber, char *data);
     void WriteSector(int sectorNumber, const char *data);
 
+    /// Lo mismo, pero para `count` sectores consecutivos de la misma pista
+    /// en un solo pedido al disco.  Se usa para transferir bloques enteros.
+    void ReadSectors(int sectorNumber, unsigned count, char *data);
+    void WriteSectors(int sectorNumber, unsigned count, const char *data);
+
     /// Called by the disk device interrupt handler, to signal that the
     /// current disk operation is complete.
     void RequestDone();
 
+    /// Geometría del disco.
+    unsigned GetSectorsPerTrack() const;
+    unsigned GetNumTracks() const;
+    unsigned GetNumSectors() const;
+
 private:
+    /// Carga un pedido, que empezó en el tick `since`, a los contadores del
+    /// thread actual y del archivo que está usando (ver `io_stats.hh`).
+    void Charge(bool write, unsigned long since);
+
     Disk *disk;  ///< Raw disk device.
     Semaphore *semaphore;  ///< To synchronize requesting thread with the
                            ///< interrupt handler.
@@ -80,6 +80,32 @@ Bitmap::Find()
     return -1;
 }
 
+int
+Bitmap::FindInRange(unsigned from, unsigned to) const
+{
+    ASSERT(to <= numBits);
+
+    unsigned i = from;
+    while (i < to) {
+        // Si estoy al comienzo de una palabra llena, la salteo entera.
+        if (i % BITS_IN_WORD == 0 && map[i / BITS_IN_WORD] == ~0U) {
+            i += BITS_IN_WORD;
+            continue;
+        }
+        if (!Test(i)) {
+            return i;
+        }
+        i++;
+    }
+    return -1;
+}
+
+unsigned
+Bitmap::GetNumBits() const
+{
+    return numBits;
+}
+
 /// Return the number of clear bits in the bitmap.  (In other words, how many
 /// bits are unallocated?)
 unsigned
@@ -135,3 +161,17 @@ Bitmap::WriteBack(OpenFile *file) const
     ASSERT(file != nullptr);
     file->WriteAt((char *) map, numWords * sizeof (unsigned), 0);
 }
+
+/// Store part of the contents of a bitmap to a Nachos file.
+///
+/// * `file` is the place to write the bitmap to.
+/// * `offset` is the first byte to write, both in the bitmap and the file.
+/// * `numBytes` is how many bytes to write.
+void
+Bitmap::WriteBackRange(OpenFile *file, unsigned offset,
+                       unsigned numBytes) const
+{
+    ASSERT(file != nullptr);
+    ASSERT(offset + numBytes <= numWords * sizeof (unsigned));
+    file->WriteAt((char *) map + offset, numBytes, offset);
+}
@@ -55,6 +55,15 @@ public:
     /// If no bits are clear, return -1.
     int Find();
 
+    /// Return the index of the first clear bit in `[from, to)`, without
+    /// setting it.  Whole words with every bit set are skipped at once.
+    ///
+    /// If no bits are clear in the range, return -1.
+    int FindInRange(unsigned from, unsigned to) const;
+
+    /// Return the number of bits in the bitmap.
+    unsigned GetNumBits() const;
+
     /// Return the number of clear bits.
     unsigned CountClear() const;
 
@@ -73,6 +82,11 @@ public:
     /// need to read and write the bitmap to a file.
     void WriteBack(OpenFile *file) const;
 
+    /// Write only `numBytes` bytes of the bitmap, starting at byte
+    /// `offset`, to the same position in `file`.
+    void WriteBackRange(OpenFile *file, unsigned offset,
+                        unsigned numBytes) const;
+
 private:
 
     /// Number of bits in the bitmap.
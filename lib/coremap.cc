@@ -30,6 +30,10 @@ CoreMap::CoreMap(unsigned nitems)
         clock_ind = 0;
     #endif
 
+    #ifdef PAGE_CACHE
+        reclaim_ind = 0;
+    #endif
+
     numBits = nitems;
     map = new CoreStruct [numBits]; /// Crea un array con la cantidad de enteros que le dió 
     for (unsigned i = 0; i < numBits; i++) {
@@ -50,7 +54,10 @@ void
 CoreMap::Mark(unsigned which, unsigned vpn, int proc_id)
 {
     ASSERT(which < numBits);
+    // El marco pasa a tener otra página.
+    machine->GetMMU()->ForgetDecodes(which);
     map[which].used = true;
+    map[which].owner = OWNER_PROCESS;
     map[which].vpn = vpn;
     map[which].pid = proc_id;
     
@@ -123,7 +130,9 @@ CoreMap::Print() const
 {
     printf("CoreMap bits set:\n");
     for (unsigned i = 0; i < numBits; i++) {
-        if (Test(i)) {
+        if (Test(i) && map[i].owner == OWNER_FILE) {
+            printf("Marco %u\tpágina %u\tarchivo: %u\n ", i, map[i].filePage, map[i].fileSector);
+        } else if (Test(i)) {
             printf("Marco %u\tvpn %u\tproc: %d\n ", i, map[i].vpn, map[i].pid);
         }
     }
@@ -232,3 +241,124 @@ CoreMap::WriteBack(OpenFile *file) const
 
 unsigned
 CoreMap::GetSize(){return numBits;}
+
+#ifdef PAGE_CACHE
+void
+CoreMap::MarkFile(unsigned which, unsigned fileSector, unsigned page)
+{
+    ASSERT(which < numBits);
+    map[which].used = true;
+    map[which].owner = OWNER_FILE;
+    map[which].fileSector = fileSector;
+    map[which].filePage = page;
+    map[which].referenced = true;
+
+    // Que no coincida con ningún proceso.
+    map[which].pid = -1;
+    map[which].vpn = -1;
+
+    // Las páginas de archivo nunca están sucias: se escriben al disco en
+    // el momento.  Por eso el clock las prefiere a las de los procesos
+    // que haya que mandar a swap.
+    #ifdef PRPOLICY_CLOCK
+    map[which].recently_used = true;
+    map[which].dirty = false;
+    #endif
+}
+
+int
+CoreMap::FindFile(unsigned fileSector, unsigned page) const
+{
+    for (unsigned i = 0; i < numBits; i++) {
+        if (map[i].used && map[i].owner == OWNER_FILE
+              && map[i].fileSector == fileSector && map[i].filePage == page) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool
+CoreMap::IsFilePage(unsigned which) const
+{
+    ASSERT(which < numBits);
+    return map[which].used && map[which].owner == OWNER_FILE;
+}
+
+unsigned
+CoreMap::GetFileSector(unsigned which) const
+{
+    ASSERT(IsFilePage(which));
+    return map[which].fileSector;
+}
+
+unsigned
+CoreMap::GetFilePage(unsigned which) const
+{
+    ASSERT(IsFilePage(which));
+    return map[which].filePage;
+}
+
+void
+CoreMap::Touch(unsigned which)
+{
+    ASSERT(which < numBits);
+    map[which].referenced = true;
+    #ifdef PRPOLICY_CLOCK
+    map[which].recently_used = true;
+    #endif
+}
+
+int
+CoreMap::ReclaimFilePage()
+{
+    // Segunda oportunidad: en la primera vuelta se apagan los bits de uso,
+    // así que en la segunda seguro se encuentra una si hay alguna.
+    for (unsigned n = 0; n < 2 * numBits; n++) {
+        unsigned i = reclaim_ind;
+        reclaim_ind = (reclaim_ind + 1) % numBits;
+        if (!IsFilePage(i)) {
+            continue;
+        }
+        if (map[i].referenced) {
+            map[i].referenced = false;
+            continue;
+        }
+        Clear(i);
+        return i;
+    }
+    return -1;
+}
+
+int
+CoreMap::FindReclaiming(unsigned vpn, int proc_id)
+{
+    int frame = Find(vpn, proc_id);
+    if (frame == -1) {
+        frame = ReclaimFilePage();
+        if (frame != -1) {
+            DEBUG('a', "Marco %d reclamado de la caché de páginas.\n", frame);
+            Mark(frame, vpn, proc_id);
+        }
+    }
+    return frame;
+}
+
+int
+CoreMap::FindForFile(unsigned fileSector, unsigned page)
+{
+    int frame = -1;
+    for (unsigned i = 0; i < numBits && frame == -1; i++) {
+        if (!Test(i)) {
+            frame = i;
+        }
+    }
+    if (frame == -1) {
+        frame = ReclaimFilePage();
+    }
+    if (frame != -1) {
+        MarkFile(frame, fileSector, page);
+    }
+    return frame;
+}
+#endif
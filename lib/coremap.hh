@@ -10,10 +10,25 @@
 #include "lib/list.hh"
 
 
+/// A quién pertenece un marco: a una página de un proceso o, con la caché
+/// de páginas, a una página de un archivo.
+enum CoreOwner {
+    OWNER_PROCESS,
+    OWNER_FILE
+};
+
 struct corestruct {
     unsigned pid; // Espacio de direcciones.
     unsigned vpn; // Pagina alojada.
     bool used;    // Usado o no
+    CoreOwner owner;
+
+    // Página de archivo alojada: sector del header y número de página.
+    unsigned fileSector;
+    unsigned filePage;
+    #ifdef PAGE_CACHE
+    bool referenced; // Usada desde la última vez que se buscó qué reclamar.
+    #endif
     
     // Bits usados para el algoritmo del clock.
     #ifdef PRPOLICY_CLOCK
@@ -78,6 +93,39 @@ public:
     
     /// Devuelve el tamaño del coremap.
     unsigned GetSize();
+
+    #ifdef PAGE_CACHE
+    /// Marca el marco como de la página `page` del archivo cuyo header
+    /// está en `fileSector`.
+    void MarkFile(unsigned which, unsigned fileSector, unsigned page);
+
+    /// Devuelve el marco que tiene esa página de archivo, o -1.
+    int FindFile(unsigned fileSector, unsigned page) const;
+
+    /// Si el marco tiene una página de archivo.
+    bool IsFilePage(unsigned which) const;
+
+    /// Devuelve el sector del header del archivo alojado en el marco.
+    unsigned GetFileSector(unsigned which) const;
+
+    /// Devuelve el número de página del archivo alojado en el marco.
+    unsigned GetFilePage(unsigned which) const;
+
+    /// Indica que se usó el marco, para la política de reemplazo.
+    void Touch(unsigned which);
+
+    /// Libera una página de archivo poco usada (segunda oportunidad) y
+    /// devuelve su marco, o -1 si no hay páginas de archivo.
+    int ReclaimFilePage();
+
+    /// Como `Find`, pero si no hay marcos libres le saca uno a la caché de
+    /// páginas.
+    int FindReclaiming(unsigned vpn, int proc_id);
+
+    /// Busca un marco para una página de archivo: uno libre o, si no hay,
+    /// el de otra página de archivo.  Devuelve -1 si todos son de procesos.
+    int FindForFile(unsigned fileSector, unsigned page);
+    #endif
 private:
 
     /// Number of bits in the bitmap.
@@ -99,6 +147,11 @@ private:
     #ifdef PRPOLICY_CLOCK
         unsigned clock_ind;
     #endif
+
+    // Indice para recorrer las páginas de archivo al reclamar.
+    #ifdef PAGE_CACHE
+        unsigned reclaim_ind;
+    #endif
 };
 #endif
 
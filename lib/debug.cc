@@ -15,23 +15,12 @@
 
 #include <stdarg.h>
 #include <stdio.h>
-#include <string.h>
 
 
 Debug::Debug()
 {
     flags = "";
-}
-
-bool
-Debug::IsEnabled(char flag) const
-{
-    if (flags != nullptr) {
-        return strchr(flags, flag) != 0
-               || strchr(flags, '+') != 0;
-    } else {
-        return false;
-    }
+    mask = 0;
 }
 
 const char *
@@ -44,6 +33,13 @@ void
 Debug::SetFlags(const char *new_flags)
 {
     flags = new_flags;
+    mask = 0;
+    if (flags == nullptr) {
+        return;
+    }
+    for (const char *c = flags; *c != '\0'; c++) {
+        mask |= *c == '+' ? ~0ULL : FlagBit(*c);
+    }
 }
 
 void
@@ -41,7 +41,13 @@ public:
     Debug();
 
     /// Is this debug flag enabled?
-    bool IsEnabled(char flag) const;
+    ///
+    /// Se define acá porque se llama en cada `DEBUG`: es un solo test de
+    /// la máscara.
+    bool IsEnabled(char flag) const
+    {
+        return (mask & FlagBit(flag)) != 0;
+    }
 
     /// Get the current flags.
     const char *GetFlags() const;
@@ -77,6 +83,20 @@ private:
     /// String that controls which debug messages are printed.
     const char *flags;
 
+    /// Las mismas banderas, un bit por cada una.  Se calcula en `SetFlags`.
+    unsigned long long mask;
+
+    /// Bit de la bandera `flag`.  Cada letra y dígito tiene el suyo; el
+    /// resto de los caracteres comparten el último.
+    static unsigned long long FlagBit(char flag)
+    {
+        unsigned bit = flag >= 'a' && flag <= 'z' ? flag - 'a'
+                     : flag >= 'A' && flag <= 'Z' ? 26 + flag - 'A'
+                     : flag >= '0' && flag <= '9' ? 52 + flag - '0'
+                     : 63;
+        return 1ULL << bit;
+    }
+
     DebugOpts opts;
 };
 
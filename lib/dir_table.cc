@@ -69,6 +69,14 @@ DirTable::Add(OpenFile* file, const char* actName, const char* fatherName)
     data[cur_ret].threadsInIt = 0;
     data[cur_ret].toDelete = false;
     data[cur_ret].pid_to_delete = -1;
+
+    char* sharedLockName = concat("DirSharedLock.", actName);
+    char* sharedChangedName = concat("DirSharedChanged.", actName);
+    data[cur_ret].sharedLock = new Lock(sharedLockName);
+    data[cur_ret].sharedChanged = new Condition(sharedChangedName, data[cur_ret].sharedLock);
+    data[cur_ret].readers = 0;
+    data[cur_ret].exclusive = false;
+    data[cur_ret].pendingEntry = nullptr;
     
     numCondition = 0;
 
@@ -174,13 +182,28 @@ DirTable::DirLock(const char *name, int op)
         case ACQUIRE:
             DEBUG('f', "Soy %d y tomo el DirLock del directorio %s en la DirTable\n",currentThread->GetPid(), name);
             (data[idx].actDirLock)->Acquire();
+            ExcludeReaders(idx);
         break;
 
         case RELEASE:
             DEBUG('f', "Soy %d y suelto el DirLock del directorio %s en la DirTable\n",currentThread->GetPid(), name);
+            AdmitReaders(idx);
             (data[idx].actDirLock)->Release();
         break;
 
+        case ACQUIRE_SHARED:
+            DirLockLookup(name, nullptr);
+        break;
+
+        case RELEASE_SHARED:
+            DEBUG('f', "Soy %d y suelto el DirLock compartido del directorio %s\n",currentThread->GetPid(), name);
+            data[idx].sharedLock->Acquire();
+            data[idx].readers--;
+            if (data[idx].readers == 0)
+                data[idx].sharedChanged->Broadcast();
+            data[idx].sharedLock->Release();
+        break;
+
         default:
             return false;
         break;
@@ -189,6 +212,69 @@ DirTable::DirLock(const char *name, int op)
     return true;
 }
 
+void
+DirTable::DirLockLookup(const char *name, const char *entry)
+{
+    int idx = CheckDirInTable(name);
+    ASSERT(idx != -1);
+
+    DEBUG('f', "Soy %d y tomo el DirLock compartido del directorio %s\n",currentThread->GetPid(), name);
+    data[idx].sharedLock->Acquire();
+    // `Directory::Find` compara por prefijo, así que se espera también si
+    // la entrada en curso empieza con `entry`.
+    while (data[idx].exclusive
+             || (entry != nullptr && data[idx].pendingEntry != nullptr
+                   && !strncmp(data[idx].pendingEntry, entry, strlen(entry))))
+        data[idx].sharedChanged->Wait();
+    data[idx].readers++;
+    data[idx].sharedLock->Release();
+}
+
+void
+DirTable::BeginEntryUpdate(const char *name, const char *entry)
+{
+    int idx = CheckDirInTable(name);
+    ASSERT(idx != -1);
+    ASSERT(entry != nullptr);
+    ASSERT(data[idx].actDirLock->IsHeldByCurrentThread());
+
+    DEBUG('f', "Escribo la entrada %s del directorio %s\n", entry, name);
+    data[idx].pendingEntry = new char[strlen(entry) + 1];
+    strcpy(data[idx].pendingEntry, entry);
+    AdmitReaders(idx);
+}
+
+void
+DirTable::EndEntryUpdate(const char *name)
+{
+    int idx = CheckDirInTable(name);
+    ASSERT(idx != -1);
+    ASSERT(data[idx].pendingEntry != nullptr);
+
+    ExcludeReaders(idx);
+    delete [] data[idx].pendingEntry;
+    data[idx].pendingEntry = nullptr;
+}
+
+void
+DirTable::ExcludeReaders(int idx)
+{
+    data[idx].sharedLock->Acquire();
+    data[idx].exclusive = true;
+    while (data[idx].readers > 0)
+        data[idx].sharedChanged->Wait();
+    data[idx].sharedLock->Release();
+}
+
+void
+DirTable::AdmitReaders(int idx)
+{
+    data[idx].sharedLock->Acquire();
+    data[idx].exclusive = false;
+    data[idx].sharedChanged->Broadcast();
+    data[idx].sharedLock->Release();
+}
+
 int
 DirTable::addThreadsIn(const char* name)
 {
@@ -243,7 +329,11 @@ DirTable::DirRemoveCondition(const char *name, int op)
     switch (op) { 
         case WAIT:
             DEBUG('f', "Soy %d y hago wait sobre la DirRemoveCondition del directorio %s\n",currentThread->GetPid(), name);
+            // Mientras espera no tiene el lock, así que las búsquedas pueden
+            // pasar.
+            AdmitReaders(idx);
             (data[idx].RemoveCondition)->Wait();
+            ExcludeReaders(idx);
         break;
 
         case SIGNAL:
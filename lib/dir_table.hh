@@ -9,6 +9,10 @@
 #define ACQUIRE 0
 #define RELEASE 1
 
+// Modo compartido del lock de un directorio, para las búsquedas.
+#define ACQUIRE_SHARED 2
+#define RELEASE_SHARED 3
+
 #define SEM_P 0
 #define SEM_V 1
 
@@ -19,6 +23,14 @@
 // Una DirTable es una tabla que va llevando los directorios presentes 
 // en el sistema junto con metadata de los mismos útiles para su 
 // utilización y seguridad.
+//
+// El lock de cada directorio tiene dos modos.  Las búsquedas (`Open`,
+// `Ls`) lo toman compartido y pueden ir a la vez; las modificaciones lo
+// toman exclusivo, que espera a que terminen las búsquedas en curso y no
+// deja entrar nuevas.  Mientras una modificación escribe en el disco una
+// sola entrada (`BeginEntryUpdate`/`EndEntryUpdate`) vuelve a dejar pasar
+// a las búsquedas, porque las demás entradas no cambian; sólo esperan las
+// que buscan justo esa entrada.
 
 struct dirStruct {
     OpenFile* file; // Archivo que contiene al directorio.
@@ -33,6 +45,11 @@ struct dirStruct {
     bool toDelete; // Booleano para verificar está para ser eliminado.
                    // Si está en true, el directorio no se puede abrir.
     int pid_to_delete;
+    Lock *sharedLock; // Protege los campos del modo compartido.
+    Condition *sharedChanged; // Cambió alguno de ellos.
+    int readers; // Búsquedas en curso.
+    bool exclusive; // Una modificación no deja entrar búsquedas.
+    char *pendingEntry; // Entrada que se está escribiendo, o nullptr.
 };
 
 class DirTable {
@@ -72,10 +89,22 @@ class DirTable {
         int SetNumEntries(const char* name, int numEntries);
 
         // Realiza una operación con el lock del directorio
-        // ingresado.
+        // ingresado: ACQUIRE/RELEASE en modo exclusivo o
+        // ACQUIRE_SHARED/RELEASE_SHARED en modo compartido.
         // Devuelve true si sale todo bien, false en caso contrario.
         bool DirLock(const char *name, int op);
 
+        // Toma el lock del directorio en modo compartido para buscar
+        // `entry`.  Si esa entrada se está escribiendo, espera a que
+        // termine.  Se suelta con RELEASE_SHARED.
+        void DirLockLookup(const char *name, const char *entry);
+
+        // Con el lock exclusivo tomado, avisa que sólo se va a escribir la
+        // entrada `entry` y deja pasar a las búsquedas de otras entradas
+        // hasta `EndEntryUpdate`, que vuelve al modo exclusivo.
+        void BeginEntryUpdate(const char *name, const char *entry);
+        void EndEntryUpdate(const char *name);
+
         // Agrega un thread que está trabajando en el directorio.
         // Esto se debe agregar cada vez que un thread hace un cd o se crea.
         // Se debe sacar cada vez que se hace un cd .. o cuando se cambia de 
@@ -109,6 +138,12 @@ class DirTable {
         bool DirRemoveCondition(const char* name, int op);
 
 private:
+
+    // Deja afuera a las búsquedas y espera a que terminen las que hay.
+    void ExcludeReaders(int idx);
+
+    // Vuelve a dejar pasar a las búsquedas.
+    void AdmitReaders(int idx);
         
     // Elementos de la tabla
     dirStruct data[SIZE];
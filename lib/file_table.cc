@@ -21,8 +21,10 @@ FileTable::Add(OpenFile* file, const char *name)
         
         // Si el archivo fué cerrado, debo reemplazar el file
         // ya que el anterior se eliminó.
-        if (GetClosed(name))
+        if (GetClosed(name)) {
             data[i].file = file;
+            file->SetIoStats(&data[i].io);
+        }
 
         data[i].open += 1;
         return i;
@@ -45,6 +47,8 @@ FileTable::Add(OpenFile* file, const char *name)
     DEBUG('f', "Añado el archivo %s a la FileTable\n", name);
 
     data[cur_ret].file = file;
+    data[cur_ret].io = IoStats();
+    file->SetIoStats(&data[cur_ret].io);
     data[cur_ret].open = 1;
     data[cur_ret].closed = false;
     data[cur_ret].readers = 0;
@@ -453,3 +457,74 @@ FileTable::FileSem(const char *name, int op)
 
     return true;
 }
+
+int
+FileTable::LockedReadAt(const char *name, char *into,
+                        unsigned numBytes, unsigned position)
+{
+    OpenFile *file = GetFile(name);
+    ASSERT(file != nullptr);
+
+    FileRdWrLock(name, ACQUIRE);
+    AddReader(name);
+    FileRdWrLock(name, RELEASE);
+
+    int status = file->ReadAt(into, numBytes, position);
+
+    FileRdWrLock(name, ACQUIRE);
+    RemoveReader(name);
+    if (GetReaders(name) == 0 && GetWriter(name))
+        FileWriterCondition(name, SIGNAL);
+    FileRdWrLock(name, RELEASE);
+
+    return status;
+}
+
+int
+FileTable::LockedWriteAt(const char *name, const char *from,
+                         unsigned numBytes, unsigned position)
+{
+    OpenFile *file = GetFile(name);
+    ASSERT(file != nullptr);
+
+    BeginWrite(name);
+    int status = file->WriteAt(from, numBytes, position);
+    EndWrite(name);
+
+    return status;
+}
+
+void
+FileTable::BeginWrite(const char *name)
+{
+    FileWrLock(name, ACQUIRE);
+    FileRdWrLock(name, ACQUIRE);
+    SetWriter(name, true);
+    if (GetReaders(name) > 0)
+        FileWriterCondition(name, WAIT);
+}
+
+void
+FileTable::EndWrite(const char *name)
+{
+    FileRdWrLock(name, RELEASE);
+    FileWrLock(name, RELEASE);
+}
+
+const IoStats *
+FileTable::GetIoStats(const char *name)
+{
+    int idx = CheckFileInTable(name);
+
+    return idx == -1 ? nullptr : &data[idx].io;
+}
+
+void
+FileTable::PrintIoStats()
+{
+    for (int i = 0; i < current; i++) {
+        if (HasKey(i) && !data[i].io.IsEmpty()) {
+            data[i].io.Print(data[i].name);
+        }
+    }
+}
@@ -3,6 +3,7 @@
 #include "threads/condition.hh"
 #include "list.hh"
 #include "filesys/open_file.hh"
+#include "filesys/io_stats.hh"
 #include <cstring>
 
 #define ACQUIRE 0
@@ -33,6 +34,7 @@ struct fileStruct {
     Semaphore *ReadersSem;
     Lock *RdWrLock; // Condición para escribir en el archivo sincronizando lector/escritor.
     Lock *WrLock; // Condición para escribir en el archivo sincronizando escritores.
+    IoStats io; // Contadores de entrada/salida del archivo.
 };
 
 class FileTable {
@@ -142,6 +144,29 @@ public:
     // Sincronizando entre escritores.
     bool FileRdWrLock(const char *name, int op);
 
+    // Lee `numBytes` bytes del archivo desde `position` como un lector más,
+    // con el mismo protocolo que la syscall `Read`.
+    int LockedReadAt(const char *name, char *into,
+                     unsigned numBytes, unsigned position);
+
+    // Toma el archivo como escritor: espera a que no haya lectores y
+    // deja afuera a los demás hasta `EndWrite`.
+    void BeginWrite(const char *name);
+    void EndWrite(const char *name);
+
+    // Escribe `numBytes` bytes en el archivo desde `position` como
+    // escritor, esperando a que no haya lectores, igual que la syscall
+    // `Write`.
+    int LockedWriteAt(const char *name, const char *from,
+                      unsigned numBytes, unsigned position);
+
+    // Devuelve los contadores de entrada/salida del archivo, o null si no
+    // está en la tabla.
+    const IoStats *GetIoStats(const char *name);
+
+    // Imprime los contadores de los archivos que tuvieron actividad.
+    void PrintIoStats();
+
 private:
 
     // Elementos de la tabla.
@@ -66,8 +66,24 @@ typedef void (*VoidNoArgFunctionPtr)();
 /// Global object for debug output.
 extern Debug debug;
 
-#define DEBUG(...)  (debug.Print)(__FILE__, __LINE__, __func__, __VA_ARGS__)
-#define DEBUG_CONT  (debug.PrintCont)
+/// Los mensajes sólo se arman si su bandera está prendida, así un `DEBUG`
+/// apagado cuesta una comparación contra la máscara.  Compilando con
+/// `NDEBUG_TRACE` desaparecen del todo (los argumentos ni se evalúan).
+#ifdef NDEBUG_TRACE
+#define DEBUG(flag, ...)  (false ? (debug.Print)(__FILE__, __LINE__, __func__, \
+                                                 flag, __VA_ARGS__)            \
+                                 : (void) 0)
+#define DEBUG_CONT(flag, ...)  (false ? (debug.PrintCont)(flag, __VA_ARGS__) \
+                                      : (void) 0)
+#else
+#define DEBUG(flag, ...)  (debug.IsEnabled(flag)                              \
+                             ? (debug.Print)(__FILE__, __LINE__, __func__,    \
+                                             flag, __VA_ARGS__)               \
+                             : (void) 0)
+#define DEBUG_CONT(flag, ...)  (debug.IsEnabled(flag)                         \
+                                  ? (debug.PrintCont)(flag, __VA_ARGS__)      \
+                                  : (void) 0)
+#endif
 
 char* concat(const char* str1, const char* str2);
 
@@ -20,14 +20,6 @@
 #include <stdio.h>
 
 
-/// We put this at the front of the UNIX file representing the
-/// disk, to make it less likely we will accidentally treat a useful file
-/// as a disk (which would probably trash the file's contents).
-static const unsigned MAGIC_NUMBER = 0x456789AB;
-static const unsigned MAGIC_SIZE = sizeof (int);
-
-static const unsigned DISK_SIZE = MAGIC_SIZE + NUM_SECTORS * SECTOR_SIZE;
-
 /// dummy procedure because we cannot take a pointer of a member function
 static void
 DiskDone(void *arg)
@@ -44,12 +36,16 @@ DiskDone(void *arg)
 /// * `callWhenDone` is an interrupt handler to be called when disk
 ///   read/write request completes.
 /// * `callArg` is an argument to pass the interrupt handler.
-Disk::Disk(const char *name, VoidFunctionPtr callWhenDone, void *callArg)
+/// * `aSectorsPerTrack` y `aNumTracks` son la geometría con la que crear el
+///   disco, o 0 para usar la que ya tiene.
+Disk::Disk(const char *name, VoidFunctionPtr callWhenDone, void *callArg,
+           unsigned aSectorsPerTrack, unsigned aNumTracks)
 {
     ASSERT(name != nullptr);
     ASSERT(callWhenDone != nullptr);
+    ASSERT((aSectorsPerTrack == 0) == (aNumTracks == 0));
 
-    int magicNum;
+    unsigned magicNum;
     int tmp = 0;
 
     DEBUG('d', "Initializing the disk, 0x%X 0x%X\n", callWhenDone, callArg);
@@ -59,22 +55,68 @@ Disk::Disk(const char *name, VoidFunctionPtr callWhenDone, void *callArg)
     bufferInit = 0;
 
     fileno = SystemDep::OpenForReadWrite(name, false);
-    if (fileno >= 0) {  // File exists, check magic number.
+    if (fileno >= 0 && aSectorsPerTrack == 0) {
+        // File exists, check magic number and read the geometry.
         SystemDep::Read(fileno, (char *) &magicNum, MAGIC_SIZE);
-        ASSERT(magicNum == MAGIC_NUMBER);
-    } else {            // File does not exist, create it.
-        fileno = SystemDep::OpenForWrite(name);
-        magicNum = MAGIC_NUMBER;
-        SystemDep::WriteFile(fileno, (char *) &magicNum, MAGIC_SIZE);
-          // Write magic number.
+        if (magicNum == MAGIC_NUMBER) {
+            sectorsPerTrack = SECTORS_PER_TRACK;
+            numTracks       = NUM_TRACKS;
+            headerSize      = MAGIC_SIZE;
+        } else {
+            ASSERT(magicNum == LABEL_MAGIC_NUMBER);
+            SystemDep::Read(fileno, (char *) &sectorsPerTrack,
+                            sizeof (unsigned));
+            SystemDep::Read(fileno, (char *) &numTracks, sizeof (unsigned));
+            headerSize = LABEL_SIZE;
+        }
+        numSectors = sectorsPerTrack * numTracks;
+    } else {
+        // File does not exist (or a new geometry was requested), create it.
+        if (fileno < 0) {
+            fileno = SystemDep::OpenForWrite(name);
+        }
+        sectorsPerTrack = aSectorsPerTrack != 0 ? aSectorsPerTrack
+                                                : SECTORS_PER_TRACK;
+        numTracks       = aNumTracks != 0 ? aNumTracks : NUM_TRACKS;
+        numSectors      = sectorsPerTrack * numTracks;
+        headerSize      = LABEL_SIZE;
+
+        unsigned label[3] = {
+            LABEL_MAGIC_NUMBER, sectorsPerTrack, numTracks
+        };
+        SystemDep::Lseek(fileno, 0, 0);
+        SystemDep::WriteFile(fileno, (char *) label, LABEL_SIZE);
+          // Write magic number and geometry.
 
         // Need to write at end of file, so that reads will not return EOF.
-        SystemDep::Lseek(fileno, DISK_SIZE - sizeof (int), 0);
+        SystemDep::Lseek(fileno, headerSize + numSectors * SECTOR_SIZE
+                                 - sizeof (int), 0);
         SystemDep::WriteFile(fileno, (char *) &tmp, sizeof (int));
     }
+    ASSERT(numSectors > 0);
+    DEBUG('d', "Disk geometry: %u tracks of %u sectors.\n",
+          numTracks, sectorsPerTrack);
     active = false;
 }
 
+unsigned
+Disk::GetSectorsPerTrack() const
+{
+    return sectorsPerTrack;
+}
+
+unsigned
+Disk::GetNumTracks() const
+{
+    return numTracks;
+}
+
+unsigned
+Disk::GetNumSectors() const
+{
+    return numSectors;
+}
+
 /// Clean up disk simulation, by closing the UNIX file representing the disk.
 Disk::~Disk()
 {
@@ -100,6 +142,12 @@ PrintSector(bool writing, unsigned sector, const char *data)
     printf("\n");
 }
 
+static inline unsigned
+Diff(unsigned a, unsigned b)
+{
+    return a > b ? a - b : b - a;
+}
+
 /// Disk::ReadRequest/WriteRequest
 ///
 /// Simulate a request to read/write a single disk sector.
@@ -114,48 +162,65 @@ PrintSector(bool writing, unsigned sector, const char *data)
 /// * `sectorNumber` is the disk sector to read/write.
 /// * `data` are the bytes to be written, the buffer to hold the incoming
 ///   bytes.
+/// * `count` es la cantidad de sectores consecutivos a transferir.
 void
-Disk::ReadRequest(unsigned sectorNumber, char *data)
+Disk::ReadRequest(unsigned sectorNumber, char *data, unsigned count)
 {
     ASSERT(data != nullptr);
+    ASSERT(count > 0);
 
-    int ticks = ComputeLatency(sectorNumber, false);
+    int ticks = ComputeLatency(sectorNumber, false)
+                + (count - 1) * ROTATION_TIME;
 
     ASSERT(!active);  // only one request at a time
-    ASSERT(sectorNumber >= 0 && sectorNumber < NUM_SECTORS);
+    ASSERT(sectorNumber >= 0 && sectorNumber + count <= numSectors);
+    ASSERT(sectorNumber / sectorsPerTrack
+           == (sectorNumber + count - 1) / sectorsPerTrack);
 
-    DEBUG('d', "Reading from sector %u\n", sectorNumber);
-    SystemDep::Lseek(fileno, SECTOR_SIZE * sectorNumber + MAGIC_SIZE, 0);
-    SystemDep::Read(fileno, data, SECTOR_SIZE);
+    DEBUG('d', "Reading from sector %u (%u sectors)\n", sectorNumber, count);
+    SystemDep::Lseek(fileno, SECTOR_SIZE * sectorNumber + headerSize, 0);
+    SystemDep::Read(fileno, data, SECTOR_SIZE * count);
     if (debug.IsEnabled('d')) {
-        PrintSector(false, sectorNumber, data);
+        for (unsigned i = 0; i < count; i++) {
+            PrintSector(false, sectorNumber + i, data + i * SECTOR_SIZE);
+        }
     }
 
     active = true;
-    UpdateLast(sectorNumber);
+    stats->numDiskSeekTracks += Diff(sectorNumber / sectorsPerTrack,
+                                     lastSector / sectorsPerTrack);
+    UpdateLast(sectorNumber + count - 1);
     stats->numDiskReads++;
     interrupt->Schedule(DiskDone, this, ticks, DISK_INT);
 }
 
 void
-Disk::WriteRequest(unsigned sectorNumber, const char *data)
+Disk::WriteRequest(unsigned sectorNumber, const char *data, unsigned count)
 {
     ASSERT(data != nullptr);
+    ASSERT(count > 0);
 
-    int ticks = ComputeLatency(sectorNumber, true);
+    int ticks = ComputeLatency(sectorNumber, true)
+                + (count - 1) * ROTATION_TIME;
 
     ASSERT(!active);
-    ASSERT(sectorNumber >= 0 && sectorNumber < NUM_SECTORS);
+    ASSERT(sectorNumber >= 0 && sectorNumber + count <= numSectors);
+    ASSERT(sectorNumber / sectorsPerTrack
+           == (sectorNumber + count - 1) / sectorsPerTrack);
 
-    DEBUG('d', "Writing to sector %u\n", sectorNumber);
-    SystemDep::Lseek(fileno, SECTOR_SIZE * sectorNumber + MAGIC_SIZE, 0);
-    SystemDep::WriteFile(fileno, data, SECTOR_SIZE);
+    DEBUG('d', "Writing to sector %u (%u sectors)\n", sectorNumber, count);
+    SystemDep::Lseek(fileno, SECTOR_SIZE * sectorNumber + headerSize, 0);
+    SystemDep::WriteFile(fileno, data, SECTOR_SIZE * count);
     if (debug.IsEnabled('d')) {
-        PrintSector(true, sectorNumber, data);
+        for (unsigned i = 0; i < count; i++) {
+            PrintSector(true, sectorNumber + i, data + i * SECTOR_SIZE);
+        }
     }
 
     active = true;
-    UpdateLast(sectorNumber);
+    stats->numDiskSeekTracks += Diff(sectorNumber / sectorsPerTrack,
+                                     lastSector / sectorsPerTrack);
+    UpdateLast(sectorNumber + count - 1);
     stats->numDiskWrites++;
     interrupt->Schedule(DiskDone, this, ticks, DISK_INT);
 }
@@ -169,12 +234,6 @@ Disk::HandleInterrupt()
     (*handler)(handlerArg);
 }
 
-static inline unsigned
-Diff(unsigned a, unsigned b)
-{
-    return a > b ? a - b : b - a;
-}
-
 /// Returns how long it will take to position the disk head over the correct
 /// track on the disk.  Since when we finish seeking, we are likely to be in
 /// the middle of a sector that is rotating past the head, we also return how
@@ -187,8 +246,8 @@ Disk::TimeToSeek(unsigned newSector, unsigned *rotation)
 {
     ASSERT(rotation != nullptr);
 
-    unsigned newTrack = newSector / SECTORS_PER_TRACK;
-    unsigned oldTrack = lastSector / SECTORS_PER_TRACK;
+    unsigned newTrack = newSector / sectorsPerTrack;
+    unsigned oldTrack = lastSector / sectorsPerTrack;
     unsigned seek = Diff(newTrack, oldTrack) * SEEK_TIME;
       // How long will seek take?
     unsigned over = (stats->totalTicks + seek) % ROTATION_TIME;
@@ -206,10 +265,10 @@ Disk::TimeToSeek(unsigned newSector, unsigned *rotation)
 unsigned
 Disk::ModuloDiff(unsigned to, unsigned from)
 {
-    unsigned toOffset   = to % SECTORS_PER_TRACK;
-    unsigned fromOffset = from % SECTORS_PER_TRACK;
+    unsigned toOffset   = to % sectorsPerTrack;
+    unsigned fromOffset = from % sectorsPerTrack;
 
-    return (toOffset - fromOffset + SECTORS_PER_TRACK) % SECTORS_PER_TRACK;
+    return (toOffset - fromOffset + sectorsPerTrack) % sectorsPerTrack;
 }
 
 /// Return how long will it take to read/write a disk sector, from
@@ -50,29 +50,64 @@
 ///
 /// The track buffer simulation can be disabled by compiling with
 /// `-DNOTRACKBUF`.
+///
+/// La cantidad de pistas y de sectores por pista se elige al crear (o
+/// formatear) el disco y queda guardada en la etiqueta al comienzo del
+/// archivo `DISK`.  Las constantes de abajo son la geometría por defecto.
+/// El tamaño de sector es fijo: de él dependen las estructuras en disco y
+/// el tamaño de página.
 
 const unsigned SECTOR_SIZE = 128;       ///< Number of bytes per disk sector.
 const unsigned SECTORS_PER_TRACK = 32;  ///< Number of sectors per disk
-                                        ///< track.
-const unsigned NUM_TRACKS = 32;         ///< Number of tracks per disk.
+                                        ///< track (por defecto).
+const unsigned NUM_TRACKS = 32;         ///< Number of tracks per disk (por
+                                        ///< defecto).
 const unsigned NUM_SECTORS = SECTORS_PER_TRACK * NUM_TRACKS;
-  ///< Total # of sectors per disk.
+  ///< Total # of sectors per disk (por defecto).
+
+/// We put this at the front of the UNIX file representing the
+/// disk, to make it less likely we will accidentally treat a useful file
+/// as a disk (which would probably trash the file's contents).
+///
+/// Los discos con `MAGIC_NUMBER` son los viejos: sólo tienen el número
+/// mágico y usan la geometría por defecto.  Los discos nuevos llevan
+/// `LABEL_MAGIC_NUMBER` seguido de los sectores por pista y las pistas.
+/// Las herramientas de `bin/` leen la etiqueta con estas mismas constantes.
+const unsigned MAGIC_NUMBER = 0x456789AB;
+const unsigned LABEL_MAGIC_NUMBER = 0x456789AC;
+const unsigned MAGIC_SIZE = sizeof (int);
+const unsigned LABEL_SIZE = 3 * sizeof (int);
 
 class Disk {
 public:
     /// Create a simulated disk.
     ///
     /// Invoke `(*callWhenDone)(callArg)` every time a request completes.
-    Disk(const char *name, VoidFunctionPtr callWhenDone, void *callArg);
+    ///
+    /// Si se pasa una geometría (`sectorsPerTrack` y `numTracks` distintos
+    /// de 0) el disco se (re)crea con ella; si no, se usa la guardada en la
+    /// etiqueta del archivo, o la de por defecto si el archivo no existe.
+    Disk(const char *name, VoidFunctionPtr callWhenDone, void *callArg,
+         unsigned sectorsPerTrack = 0, unsigned numTracks = 0);
     ~Disk();  // Deallocate the disk.
 
+    /// Geometría del disco.
+    unsigned GetSectorsPerTrack() const;
+    unsigned GetNumTracks() const;
+    unsigned GetNumSectors() const;
+
     /// Read/write an single disk sector.
     ///
     /// These routines send a request to the disk and return immediately.
     /// Only one request allowed at a time!
+    ///
+    /// Con `count` mayor a 1 se transfieren `count` sectores consecutivos
+    /// en un único pedido: se paga una sola vez el seek y la latencia
+    /// rotacional.  Los sectores no pueden cruzar una pista.
 
-    void ReadRequest(unsigned sectorNumber, char *data);
-    void WriteRequest(unsigned sectorNumber, const char *data);
+    void ReadRequest(unsigned sectorNumber, char *data, unsigned count = 1);
+    void WriteRequest(unsigned sectorNumber, const char *data,
+                      unsigned count = 1);
 
     /// Interrupt handler, invoked when disk request finishes.
     void HandleInterrupt();
@@ -91,6 +126,10 @@ private:
     unsigned lastSector;  ///< The previous disk request.
     int bufferInit;  ///< When the track buffer started being loaded.
                      // being loaded
+    unsigned sectorsPerTrack;  ///< Sectores por pista.
+    unsigned numTracks;  ///< Cantidad de pistas.
+    unsigned numSectors;  ///< Cantidad total de sectores.
+    unsigned headerSize;  ///< Bytes de la etiqueta antes del sector 0.
 
     /// Time to get to the new track.
     unsigned TimeToSeek(unsigned newSector, unsigned *rotate);
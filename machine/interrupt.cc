@@ -22,7 +22,11 @@
 
 #include "interrupt.hh"
 #include "threads/system.hh"
+#ifdef FILESYS
+#include "filesys/io_stats.hh"
+#endif
 
+#include <algorithm>
 #include <limits.h>
 #include <stdio.h>
 
@@ -59,10 +63,12 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
     ASSERT(func != nullptr);
     ASSERT(IsIntType(kind));
 
-    handler = func;
-    arg     = param;
-    when    = time;
-    type    = kind;
+    handler  = func;
+    arg      = param;
+    when     = time;
+    type     = kind;
+    order    = 0;
+    nextFree = nullptr;
 }
 
 /// Initialize the simulation of hardware device interrupts.
@@ -70,8 +76,13 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
 /// Interrupts start disabled, with no interrupts pending, etc.
 Interrupt::Interrupt()
 {
-    level         = INT_OFF;
-    pending       = new List<PendingInterrupt *>;
+    level           = INT_OFF;
+    pendingCapacity = 8;
+    pending         = new PendingInterrupt * [pendingCapacity];
+    numPending      = 0;
+    nextDue         = ULONG_MAX;
+    freePending     = nullptr;
+    numScheduled    = 0;
     inHandler     = false;
     yieldOnReturn = false;
     status        = SYSTEM_MODE;
@@ -80,10 +91,76 @@ Interrupt::Interrupt()
 /// De-allocate the data structures needed by the interrupt simulation.
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty()) {
-        delete pending->Pop();
+    for (unsigned i = 0; i < numPending; i++) {
+        delete pending[i];
+    }
+    delete [] pending;
+    while (freePending != nullptr) {
+        PendingInterrupt *next = freePending->nextFree;
+        delete freePending;
+        freePending = next;
+    }
+}
+
+/// Si `a` vence antes que `b`.
+static inline bool
+Earlier(const PendingInterrupt *a, const PendingInterrupt *b)
+{
+    return a->when < b->when || (a->when == b->when && a->order < b->order);
+}
+
+void
+Interrupt::PushPending(PendingInterrupt *pend)
+{
+    ASSERT(pend != nullptr);
+
+    if (numPending == pendingCapacity) {
+        PendingInterrupt **bigger = new PendingInterrupt * [pendingCapacity * 2];
+        for (unsigned i = 0; i < numPending; i++) {
+            bigger[i] = pending[i];
+        }
+        delete [] pending;
+        pending = bigger;
+        pendingCapacity *= 2;
+    }
+
+    unsigned i = numPending++;
+    while (i > 0 && Earlier(pend, pending[(i - 1) / 2])) {
+        pending[i] = pending[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    pending[i] = pend;
+    nextDue = pending[0]->when;
+}
+
+PendingInterrupt *
+Interrupt::PopPending()
+{
+    ASSERT(numPending > 0);
+
+    PendingInterrupt *first = pending[0];
+    PendingInterrupt *last = pending[--numPending];
+    unsigned i = 0;
+    for (;;) {
+        unsigned child = 2 * i + 1;
+        if (child >= numPending) {
+            break;
+        }
+        if (child + 1 < numPending && Earlier(pending[child + 1],
+                                              pending[child])) {
+            child++;
+        }
+        if (!Earlier(pending[child], last)) {
+            break;
+        }
+        pending[i] = pending[child];
+        i = child;
+    }
+    if (numPending > 0) {
+        pending[i] = last;
     }
-    delete pending;
+    nextDue = numPending > 0 ? pending[0]->when : ULONG_MAX;
+    return first;
 }
 
 /// Change interrupts to be enabled or disabled, without advancing the
@@ -157,11 +234,16 @@ Interrupt::OneTick()
     }
     DEBUG('i', "== Tick %u ==\n", stats->totalTicks);
 
-    // Check any pending interrupts are now ready to fire.
-    ChangeLevel(INT_ON, INT_OFF);  // First, turn off interrupts (interrupt
-                                   // handlers run with interrupts disabled).
-    while (CheckIfDue(false)) {}   // Check for pending interrupts.
-    ChangeLevel(INT_OFF, INT_ON);  // Re-enable interrupts.
+    // Check any pending interrupts are now ready to fire.  Si no vence
+    // ninguna alcanza con comparar; con las trazas se revisa igual, así se
+    // ve el estado en cada tick.
+    if (stats->totalTicks >= nextDue || debug.IsEnabled('i')) {
+        ChangeLevel(INT_ON, INT_OFF);  // First, turn off interrupts
+                                       // (interrupt handlers run with
+                                       // interrupts disabled).
+        while (CheckIfDue(false)) {}   // Check for pending interrupts.
+        ChangeLevel(INT_OFF, INT_ON);  // Re-enable interrupts.
+    }
     if (yieldOnReturn) {           // If the timer device handler asked for a
                                    // context switch, ok to do it now.
         yieldOnReturn = false;
@@ -172,6 +254,23 @@ Interrupt::OneTick()
     }
 }
 
+unsigned long
+Interrupt::TicksBeforeDue() const
+{
+    if (nextDue == ULONG_MAX) {
+        return ULONG_MAX;
+    }
+    return nextDue > stats->totalTicks ? nextDue - stats->totalTicks : 0;
+}
+
+void
+Interrupt::SkipUserTick()
+{
+    ASSERT(status == USER_MODE);
+    stats->totalTicks += USER_TICK;
+    stats->userTicks += USER_TICK;
+}
+
 /// Called from within an interrupt handler, to cause a context switch (for
 /// example, on a time slice) in the interrupted thread, when the handler
 /// returns.
@@ -224,6 +323,12 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef USE_TLB
+    tlbPolicy->Print();
+#endif
+#ifdef FILESYS
+    PrintIoStats();
+#endif
     Cleanup();  // Never returns.
 }
 
@@ -237,19 +342,14 @@ Interrupt::Halt()
 void
 Interrupt::RestartTicks()
 {
-    List<PendingInterrupt *> *oldPending = pending;
-    pending = new List<PendingInterrupt *>;
-
-    PendingInterrupt *i;
-    unsigned          oldWhen = 0;
-    while ((i = oldPending->SortedPop((int *) &oldWhen)) != nullptr) {
-        unsigned newWhen = oldWhen - stats->totalTicks;
-        pending->SortedInsert(i, newWhen);
-        DEBUG('x', "Interrupt at time %u re-scheduled at new time %u.\n",
-              oldWhen, newWhen);
+    // Se corren todas igual, así que el *heap* sigue ordenado.
+    for (unsigned i = 0; i < numPending; i++) {
+        unsigned long oldWhen = pending[i]->when;
+        pending[i]->when = oldWhen - stats->totalTicks;
+        DEBUG('x', "Interrupt at time %lu re-scheduled at new time %lu.\n",
+              oldWhen, pending[i]->when);
     }
-
-    delete oldPending;
+    nextDue = numPending > 0 ? pending[0]->when : ULONG_MAX;
     stats->totalTicks = 0;
     stats->tickResets += 1;
 }
@@ -258,7 +358,8 @@ Interrupt::RestartTicks()
 /// Arrange for the CPU to be interrupted when simulated time reaches `now +
 /// when`.
 ///
-/// Implementation: just put it on a sorted list.
+/// Implementation: put it on a heap, reusing an interrupt that already
+/// fired if there is one.
 ///
 /// NOTE: the Nachos kernel should not call this routine directly.  Instead,
 /// it is only called by the hardware device simulators.
@@ -288,13 +389,22 @@ Interrupt::Schedule(VoidFunctionPtr handler, void *arg,
 #endif
 
     unsigned when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg,
-                                                     when, type);
+    PendingInterrupt *toOccur = freePending;
+    if (toOccur != nullptr) {
+        freePending = toOccur->nextFree;
+        toOccur->handler = handler;
+        toOccur->arg     = arg;
+        toOccur->when    = when;
+        toOccur->type    = type;
+    } else {
+        toOccur = new PendingInterrupt(handler, arg, when, type);
+    }
+    toOccur->order = numScheduled++;
 
     DEBUG('i', "Scheduling interrupt handler for the %s at time = %u\n",
           INT_TYPE_NAMES[type], when);
 
-    pending->SortedInsert(toOccur, when);
+    PushPending(toOccur);
 }
 
 /// Check if an interrupt is scheduled to occur, and if so, fire it off.
@@ -309,35 +419,34 @@ bool
 Interrupt::CheckIfDue(bool advanceClock)
 {
     MachineStatus old = status;
-    unsigned      when;
 
     ASSERT(level == INT_OFF);  // Interrupts need to be disabled, to invoke
                                // an interrupt handler.
     if (debug.IsEnabled('i')) {
         DumpState();
     }
-    PendingInterrupt *toOccur = pending->SortedPop((int *) &when);
 
-    if (toOccur == nullptr) {  // No pending interrupts.
+    if (numPending == 0) {  // No pending interrupts.
         return false;
     }
+    PendingInterrupt *toOccur = pending[0];
+    unsigned long when = toOccur->when;
 
     if (advanceClock && when > stats->totalTicks) {  // Advance the clock.
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {  // Not time yet, put it back.
-        pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks) {  // Not time yet.
         return false;
     }
 
     // Check if there is nothing more to do, and if so, quit.
     if (status == IDLE_MODE && toOccur->type == TIMER_INT
-          && pending->IsEmpty()) {
-        pending->SortedInsert(toOccur, when);
+          && numPending == 1) {
         return false;
     }
+    PopPending();
 
-    DEBUG('i', "Invoking interrupt handler for the %s at time %u\n",
+    DEBUG('i', "Invoking interrupt handler for the %s at time %lu\n",
             INT_TYPE_NAMES[toOccur->type], toOccur->when);
 #ifdef USER_PROGRAM
     if (machine != nullptr) {
@@ -350,7 +459,8 @@ Interrupt::CheckIfDue(bool advanceClock)
     (*toOccur->handler)(toOccur->arg);  // Call the interrupt handler.
     status = old;  // Restore the machine status.
     inHandler = false;
-    delete toOccur;
+    toOccur->nextFree = freePending;
+    freePending = toOccur;
     return true;
 }
 
@@ -390,10 +500,19 @@ Interrupt::DumpState()
 {
     printf("Time: %lu, interrupts %s\n",
         stats->totalTicks, INT_LEVEL_NAMES[level]);
-    if (pending->IsEmpty()) {
+    if (numPending == 0) {
         printf("No pending interrupts\n");
     } else {
+        // Se imprimen en el orden en que van a vencer.
+        PendingInterrupt **sorted = new PendingInterrupt * [numPending];
+        for (unsigned i = 0; i < numPending; i++) {
+            sorted[i] = pending[i];
+        }
+        std::sort(sorted, sorted + numPending, Earlier);
         printf("Pending interrupts:\n");
-        pending->Apply(PrintPending);
+        for (unsigned i = 0; i < numPending; i++) {
+            PrintPending(sorted[i]);
+        }
+        delete [] sorted;
     }
 }
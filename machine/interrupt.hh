@@ -85,6 +85,13 @@ public:
     void *arg;  ///< The argument to the function.
     unsigned long when;  ///< When the interrupt is supposed to fire.
     IntType type;  ///< For debugging.
+
+    /// Orden en que se programó, así las que vencen en el mismo tick se
+    /// atienden en ese orden.
+    unsigned long order;
+
+    /// Siguiente interrupción libre, mientras está en el *pool*.
+    PendingInterrupt *nextFree;
 };
 
 /// The following class defines the data structures for the simulation
@@ -143,10 +150,31 @@ public:
     /// Advance simulated time.
     void OneTick();
 
+    /// Ticks que faltan para la próxima interrupción pendiente, o
+    /// `ULONG_MAX` si no hay ninguna.
+    unsigned long TicksBeforeDue() const;
+
+    /// Avanza un tick de usuario sin revisar las interrupciones.  Sólo se
+    /// puede usar si `TicksBeforeDue` asegura que ninguna vence con él.
+    void SkipUserTick();
+
 private:
     IntStatus level;  ///< Are interrupts enabled or disabled?
-    List<PendingInterrupt *> *pending;  ///< The list of interrupts scheduled
-                                        ///< to occur in the future.
+    /// Interrupciones programadas, en un *heap* binario ordenado por
+    /// `when` y `order`.
+    PendingInterrupt **pending;
+    unsigned numPending;
+    unsigned pendingCapacity;
+
+    /// Tick de la próxima interrupción, o `ULONG_MAX` si no hay.  Así
+    /// `OneTick` sólo compara en vez de revisar el *heap*.
+    unsigned long nextDue;
+
+    /// Interrupciones ya atendidas, para reusarlas en `Schedule`.
+    PendingInterrupt *freePending;
+
+    /// Interrupciones programadas desde el arranque.
+    unsigned long numScheduled;
     bool inHandler;  ///< True if we are running an interrupt handler.
     bool yieldOnReturn;  ///< True if we are to context switch on return from
                          ///< the interrupt handler.
@@ -161,6 +189,10 @@ private:
     void ChangeLevel(IntStatus old,
                      IntStatus now);
 
+    /// Agrega una interrupción al *heap* o saca la primera.
+    void PushPending(PendingInterrupt *pend);
+    PendingInterrupt *PopPending();
+
 #ifdef DFS_TICKS_FIX
     /// Restart total ticks and the pending interrupt list.
     void RestartTicks();
@@ -50,7 +50,10 @@ Machine::~Machine()
 /// * `st` -- pointer to an object that performs single stepping, for
 ///   dropping into it after each user instruction is executed; if null,
 ///   execute normally, without single stepping.
-Machine::Machine(SingleStepper *st, unsigned aNumPhysicalPages): mmu(aNumPhysicalPages)
+/// * `aNumPhysicalPages` -- cantidad de marcos de la memoria física.
+/// * `aTlbSize` -- cantidad de entradas de la TLB, si la hay.
+Machine::Machine(SingleStepper *st, unsigned aNumPhysicalPages,
+                 unsigned aTlbSize): mmu(aNumPhysicalPages, aTlbSize)
 {
     for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
         registers[i] = 0;
@@ -61,6 +64,7 @@ Machine::Machine(SingleStepper *st, unsigned aNumPhysicalPages): mmu(aNumPhysica
     }
 
     singleStepper = st;
+    numExceptions = 0;
     CheckEndian();
 
     unsigned memory_size = aNumPhysicalPages * PAGE_SIZE;
@@ -129,6 +133,37 @@ Machine::WriteMem(unsigned addr, unsigned size, int value)
     return true;
 }
 
+template <unsigned SIZE>
+bool
+Machine::Read(unsigned addr, int *value)
+{
+    ExceptionType e = mmu.Read<SIZE>(addr, value);
+    if (e != NO_EXCEPTION) {
+        RaiseException(e, addr);
+        return false;
+    }
+    return true;
+}
+
+template <unsigned SIZE>
+bool
+Machine::Write(unsigned addr, int value)
+{
+    ExceptionType e = mmu.Write<SIZE>(addr, value);
+    if (e != NO_EXCEPTION) {
+        RaiseException(e, addr);
+        return false;
+    }
+    return true;
+}
+
+template bool Machine::Read<1>(unsigned addr, int *value);
+template bool Machine::Read<2>(unsigned addr, int *value);
+template bool Machine::Read<4>(unsigned addr, int *value);
+template bool Machine::Write<1>(unsigned addr, int value);
+template bool Machine::Write<2>(unsigned addr, int value);
+template bool Machine::Write<4>(unsigned addr, int value);
+
 /// Transfer control to the Nachos kernel from user mode, because the user
 /// program either invoked a system call, or some exception occured (such as
 /// the address translation failed).
@@ -145,6 +180,7 @@ Machine::RaiseException(ExceptionType et, unsigned badVAddr)
 
     //ASSERT(interrupt->GetStatus() == USER_MODE);
     registers[BAD_VADDR_REG] = badVAddr;
+    numExceptions++;
     DelayedLoad(0, 0);  // Finish anything in progress.
 
     // Call the associated handler with interrupts enabled in system mode.
@@ -68,7 +68,7 @@ class Machine {
 public:
 
     /// Initialize the simulation of the hardware for running user programs.
-    Machine(SingleStepper *st, unsigned numPhysicalPages);
+    Machine(SingleStepper *st, unsigned numPhysicalPages, unsigned tlbSize);
 
     ~Machine();
     /// Routines callable by the Nachos kernel.
@@ -93,6 +93,13 @@ public:
 
     bool WriteMem(unsigned addr, unsigned size, int value);
 
+    /// Lo mismo con el tamaño fijo al compilar (1, 2 o 4).
+    template <unsigned SIZE>
+    bool Read(unsigned addr, int *value);
+
+    template <unsigned SIZE>
+    bool Write(unsigned addr, int value);
+
     /// Print the user CPU and memory state.
     void DumpState();
 
@@ -106,6 +113,12 @@ public:
     /// Run a certain instruction of a user program.
     void ExecInstruction(const Instruction *instr);
 
+    /// Ejecuta el bloque básico que empieza en el PC.  Las interrupciones
+    /// se revisan recién al final, así que sólo se ejecutan juntas las
+    /// instrucciones que terminan antes de la próxima interrupción: el
+    /// resultado es el mismo que de a una.
+    void RunBlock(Instruction *instr);
+
     /// Do a pending delayed load (modifying a reg).
     void DelayedLoad(unsigned nextReg, int nextVal);
 
@@ -138,6 +151,10 @@ private:
     MMU mmu; ///< Memory management unit.
 
     ExceptionHandler handlers[NUM_EXCEPTION_TYPES];  ///< Exception handlers.
+
+    /// Excepciones atendidas, para saber si una instrucción entró al
+    /// kernel.
+    unsigned long numExceptions;
     unsigned numPhysicalPages;
 };
 
@@ -36,6 +36,13 @@ Machine::Run()
     interrupt->SetStatus(USER_MODE);
 
     for (;;) {
+        // Con el depurador o las trazas de la máquina se va de a una
+        // instrucción, así se ve cada una.
+        if (singleStepper == nullptr && !debug.IsEnabled('m')
+              && !debug.IsEnabled('i')) {
+            RunBlock(instr);
+            continue;
+        }
         if (FetchInstruction(instr)) {
             ExecInstruction(instr);
         }
@@ -46,6 +53,48 @@ Machine::Run()
     }
 }
 
+void
+Machine::RunBlock(Instruction *instr)
+{
+    ASSERT(instr != nullptr);
+
+    unsigned start = registers[PC_REG];
+    unsigned length;
+    ExceptionType e = mmu.FetchBlock(start, instr, &length);
+    if (e != NO_EXCEPTION) {
+        RaiseException(e, start);
+        interrupt->OneTick();
+        return;
+    }
+
+    // Cada instrucción menos la última avanza el reloj sin revisar las
+    // interrupciones, así que ninguna puede vencer antes.
+    unsigned long due = interrupt->TicksBeforeDue();
+    unsigned long quiet = due > 0 ? (due - 1) / USER_TICK : 0;
+    if (length > quiet + 1) {
+        length = quiet + 1;
+    }
+
+    unsigned long exceptions = numExceptions;
+    for (unsigned i = 1; ; i++) {
+        ExecInstruction(instr);
+
+        // Si entró al kernel o saltó, el bloque terminó.  El PC sólo deja
+        // de ser consecutivo si el bloque empezó en un *delay slot*.
+        if (i == length || numExceptions != exceptions
+              || (unsigned) registers[PC_REG] != start + i * 4) {
+            break;
+        }
+        interrupt->SkipUserTick();
+        e = mmu.FetchInstruction(registers[PC_REG], instr);
+        if (e != NO_EXCEPTION) {
+            RaiseException(e, registers[PC_REG]);
+            break;
+        }
+    }
+    interrupt->OneTick();
+}
+
 /// Simulate effects of a delayed load.
 ///
 /// NOTE -- `RaiseException`/`CheckInterrupts` must also call `DelayedLoad`,
@@ -64,12 +113,11 @@ Machine::FetchInstruction(Instruction *instr)
 {
     ASSERT(instr != nullptr);
 
-    int raw;
-    if (!ReadMem(registers[PC_REG], 4, &raw)) {
+    ExceptionType e = mmu.FetchInstruction(registers[PC_REG], instr);
+    if (e != NO_EXCEPTION) {
+        RaiseException(e, registers[PC_REG]);
         return false;  // Exception occurred.
     }
-    instr->value = raw;
-    instr->Decode();
 
     if (debug.IsEnabled('m')) {
         const struct OpString *str = &OP_STRINGS[instr->opCode];
@@ -307,7 +355,7 @@ Machine::ExecInstruction(const Instruction *instr)
         case OP_LB:
         case OP_LBU:
             tmp = registers[instr->rs] + instr->extra;
-            if (!ReadMem(tmp, 1, &value)) {
+            if (!Read<1>(tmp, &value)) {
                 return;
             }
 
@@ -327,7 +375,7 @@ Machine::ExecInstruction(const Instruction *instr)
                 RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
                 return;
             }
-            if (!ReadMem(tmp, 2, &value)) {
+            if (!Read<2>(tmp, &value)) {
                 return;
             }
 
@@ -351,7 +399,7 @@ Machine::ExecInstruction(const Instruction *instr)
                 RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
                 return;
             }
-            if (!ReadMem(tmp, 4, &value)) {
+            if (!Read<4>(tmp, &value)) {
                 return;
             }
             nextLoadReg = instr->rt;
@@ -366,7 +414,7 @@ Machine::ExecInstruction(const Instruction *instr)
             // would fail (I think) if the other cases are ever exercised.
             ASSERT((tmp & 0x3) == 0);
 
-            if (!ReadMem(tmp, 4, &value)) {
+            if (!Read<4>(tmp, &value)) {
                 return;
             }
             if (registers[LOAD_REG] == instr->rt) {
@@ -399,7 +447,7 @@ Machine::ExecInstruction(const Instruction *instr)
             // would fail (I think) if the other cases are ever exercised.
             ASSERT((tmp & 0x3) == 0);
 
-            if (!ReadMem(tmp, 4, &value)) {
+            if (!Read<4>(tmp, &value)) {
                 return;
             }
             if (registers[LOAD_REG] == instr->rt) {
@@ -469,15 +517,15 @@ Machine::ExecInstruction(const Instruction *instr)
             break;
 
         case OP_SB:
-            if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
-                          1, registers[instr->rt])) {
+            if (!Write<1>((unsigned) (registers[instr->rs] + instr->extra),
+                          registers[instr->rt])) {
                 return;
             }
             break;
 
         case OP_SH:
-            if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
-                          2, registers[instr->rt])) {
+            if (!Write<2>((unsigned) (registers[instr->rs] + instr->extra),
+                          registers[instr->rt])) {
                 return;
             }
             break;
@@ -550,8 +598,8 @@ Machine::ExecInstruction(const Instruction *instr)
             break;
 
         case OP_SW:
-            if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
-                          4, registers[instr->rt])) {
+            if (!Write<4>((unsigned) (registers[instr->rs] + instr->extra),
+                          registers[instr->rt])) {
                 return;
             }
             break;
@@ -563,7 +611,7 @@ Machine::ExecInstruction(const Instruction *instr)
             // the other cases are ever exercised.
             ASSERT((tmp & 0x3) == 0);
 
-            if (!ReadMem(tmp & ~0x3, 4, &value)) {
+            if (!Read<4>(tmp & ~0x3, &value)) {
                 return;
             }
             switch (tmp & 0x3) {
@@ -583,7 +631,7 @@ Machine::ExecInstruction(const Instruction *instr)
                             | (registers[instr->rt] >> 24 & 0xFF);
                     break;
             }
-            if (!WriteMem(tmp & ~0x3, 4, value)) {
+            if (!Write<4>(tmp & ~0x3, value)) {
                 return;
             }
             break;
@@ -595,7 +643,7 @@ Machine::ExecInstruction(const Instruction *instr)
             // the other cases are ever exercised.
             ASSERT((tmp & 0x3) == 0);
 
-            if (!ReadMem(tmp & ~0x3, 4, &value)) {
+            if (!Read<4>(tmp & ~0x3, &value)) {
                 return;
             }
             switch (tmp & 0x3) {
@@ -614,7 +662,7 @@ Machine::ExecInstruction(const Instruction *instr)
                     value = registers[instr->rt];
                     break;
             }
-            if (!WriteMem(tmp & ~0x3, 4, value)) {
+            if (!Write<4>(tmp & ~0x3, value)) {
                 return;
             }
             break;
@@ -38,18 +38,40 @@
 extern Machine* machine;
 
 
-MMU::MMU(unsigned aNumPhysPages)
+MMU::MMU(unsigned aNumPhysPages, unsigned aTlbSize)
 {
     numPhysicalPages = aNumPhysPages;
     memorySize = numPhysicalPages * PAGE_SIZE;
+    tlbAccesses = 0;
+    currentAsid = 0;
+    fetchCache.entry = nullptr;
+    dataCache.entry  = nullptr;
+    FlushMicroTlb();
+    decoded = new Instruction [memorySize / 4];
+    decodedValid = new bool [memorySize / 4];
+    blockLength = new unsigned [memorySize / 4];
+    for (unsigned i = 0; i < memorySize / 4; i++) {
+        decodedValid[i] = false;
+        blockLength[i] = 0;
+    }
+    frameDecoded = new bool [numPhysicalPages];
+    for (unsigned i = 0; i < numPhysicalPages; i++) {
+        frameDecoded[i] = false;
+    }
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLB_SIZE]; /// Pequeña TLB 
-    for (unsigned i = 0; i < TLB_SIZE; i++) { /// La inicializa
+    ASSERT(aTlbSize > 0);
+    tlbSize = aTlbSize;
+    tlb = new TranslationEntry[tlbSize]; /// Pequeña TLB 
+    tlbLastUse = new unsigned long[tlbSize];
+    for (unsigned i = 0; i < tlbSize; i++) { /// La inicializa
         tlb[i].valid = false;
+        tlbLastUse[i] = 0;
     }
     pageTable = nullptr;
 #else  // Use linear page table.
+    tlbSize = 0;
     tlb = nullptr;
+    tlbLastUse = nullptr;
     pageTable = nullptr;
 #endif
    
@@ -59,18 +81,23 @@ MMU::~MMU()
 {
     if (tlb != nullptr) {
         delete [] tlb;
+        delete [] tlbLastUse;
     }
+    delete [] decoded;
+    delete [] decodedValid;
+    delete [] blockLength;
+    delete [] frameDecoded;
 }
 
 void
 MMU::PrintTLB() const
 {
 #ifdef USE_TLB
-    printf("TLB content (%u entries):\n", TLB_SIZE);
-    for (unsigned i = 0; i < TLB_SIZE; i++) {
+    printf("TLB content (%u entries):\n", tlbSize);
+    for (unsigned i = 0; i < tlbSize; i++) {
         const TranslationEntry *e = &tlb[i];
-        printf("(%u) valid: %d, virt: %d, frame: %d, flags: %s%s%s\n",
-               i, e->valid, e->virtualPage, e->physicalPage,
+        printf("(%u) valid: %d, asid: %u, virt: %d, frame: %d, flags: %s%s%s\n",
+               i, e->valid, e->asid, e->virtualPage, e->physicalPage,
                (e->readOnly) ? "readonly " : "",
                (e->use)      ? "use " : "",
                (e->dirty)    ? "dirty" : "");
@@ -80,6 +107,102 @@ MMU::PrintTLB() const
 #endif
 }
 
+/// Pasan `SIZE` bytes entre la memoria simulada, que es little endian, y
+/// el formato del host.  Si el host también es little endian no hay nada
+/// que convertir y el compilador las reduce a una copia.
+template <unsigned SIZE>
+static inline int
+LoadFromMemory(const char *where)
+{
+    if (SIZE == 1) {
+        return *where;
+    }
+#ifdef HOST_IS_BIG_ENDIAN
+    if (SIZE == 2) {
+        return ShortToHost(*(const unsigned short *) where);
+    }
+    return WordToHost(*(const unsigned *) where);
+#else
+    if (SIZE == 2) {
+        return *(const unsigned short *) where;
+    }
+    return *(const unsigned *) where;
+#endif
+}
+
+template <unsigned SIZE>
+static inline void
+StoreToMemory(char *where, int value)
+{
+    if (SIZE == 1) {
+        *where = (unsigned char) (value & 0xFF);
+        return;
+    }
+#ifdef HOST_IS_BIG_ENDIAN
+    if (SIZE == 2) {
+        *(unsigned short *) where
+          = ShortToMachine((unsigned short) (value & 0xFFFF));
+        return;
+    }
+    *(unsigned *) where = WordToMachine((unsigned) value);
+#else
+    if (SIZE == 2) {
+        *(unsigned short *) where = (unsigned short) (value & 0xFFFF);
+        return;
+    }
+    *(unsigned *) where = (unsigned) value;
+#endif
+}
+
+template <unsigned SIZE>
+ExceptionType
+MMU::Read(unsigned addr, int *value)
+{
+    static_assert(SIZE == 1 || SIZE == 2 || SIZE == 4, "bad access size");
+    ASSERT(value != nullptr);
+
+    DEBUG('a', "Reading VA 0x%X, size %u\n", addr, SIZE);
+
+    unsigned physicalAddress;
+    ExceptionType e = Translate(addr, &physicalAddress, SIZE, false,
+                                &dataCache);
+    if (e != NO_EXCEPTION) {
+        return e;
+    }
+    *value = LoadFromMemory<SIZE>(&machine->mainMemory[physicalAddress]);
+
+    DEBUG('a', "\tValue read: %8.8X\n", *value);
+    return NO_EXCEPTION;
+}
+
+template <unsigned SIZE>
+ExceptionType
+MMU::Write(unsigned addr, int value)
+{
+    static_assert(SIZE == 1 || SIZE == 2 || SIZE == 4, "bad access size");
+
+    DEBUG('a', "Writing VA 0x%X, size %u, value 0x%X\n", addr, SIZE, value);
+
+    unsigned physicalAddress;
+    ExceptionType e = Translate(addr, &physicalAddress, SIZE, true,
+                                &dataCache);
+    if (e != NO_EXCEPTION) {
+        return e;
+    }
+    if (frameDecoded[physicalAddress / PAGE_SIZE]) {
+        ForgetDecodes(physicalAddress / PAGE_SIZE);
+    }
+    StoreToMemory<SIZE>(&machine->mainMemory[physicalAddress], value);
+    return NO_EXCEPTION;
+}
+
+template ExceptionType MMU::Read<1>(unsigned addr, int *value);
+template ExceptionType MMU::Read<2>(unsigned addr, int *value);
+template ExceptionType MMU::Read<4>(unsigned addr, int *value);
+template ExceptionType MMU::Write<1>(unsigned addr, int value);
+template ExceptionType MMU::Write<2>(unsigned addr, int value);
+template ExceptionType MMU::Write<4>(unsigned addr, int value);
+
 /// Read `size` (1, 2, or 4) bytes of virtual memory at `addr` into
 /// the location pointed to by `value`.
 ///
@@ -92,39 +215,17 @@ MMU::PrintTLB() const
 ExceptionType
 MMU::ReadMem(unsigned addr, unsigned size, int *value)
 {
-    ASSERT(value != nullptr);
-
-    DEBUG('a', "Reading VA 0x%X, size %u\n", addr, size);
-
-    unsigned physicalAddress;
-    ExceptionType e = Translate(addr, &physicalAddress, size, false);
-    if (e != NO_EXCEPTION) {
-        return e;
-    }
-
-    int data;
     switch (size) {
         case 1:
-            data = machine->mainMemory[physicalAddress];
-            *value = data;
-            break;
-
+            return Read<1>(addr, value);
         case 2:
-            data = *(unsigned short *) &(machine->mainMemory[physicalAddress]);
-            *value = ShortToHost(data);
-            break;
-
+            return Read<2>(addr, value);
         case 4:
-            data = *(unsigned *) &(machine->mainMemory[physicalAddress]);
-            *value = WordToHost(data);
-            break;
-
+            return Read<4>(addr, value);
         default:
             ASSERT(false);
+            return ADDRESS_ERROR_EXCEPTION;
     }
-
-    DEBUG('a', "\tValue read: %8.8X\n", *value);
-    return NO_EXCEPTION;
 }
 
 /// Write `size` (1, 2, or 4) bytes of the contents of `value` into virtual
@@ -139,39 +240,158 @@ MMU::ReadMem(unsigned addr, unsigned size, int *value)
 ExceptionType
 MMU::WriteMem(unsigned addr, unsigned size, int value)
 {
-    DEBUG('a', "Writing VA 0x%X, size %u, value 0x%X\n", addr, size, value);
+    switch (size) {
+        case 1:
+            return Write<1>(addr, value);
+        case 2:
+            return Write<2>(addr, value);
+        case 4:
+            return Write<4>(addr, value);
+        default:
+            ASSERT(false);
+            return ADDRESS_ERROR_EXCEPTION;
+    }
+}
 
+void
+MMU::DecodeWord(unsigned word)
+{
+    if (!decodedValid[word]) {
+        decoded[word].value = LoadFromMemory<4>(&machine->mainMemory[word * 4]);
+        decoded[word].Decode();
+        decodedValid[word] = true;
+        frameDecoded[word * 4 / PAGE_SIZE] = true;
+    }
+}
+
+ExceptionType
+MMU::FetchWord(unsigned addr, unsigned *word)
+{
     unsigned physicalAddress;
-    ExceptionType e = Translate(addr, &physicalAddress, size, true);
+    ExceptionType e = Translate(addr, &physicalAddress, 4, false,
+                                &fetchCache);
     if (e != NO_EXCEPTION) {
         return e;
     }
+    *word = physicalAddress / 4;
+    DecodeWord(*word);
+    return NO_EXCEPTION;
+}
 
-    switch (size) {
-        case 1:
-            machine->mainMemory[physicalAddress]
-              = (unsigned char) (value & 0xFF);
-            break;
-
-        case 2:
-            *(unsigned short *) &(machine->mainMemory[physicalAddress])
-              = ShortToMachine((unsigned short) (value & 0xFFFF));
-            break;
+ExceptionType
+MMU::FetchInstruction(unsigned addr, Instruction *instr)
+{
+    ASSERT(instr != nullptr);
 
-        case 4:
-            *(unsigned *) &(machine->mainMemory[physicalAddress])
-              = WordToMachine((unsigned) value);
-            break;
+    unsigned word;
+    ExceptionType e = FetchWord(addr, &word);
+    if (e != NO_EXCEPTION) {
+        return e;
+    }
+    *instr = decoded[word];
+    return NO_EXCEPTION;
+}
 
+/// Si la instrucción es un salto: después de su *delay slot* el programa
+/// puede seguir en otro lado.
+static bool
+IsJump(const Instruction *instr)
+{
+    switch (instr->opCode) {
+        case OP_BEQ:
+        case OP_BGEZ:
+        case OP_BGEZAL:
+        case OP_BGTZ:
+        case OP_BLEZ:
+        case OP_BLTZ:
+        case OP_BLTZAL:
+        case OP_BNE:
+        case OP_J:
+        case OP_JAL:
+        case OP_JALR:
+        case OP_JR:
+            return true;
         default:
-            ASSERT(false);
+            return false;
     }
+}
 
+/// Si la instrucción siempre entra al kernel.
+static bool
+Traps(const Instruction *instr)
+{
+    return instr->opCode == OP_SYSCALL || instr->opCode == OP_RES
+             || instr->opCode == OP_UNIMP;
+}
+
+ExceptionType
+MMU::FetchBlock(unsigned addr, Instruction *instr, unsigned *length)
+{
+    ASSERT(instr != nullptr);
+    ASSERT(length != nullptr);
+
+    unsigned word;
+    ExceptionType e = FetchWord(addr, &word);
+    if (e != NO_EXCEPTION) {
+        return e;
+    }
+    *instr = decoded[word];
+
+    if (blockLength[word] == 0) {
+        // El bloque no pasa a la página siguiente: en la memoria física
+        // puede estar en cualquier otro marco.
+        unsigned last = (word * 4 / PAGE_SIZE + 1) * PAGE_SIZE / 4;
+        unsigned end = word;
+        while (end < last) {
+            DecodeWord(end);
+            const Instruction *in = &decoded[end++];
+            if (Traps(in)) {
+                break;
+            }
+            if (IsJump(in)) {
+                if (end < last) {
+                    end++;  // El *delay slot*.
+                }
+                break;
+            }
+        }
+        blockLength[word] = end - word;
+    }
+    *length = blockLength[word];
     return NO_EXCEPTION;
 }
 
+void
+MMU::ForgetDecodes(unsigned frame)
+{
+    ASSERT(frame < numPhysicalPages);
+
+    if (!frameDecoded[frame]) {
+        return;
+    }
+    unsigned first = frame * PAGE_SIZE / 4;
+    for (unsigned i = first; i < first + PAGE_SIZE / 4; i++) {
+        decodedValid[i] = false;
+        blockLength[i] = 0;
+    }
+    frameDecoded[frame] = false;
+}
+
+ExceptionType
+MMU::TranslateForKernel(unsigned addr, bool writing, unsigned *physAddr)
+{
+    return Translate(addr, physAddr, 1, writing, &dataCache);
+}
+
+void
+MMU::FlushMicroTlb()
+{
+    fetchCache.valid = false;
+    dataCache.valid = false;
+}
+
 ExceptionType
-MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const
+MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry)
 {
     ASSERT(entry != nullptr);
 
@@ -197,10 +417,13 @@ MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const
         // Use the TLB. --> No usamos mas la tabla de paginacion.
 
         unsigned i;
-        for (i = 0; i < TLB_SIZE; i++) {
+        tlbAccesses++;
+        for (i = 0; i < tlbSize; i++) {
             TranslationEntry *e = &tlb[i];
-            if (e->valid && e->virtualPage == vpn) {
+            if (e->valid && e->asid == currentAsid
+                  && e->virtualPage == vpn) {
                 *entry = e;  // FOUND!
+                tlbLastUse[i] = tlbAccesses;
                 stats->numPageHits++;
                 return NO_EXCEPTION;
             }
@@ -227,29 +450,52 @@ MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const
 /// * `physAddr" is the place to store the physical address.
 /// * `size" is the amount of memory being read or written.
 /// * `writing` -- if true, check the “read-only” bit in the TLB.
+/// * `cache` -- última traducción de este tipo de acceso.
 ExceptionType
 MMU::Translate(unsigned virtAddr, unsigned *physAddr,
-               unsigned size, bool writing)
+               unsigned size, bool writing, MicroTlb *cache)
 {
     ASSERT(physAddr != nullptr);
+    ASSERT(cache != nullptr);
+
+    // Calculate the virtual page number, and offset within the page,
+    // from the virtual address.
+    unsigned vpn    = (unsigned) virtAddr / PAGE_SIZE;
+    unsigned offset = (unsigned) virtAddr % PAGE_SIZE;
+    bool aligned = !((size == 4 && virtAddr & 0x3)
+                       || (size == 2 && virtAddr & 0x1));
+
+    // Camino rápido: la misma página que el acceso anterior.  Cuenta como
+    // un acierto de la TLB, igual que el camino largo.
+    TranslationEntry *entry = cache->entry;
+    if (cache->valid && cache->vpn == vpn && aligned
+          && entry->valid && entry->virtualPage == vpn
+          && !(entry->readOnly && writing)) {
+        if (tlb != nullptr) {
+            tlbAccesses++;
+            tlbLastUse[cache->slot] = tlbAccesses;
+            stats->numPageHits++;
+        }
+        entry->use = true;
+        if (writing) {
+            entry->dirty = true;
+        }
+        *physAddr = entry->physicalPage * PAGE_SIZE + offset;
+        return NO_EXCEPTION;
+    }
+
     // We must have either a TLB or a page table, but not both!
     ASSERT((tlb == nullptr) != (pageTable == nullptr));
 
     DEBUG('a', "\tTranslate: ");
 
     // Check for alignment errors.
-    if ((size == 4 && virtAddr & 0x3) || (size == 2 && virtAddr & 0x1)) {
+    if (!aligned) {
         DEBUG_CONT('a', "alignment problem at %u, size %u!\n",
                    virtAddr, size);
         return ADDRESS_ERROR_EXCEPTION;
     }
 
-    // Calculate the virtual page number, and offset within the page,
-    // from the virtual address.
-    unsigned vpn    = (unsigned) virtAddr / PAGE_SIZE;
-    unsigned offset = (unsigned) virtAddr % PAGE_SIZE;
-
-    TranslationEntry *entry;
     ExceptionType exception = RetrievePageEntry(vpn, &entry);
     if (exception != NO_EXCEPTION) {
         return exception;
@@ -276,6 +522,11 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr,
         entry->dirty = true;
     }
 
+    cache->valid = true;
+    cache->vpn = vpn;
+    cache->entry = entry;
+    cache->slot = tlb != nullptr ? entry - tlb : 0;
+
     *physAddr = pageFrame * PAGE_SIZE + offset;
     ASSERT(*physAddr >= 0 && *physAddr + size <= memorySize);
     DEBUG_CONT('a', "physical address 0x%X\n", *physAddr);
@@ -11,6 +11,7 @@
 
 #include "exception_type.hh"
 #include "disk.hh"
+#include "instruction.hh"
 #include "translation_entry.hh"
 
 
@@ -22,10 +23,15 @@ const unsigned PAGE_SIZE = SECTOR_SIZE;  ///< Set the page size equal to the
 const unsigned DEFAULT_NUM_PHYS_PAGES = 32;
 //const unsigned MEMORY_SIZE = NUM_PHYS_PAGES * PAGE_SIZE;
 
-/// Number of entries in the TLB, if one is present.
+/// Number of entries in the TLB, if one is present, unless another size is
+/// given with `-tlb`.
 ///
 /// If there is a TLB, it will be small compared to page tables.
-const unsigned TLB_SIZE = 4;
+const unsigned DEFAULT_TLB_SIZE = 4;
+
+/// Cantidad de identificadores de espacio de direcciones (ASID) que
+/// distingue la TLB.
+const unsigned NUM_ASIDS = 64;
 
 
 /// This class simulates an MMU (memory management unit) that can use either
@@ -33,7 +39,7 @@ const unsigned TLB_SIZE = 4;
 class MMU {
 public:
     // Initialize the MMU subsystem.
-    MMU(unsigned numPhysicalPages);
+    MMU(unsigned numPhysicalPages, unsigned tlbSize);
 
     // Deallocate data structures.
     ~MMU();
@@ -45,6 +51,42 @@ public:
 
     ExceptionType WriteMem(unsigned addr, unsigned size, int value);
 
+    /// Lo mismo con el tamaño fijo al compilar: `SIZE` es 1, 2 o 4.  Son
+    /// las que usa el simulador en cada carga y almacenamiento.
+    template <unsigned SIZE>
+    ExceptionType Read(unsigned addr, int *value);
+
+    template <unsigned SIZE>
+    ExceptionType Write(unsigned addr, int value);
+
+    /// Lee y decodifica la instrucción en `addr`.  Recuerda su propia
+    /// última traducción y la instrucción ya decodificada de cada palabra
+    /// de la memoria física, así cada instrucción se decodifica una vez
+    /// por cada carga de su página.
+    ExceptionType FetchInstruction(unsigned addr, Instruction *instr);
+
+    /// Como `FetchInstruction`, pero además deja en `length` cuántas
+    /// instrucciones tiene el bloque básico que empieza en `addr`: hasta
+    /// el primer salto y su *delay slot*, una llamada al sistema o el fin
+    /// de la página.  El largo se calcula una vez por cada carga de la
+    /// página.
+    ExceptionType FetchBlock(unsigned addr, Instruction *instr,
+                             unsigned *length);
+
+    /// Olvida las instrucciones decodificadas del marco `frame`.  El kernel
+    /// la llama cuando le asigna el marco a otra página.
+    void ForgetDecodes(unsigned frame);
+
+    /// Traduce `addr` para que el kernel copie directo en `mainMemory`.
+    /// Marca la página como usada (y sucia si `writing`) igual que un
+    /// acceso del programa.
+    ExceptionType TranslateForKernel(unsigned addr, bool writing,
+                                     unsigned *physAddr);
+
+    /// Olvida las últimas traducciones.  El kernel la llama cuando carga
+    /// una entrada en la TLB y al cambiar de espacio de direcciones.
+    void FlushMicroTlb();
+
     void PrintTLB() const;
 
     /// Data structures -- all of these are accessible to Nachos kernel code.
@@ -76,14 +118,53 @@ public:
     TranslationEntry *tlb;  ///< This pointer should be considered
                             ///< “read-only” to Nachos kernel code.
 
+    unsigned tlbSize;  ///< Cantidad de entradas de la TLB.
+
+    /// Número de acceso del último acierto en cada entrada de la TLB.  Lo
+    /// lleva el hardware, así el kernel puede elegir a quién reemplazar.
+    unsigned long *tlbLastUse;
+
+    /// Accesos a la TLB desde que arrancó la máquina.
+    unsigned long tlbAccesses;
+
+    /// ASID del espacio de direcciones que corre.  Las entradas de la TLB
+    /// de otros espacios se ignoran, así no hace falta invalidarlas en
+    /// cada cambio de contexto.
+    unsigned currentAsid;
+
     TranslationEntry *pageTable;
     unsigned pageTableSize;
 
 private:
 
+    /// Última traducción usada.  Se lleva una para buscar instrucciones y
+    /// otra para los datos, así los accesos seguidos a la misma página no
+    /// recorren la TLB.  Antes de usarla se comprueba que la entrada siga
+    /// siendo válida para esa página.
+    struct MicroTlb {
+        bool valid;
+        unsigned vpn;
+        TranslationEntry *entry;
+        unsigned slot;  ///< Entrada de la TLB, si la hay.
+    };
+
+    MicroTlb fetchCache;
+    MicroTlb dataCache;
+
+    /// Instrucción decodificada de cada palabra de la memoria física.
+    Instruction *decoded;
+    bool *decodedValid;
+
+    /// Largo del bloque básico que empieza en cada palabra, o 0 si todavía
+    /// no se calculó.
+    unsigned *blockLength;
+
+    /// Si el marco tiene alguna instrucción decodificada.
+    bool *frameDecoded;
+
     /// Retrieve a page entry either from a page table or the TLB.
     ExceptionType RetrievePageEntry(unsigned vpn,
-                                    TranslationEntry **entry) const;
+                                    TranslationEntry **entry);
 
     /// Translate an address, and check for alignment.
     ///
@@ -91,7 +172,14 @@ private:
     /// and return an exception code if the translation could not be
     /// completed.
     ExceptionType Translate(unsigned virtAddr, unsigned *physAddr,
-                            unsigned size, bool writing);
+                            unsigned size, bool writing, MicroTlb *cache);
+
+    /// Traduce la dirección de una instrucción y devuelve en `word` la
+    /// palabra de la memoria física donde está, ya decodificada.
+    ExceptionType FetchWord(unsigned addr, unsigned *word);
+
+    /// Decodifica la palabra `word` de la memoria física, si hace falta.
+    void DecodeWord(unsigned word);
     unsigned memorySize;
     unsigned numPhysicalPages;
 };
@@ -19,8 +19,17 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+#ifdef FILESYS
+    numDiskSeekTracks = 0;
+#endif
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPageHits = 0;
+#ifdef DEMAND_LOADING
+    numPagesPrefetched = numPrefetchHits = 0;
+#endif
+#ifdef PAGE_CACHE
+    numPageCacheHits = numPageCacheMisses = 0;
+#endif
 #ifdef DFS_TICKS_FIX
     tickResets = 0;
 #endif
@@ -41,6 +50,9 @@ Statistics::Print()
     printf("Ticks: total %lu, idle %lu, system %lu, user %lu\n",
            totalTicks, idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %lu, writes %lu\n", numDiskReads, numDiskWrites);
+    #ifdef FILESYS
+    printf("Disk seeks: %lu tracks\n", numDiskSeekTracks);
+    #endif
     printf("Console I/O: reads %lu, writes %lu\n",
            numConsoleCharsRead, numConsoleCharsWritten);
     #ifndef SWAP
@@ -48,5 +60,13 @@ Statistics::Print()
     #else
     printf("Paging: faults %lu, hits %lu, swap %lu\n", numPageFaults, numPageHits-numPageFaults, numPageSwap);
     #endif
+    #ifdef DEMAND_LOADING
+    printf("Prefetch: pages %lu, used %lu\n",
+           numPagesPrefetched, numPrefetchHits);
+    #endif
+    #ifdef PAGE_CACHE
+    printf("Page cache: hits %lu, misses %lu\n",
+           numPageCacheHits, numPageCacheMisses);
+    #endif
     //printf("Hit TLB ratio: %.3lf%%\n", (numPageFaults/(numPageHits-numPageFaults))*100);
 }
@@ -38,6 +38,11 @@ public:
     /// Number of disk write requests.
     unsigned long numDiskWrites;
 
+    #ifdef FILESYS
+    /// Pistas recorridas por el cabezal del disco.
+    unsigned long numDiskSeekTracks;
+    #endif
+
     /// Number of characters read from the keyboard.
     unsigned long numConsoleCharsRead;
 
@@ -55,6 +60,18 @@ public:
     unsigned long numPageSwap;
     #endif
 
+    #ifdef DEMAND_LOADING
+    /// Páginas cargadas por adelantado en los fallos y cuántas se usaron.
+    unsigned long numPagesPrefetched;
+    unsigned long numPrefetchHits;
+    #endif
+
+    #ifdef PAGE_CACHE
+    /// Páginas de archivo encontradas y no encontradas en la caché.
+    unsigned long numPageCacheHits;
+    unsigned long numPageCacheMisses;
+    #endif
+
 #ifdef DFS_TICKS_FIX
     /// Number of times the tick count gets reset.
     unsigned long tickResets;
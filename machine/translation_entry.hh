@@ -54,6 +54,11 @@ public:
     /// This bit is set by the hardware every time the page is modified.
     bool dirty;
 
+    /// Espacio de direcciones al que pertenece la traducción.  Sólo lo
+    /// mira la TLB: una entrada acierta si además coincide con
+    /// `MMU::currentAsid`.
+    unsigned asid;
+
 };
 
 
@@ -12,10 +12,13 @@
 ///
 ///     nachos [-d <debugflags>] [-do <debugopts>] 
 ///            [-rs <random seed #>] [-z] [-tt|-tN] 
-///            [-m <num phys pages>]
+///            [-m <num phys pages>] [-tlb <entries>] [-tlbp <policy>]
 ///            [-s] [-x <nachos file>] [-tc <consoleIn> <consoleOut>] 
-///            [-f] [-cp <unix file> <nachos file>] [-pr <nachos file>]
+///            [-f] [-geom <sector size>:<sectors per track>:<tracks>]
+///            [-bs <sectors per block>]
+///            [-cp <unix file> <nachos file>] [-pr <nachos file>]
 ///            [-rm <nachos file>] [-ls] [-D] [-c] [-tf]
+///            [-defrag] [-defragd] [-fsbench <name>[:<n>[:<size>]]]
 ///
 /// General options
 /// ---------------
@@ -41,11 +44,18 @@
 /// * `-s`  -- causes user programs to be executed in single-step mode.
 /// * `-x`  -- runs a user program.
 /// * `-tc` -- tests the console.
+/// * `-tlb` -- cantidad de entradas de la TLB (con *USE_TLB*).
+/// * `-tlbp` -- política de reemplazo de la TLB: `invalid-first`, `random`,
+///            `fifo`, `lru` o `clock` (ver `userprog/tlb_policy.hh`).
 ///
 /// *FILESYS* options
 /// -----------------
 ///
 /// * `-f`  -- causes the physical disk to be formatted.
+/// * `-geom` -- geometry to format the disk with (only together with `-f`);
+///            the sector size must be the compiled-in one.
+/// * `-bs` -- sectors per file system block (1, 2, 4 or 8; only together
+///            with `-f`).
 /// * `-cp` -- copies a file from UNIX to Nachos.
 /// * `-pr` -- prints a Nachos file to standard output.
 /// * `-rm` -- removes a Nachos file from the file system.
@@ -53,6 +63,11 @@
 /// * `-D`  -- prints the contents of the entire file system.
 /// * `-c`  -- checks the filesystem integrity.
 /// * `-tf` -- tests the performance of the Nachos file system.
+/// * `-fsbench` -- corre benchmarks del sistema de archivos e imprime los
+///            resultados en CSV (ver `filesys/fs_bench.cc`).
+/// * `-defrag` -- desfragmenta el disco y compacta el espacio libre.
+/// * `-defragd` -- corre el desfragmentador en un thread de fondo, que se
+///            despierta cuando se borran archivos.
 ///
 /// ----
 ///
@@ -84,6 +99,7 @@
 void Copy(const char *unixFile, const char *nachosFile);
 void Print(const char *file);
 void PerformanceTest(void);
+void FsBench(const char *spec);
 void StartProcess(const char *file);
 void ConsoleTest(const char *in, const char *out);
 
@@ -178,6 +194,12 @@ main(int argc, char **argv)
             printf("Filesystem check %s.\n", result ? "succeeded" : "failed");
         } else if (!strcmp(*argv, "-tf")) {  // Performance test.
             PerformanceTest();
+        } else if (!strcmp(*argv, "-fsbench")) {  // Benchmarks.
+            ASSERT(argc > 1);
+            FsBench(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-defrag")) {  // Defragment the disk.
+            defragmenter->Run(true);
         }
 #endif
     }
@@ -5,7 +5,11 @@
 #include "filesys/raw_file_header.hh"
 #include "filesys/raw_indirect_node.hh"
 
-#ifdef USER_PROGRAM
+#ifdef FILESYS
+#include "filesys/file_header.hh"
+#endif
+
+#if defined(USER_PROGRAM) || defined(FILESYS)
 #include "system.hh"
 #else
 #include "machine/mmu.hh"
@@ -59,7 +63,7 @@ Memory:\n\
   Number of pages: %u.\n\
   Number of TLB entries: %u.\n\
   Memory size: %u bytes.\n", 
-      PAGE_SIZE, machine->GetNumPhysicalPages(), TLB_SIZE, machine->GetNumPhysicalPages() * PAGE_SIZE);
+      PAGE_SIZE, machine->GetNumPhysicalPages(), machine->GetMMU()->tlbSize, machine->GetNumPhysicalPages() * PAGE_SIZE);
 #else
       printf("\n\
 Memory:\n\
@@ -67,7 +71,24 @@ Memory:\n\
   Number of pages: %u.\n\
   Number of TLB entries: %u.\n\
   Memory size: %u bytes.\n", 
-      PAGE_SIZE, DEFAULT_NUM_PHYS_PAGES, TLB_SIZE, DEFAULT_NUM_PHYS_PAGES * PAGE_SIZE);
+      PAGE_SIZE, DEFAULT_NUM_PHYS_PAGES, DEFAULT_TLB_SIZE, DEFAULT_NUM_PHYS_PAGES * PAGE_SIZE);
+#endif
+
+#ifdef FILESYS
+    // El disco montado pudo formatearse con otra geometría (`-geom`) y
+    // otro tamaño de bloque (`-bs`).
+    unsigned sectorsPerTrack = synchDisk->GetSectorsPerTrack();
+    unsigned numTracks       = synchDisk->GetNumTracks();
+    unsigned numSectors      = synchDisk->GetNumSectors();
+    unsigned freeMapSize     = fileSystem->GetFreeMap()->GetFileSize();
+    unsigned maxFileSize     = MAX_FILE_SIZE
+                                 * FileHeader::GetSectorsPerBlock();
+#else
+    unsigned sectorsPerTrack = SECTORS_PER_TRACK;
+    unsigned numTracks       = NUM_TRACKS;
+    unsigned numSectors      = NUM_SECTORS;
+    unsigned freeMapSize     = NUM_SECTORS / BITS_IN_BYTE;
+    unsigned maxFileSize     = MAX_FILE_SIZE;
 #endif
 
     printf("\n\
@@ -77,7 +98,8 @@ Disk:\n\
   Number of tracks: %u.\n\
   Number of sectors: %u.\n\
   Disk size: %lu bytes.\n",
-      SECTOR_SIZE, SECTORS_PER_TRACK, NUM_TRACKS, NUM_SECTORS, sizeof(int) + NUM_SECTORS * SECTOR_SIZE);
+      SECTOR_SIZE, sectorsPerTrack, numTracks, numSectors,
+      sizeof(int) + (unsigned long) numSectors * SECTOR_SIZE);
     printf("\n\
 Filesystem:\n\
   Sectors per header: %u.\n\
@@ -86,6 +108,6 @@ Filesystem:\n\
   Free sectors map size: %u bytes.\n\
   Maximum number of dir-entries: %u.\n\
   Directory file size: %u bytes.\n",
-      NUM_DIRECT*NUM_INDIRECT, MAX_FILE_SIZE, FILE_NAME_MAX_LEN,
-      FREE_MAP_FILE_SIZE, NUM_DIR_ENTRIES, DIRECTORY_FILE_SIZE);
+      NUM_DIRECT*NUM_INDIRECT, maxFileSize, FILE_NAME_MAX_LEN,
+      freeMapSize, NUM_DIR_ENTRIES, DIRECTORY_FILE_SIZE);
 }
@@ -11,6 +11,7 @@
 #ifdef USER_PROGRAM
 #include "userprog/debugger.hh"
 #include "userprog/exception.hh"
+#include "userprog/tlb_policy.hh"
 #endif
 
 #include <stdlib.h>
@@ -37,6 +38,7 @@ FileSystem *fileSystem;
 
 #ifdef FILESYS
 SynchDisk *synchDisk;
+Defragmenter *defragmenter;
 #endif
 
 #ifdef USER_PROGRAM  // Requires either *FILESYS* or *FILESYS_STUB*.
@@ -46,13 +48,22 @@ SynchConsole *synch_console;
 Bitmap *bit_map;
 
 ThreadMap *space_table;
-#ifdef SWAP
+#if defined(SWAP) || defined(PAGE_CACHE)
 CoreMap *core_map;
 #endif
 
+#ifdef PAGE_CACHE
+PageCache *pageCache;
+#endif
+
+#ifdef USE_TLB
+TlbPolicy *tlbPolicy;
+#endif
+
 #ifdef FILESYS
 FileTable *fileTable;
 DirTable *dirTable;
+AsyncIO *asyncIO;
 #endif
 
 #endif
@@ -140,10 +151,19 @@ Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
     bool debugUserProg = false;  // Single step user program.
     int numPhysicalPages = DEFAULT_NUM_PHYS_PAGES;
+    unsigned tlbSize = DEFAULT_TLB_SIZE;
+    TlbPolicyKind tlbPolicyKind = TLB_INVALID_FIRST;
 #endif
 #ifdef FILESYS_NEEDED
     bool format = false;  // Format disk.
 #endif
+#ifdef FILESYS
+    unsigned sectorsPerTrack = 0;  // Geometría pedida con `-geom`.
+    unsigned numTracks = 0;
+    unsigned sectorsPerBlock = 1;  // Tamaño de bloque pedido con `-bs`.
+    bool blockSizeGiven = false;
+    bool defragDaemon = false;     // Desfragmentador de fondo (`-defragd`).
+#endif
 
     for (argc--, argv++; argc > 0; argc -= argCount, argv += argCount) {
         argCount = 1;
@@ -175,13 +195,49 @@ Initialize(int argc, char **argv)
             numPhysicalPages = atoi(*(argv + 1));
             argCount = 2;
         }
+        if (!strcmp(*argv, "-tlb")) {
+            ASSERT(argc > 1);
+            tlbSize = atoi(*(argv + 1));
+            ASSERT(tlbSize > 0);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-tlbp")) {
+            ASSERT(argc > 1);
+            ASSERT(TlbPolicy::Parse(*(argv + 1), &tlbPolicyKind));
+            argCount = 2;
+        }
 #endif
 #ifdef FILESYS_NEEDED
         if (!strcmp(*argv, "-f")) {
             format = true;
         }
+#endif
+#ifdef FILESYS
+        if (!strcmp(*argv, "-geom")) {
+            ASSERT(argc > 1);
+            unsigned sectorSize;
+            ASSERT(sscanf(*(argv + 1), "%u:%u:%u", &sectorSize,
+                          &sectorsPerTrack, &numTracks) == 3);
+            // El tamaño de sector es fijo (ver `machine/disk.hh`).
+            ASSERT(sectorSize == SECTOR_SIZE);
+            ASSERT(sectorsPerTrack > 0 && numTracks > 0);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-bs")) {
+            ASSERT(argc > 1);
+            sectorsPerBlock = atoi(*(argv + 1));
+            ASSERT(sectorsPerBlock == 1 || sectorsPerBlock == 2
+                     || sectorsPerBlock == 4 || sectorsPerBlock == 8);
+            blockSizeGiven = true;
+            argCount = 2;
+        } else if (!strcmp(*argv, "-defragd")) {
+            defragDaemon = true;
+        }
 #endif
     }
+#ifdef FILESYS
+    // El tamaño de bloque se elige al formatear; al montar lo dice el
+    // superbloque.
+    ASSERT(format || !blockSizeGiven);
+#endif
 
     debug.SetFlags(debugFlags);  // Initialize `DEBUG` messages.
     debug.SetOpts(debugOpts);    // Set debugging behavior.
@@ -210,7 +266,10 @@ Initialize(int argc, char **argv)
     
     Debugger *d = debugUserProg ? new Debugger : nullptr;
     
-    machine = new Machine(d, numPhysicalPages);  // This must come first.
+    machine = new Machine(d, numPhysicalPages, tlbSize);  // This must come first.
+    #ifdef USE_TLB
+    tlbPolicy = new TlbPolicy(tlbPolicyKind);
+    #endif
     
     synch_console = new SynchConsole(nullptr,nullptr);
     
@@ -223,23 +282,41 @@ Initialize(int argc, char **argv)
     currentThread->SetPid(newpid);
     ASSERT(newpid != -1);
     
-    #ifdef SWAP
+    #if defined(SWAP) || defined(PAGE_CACHE)
     core_map = new CoreMap(numPhysicalPages);
     #endif
+
+    // Tiene que existir antes que el file system, que lee archivos al
+    // montarse.
+    #ifdef PAGE_CACHE
+    pageCache = new PageCache();
+    #endif
     
     #ifdef FILESYS
     fileTable = new FileTable();
     dirTable = new DirTable();
+    asyncIO = new AsyncIO();
     #endif
     
     SetExceptionHandlers();
 #endif
 
 #ifdef FILESYS
-    synchDisk = new SynchDisk("DISK");
+    // La geometría sólo se puede cambiar al formatear.
+    if (format) {
+        synchDisk = new SynchDisk("DISK", sectorsPerTrack, numTracks);
+    } else {
+        synchDisk = new SynchDisk("DISK");
+    }
 #endif
 
-#ifdef FILESYS_NEEDED
+#ifdef FILESYS
+    fileSystem = new FileSystem(format, sectorsPerBlock);
+    defragmenter = new Defragmenter();
+    if (defragDaemon) {
+        defragmenter->Start();
+    }
+#elif defined(FILESYS_NEEDED)
     fileSystem = new FileSystem(format);
 #endif
 
@@ -252,6 +329,9 @@ Cleanup()
     DEBUG('i', "Cleaning up...\n");
 
 #ifdef USER_PROGRAM
+    #ifdef USE_TLB
+    delete tlbPolicy;
+    #endif
     delete machine;
     delete synch_console;
     
@@ -269,8 +349,13 @@ Cleanup()
     delete space_table;
 
     #ifdef FILESYS
+    delete asyncIO;
     delete fileTable;
     #endif
+
+    #ifdef PAGE_CACHE
+    delete pageCache;
+    #endif
     
 #endif
 
@@ -279,6 +364,7 @@ Cleanup()
 #endif
 
 #ifdef FILESYS
+    delete defragmenter;
     delete synchDisk;
 #endif
 
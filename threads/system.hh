@@ -38,7 +38,7 @@ extern Timer *timer;                 ///< The hardware alarm clock.
 #include "machine/machine.hh"
 #include "lib/bitmap.hh"
 #include "threads/thread_map.hh"
-#ifdef SWAP
+#if defined(SWAP) || defined(PAGE_CACHE)
 #include "lib/coremap.hh"
 extern CoreMap *core_map; 
 #endif
@@ -46,11 +46,21 @@ extern Machine *machine;  // User program memory and registers.
 extern SynchConsole *synch_console;
 extern Bitmap *bit_map;
 extern ThreadMap *space_table;  // Table of threads, indexed by pid.
+#ifdef USE_TLB
+#include "userprog/tlb_policy.hh"
+extern TlbPolicy *tlbPolicy;  // Reemplazo de entradas de la TLB.
+#endif
 #ifdef FILESYS
 #include "lib/file_table.hh"
 #include "lib/dir_table.hh"
+#include "userprog/async_io.hh"
 extern FileTable *fileTable;
 extern DirTable *dirTable;
+extern AsyncIO *asyncIO;  // Pedidos de E/S asincrónica.
+#endif
+#ifdef PAGE_CACHE
+#include "filesys/page_cache.hh"
+extern PageCache *pageCache;  // Páginas de archivos en memoria física.
 #endif
 #endif
 
@@ -61,7 +71,9 @@ extern FileSystem *fileSystem;
 
 #ifdef FILESYS
 #include "filesys/synch_disk.hh"
+#include "filesys/defragmenter.hh"
 extern SynchDisk *synchDisk;
+extern Defragmenter *defragmenter;
 #endif
 
 #endif
@@ -96,6 +96,8 @@ Thread::Thread(const char *threadName, bool isJoin, int threadPriority)
     openFileNames->Append(inListName);
     openFileNames->Append(outListName);
 
+    ioFile = nullptr;
+
     // La cantidad de subdirecciones es 0 al inicio.
     subDirectories = 0;
     path[subDirectories] = new char[FILE_NAME_MAX_LEN];
@@ -288,6 +290,8 @@ Thread::Finish(int returnStatus)
                 dirTable->DirRemoveCondition(path[i],1);
             dirTable->DirLock(path[i],1);
         }
+
+        RetireIoStats(GetName(), pid, io);
     #endif
     
     //JOIN IMPLEMENTATION
@@ -590,14 +594,14 @@ bool
 Thread::ChangeDir(char* newDir)
 {
     
-    char* dirNames[NUM_SECTORS];
+    char* dirNames[MAX_DIRS + 1];
     dirNames[0] = strtok(newDir, "/");
 
     unsigned subdirs = 0;
     
     // Voy metiendo los nombres.
     while(dirNames[subdirs] != NULL){
-        ASSERT(subdirs < NUM_SECTORS);
+        ASSERT(subdirs < MAX_DIRS);
         dirNames[subdirs + 1] = strtok(NULL, "/");
         subdirs++;
     }
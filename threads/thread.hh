@@ -48,6 +48,8 @@
 #include "userprog/address_space.hh"
 
 #ifdef FILESYS
+#include "filesys/io_stats.hh"
+
 struct procFileInfo {
     OpenFile* file;
     char* name;
@@ -258,6 +260,13 @@ public:
 
     // Cantidad de subdirecciones bajo las que está el thread.
     unsigned subDirectories;
+
+    // Contadores de entrada/salida del thread (ver `filesys/io_stats.hh`).
+    IoStats io;
+
+    // Contadores del archivo que el thread está leyendo o escribiendo, a los
+    // que `SynchDisk` también carga los pedidos.  Null si ninguno.
+    IoStats *ioFile;
     #else
     Table <OpenFile*> *fileTableIds;
     #endif
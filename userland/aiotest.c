@@ -0,0 +1,76 @@
+/// Prueba de `AioRead`, `AioWrite`, `AioWait` y `AioPoll`.
+///
+/// Escribe un archivo con `AioWrite`, lo vuelve a leer con `AioRead`
+/// esperando con `AioPoll`, y compara.  Termina con la cantidad de pruebas
+/// que fallaron.
+///
+/// Necesita el sistema de archivos real.
+
+
+#include "syscall.h"
+#include "./lib.c"
+
+#define SIZE 300
+
+int
+Check(int ok, const char *what)
+{
+    puts(ok ? "ok   " : "FAIL ");
+    puts(what);
+    puts("\n");
+    return ok ? 0 : 1;
+}
+
+int
+main(void)
+{
+    char data[SIZE];
+    char back[SIZE];
+    int failed = 0;
+    int i;
+
+    for (i = 0; i < SIZE; i++) {
+        data[i] = 'a' + i % 26;
+    }
+
+    Create("AioTest");
+    OpenFileId fd = Open("AioTest");
+    failed += Check(fd > 1, "Open");
+
+    int ticket = AioWrite(data, SIZE, fd);
+    failed += Check(ticket != -1, "AioWrite");
+    // El buffer ya se copió: cambiarlo no afecta lo que se escribe.
+    data[0] = '!';
+    failed += Check(AioWait(ticket) == SIZE, "AioWait of the write");
+    failed += Check(AioWait(ticket) == -1, "second AioWait fails");
+    failed += Check(AioPoll(ticket) == -1, "AioPoll of a used ticket fails");
+    failed += Check(AioRead(back, SIZE, 0) == -1, "AioRead of the console fails");
+    Close(fd);
+
+    fd = Open("AioTest");
+    for (i = 0; i < SIZE; i++) {
+        back[i] = 0;
+    }
+    ticket = AioRead(back, 2 * SIZE, fd);
+    failed += Check(ticket != -1, "AioRead");
+
+    int status;
+    while ((status = AioPoll(ticket)) == 0) {
+        Yield();
+    }
+    failed += Check(status == 1, "AioPoll reports the read finished");
+    failed += Check(AioWait(ticket) == SIZE, "AioWait stops at end of file");
+
+    int same = back[0] == 'a';
+    for (i = 1; i < SIZE; i++) {
+        if (back[i] != 'a' + i % 26) {
+            same = 0;
+        }
+    }
+    failed += Check(same, "read contents match the write");
+    Close(fd);
+    Remove("AioTest");
+
+    puts(failed ? "aiotest: FAILED\n" : "aiotest: passed\n");
+    return failed;
+}
@@ -4,8 +4,7 @@
 int 
 main(int argc, char* argv[]) 
 {
-    int readOk;
-    char c[1];
+    int copied;
 
     if (argc == 3) {
 
@@ -33,9 +32,8 @@ main(int argc, char* argv[])
             Exit(-1);
         }
 
-        while((readOk = Read(c, 1, original))){
-            Write(c,1,copia);
-        }
+        // La copia la hace el kernel, de a bloques.
+        while((copied = SendFile(copia, original, -1, 1024)) > 0);
 
         if(Close(original) == -1){
             puts("Error: Close\n");
@@ -0,0 +1,69 @@
+/// Prueba de `GetIoStats`.
+///
+/// Escribe y lee un archivo y comprueba que los contadores del archivo y
+/// los del proceso reflejen lo transferido.  Termina con la cantidad de
+/// pruebas que fallaron.
+///
+/// Necesita el sistema de archivos real.
+
+
+#include "syscall.h"
+#include "./lib.c"
+
+#define SIZE 300
+
+int
+Check(int ok, const char *what)
+{
+    puts(ok ? "ok   " : "FAIL ");
+    puts(what);
+    puts("\n");
+    return ok ? 0 : 1;
+}
+
+int
+main(void)
+{
+    char data[SIZE];
+    IoInfo before, process, file;
+    int failed = 0;
+    int i;
+
+    for (i = 0; i < SIZE; i++) {
+        data[i] = 'a' + i % 26;
+    }
+
+    failed += Check(GetIoStats(-1, &before) == 0, "GetIoStats of the process");
+    failed += Check(GetIoStats(9, &file) == -1, "GetIoStats of a bad id fails");
+
+    // Los contadores del archivo duran mientras esté abierto, así que se
+    // lo deja abierto y se lee por otro descriptor.
+    Create("IoTest");
+    OpenFileId fd = Open("IoTest");
+    failed += Check(fd > 1, "Open");
+    failed += Check(GetIoStats(fd, 0) == -1, "GetIoStats without info fails");
+    failed += Check(GetIoStats(fd, &file) == 0 && file.writtenBytes == 0
+                      && file.readBytes == 0, "a new file starts at zero");
+
+    failed += Check(Write(data, SIZE, fd) == SIZE, "Write");
+    GetIoStats(fd, &file);
+    failed += Check(file.writtenBytes == SIZE, "the file counts the write");
+    failed += Check(file.diskWrites > 0, "the write went to disk");
+
+    OpenFileId other = Open("IoTest");
+    failed += Check(Read(data, SIZE, other) == SIZE, "Read");
+    Close(other);
+    GetIoStats(fd, &file);
+    failed += Check(file.readBytes == SIZE, "the file counts the read");
+
+    GetIoStats(-1, &process);
+    failed += Check(process.writtenBytes - before.writtenBytes >= SIZE,
+                    "the process counts the write");
+    failed += Check(process.readBytes - before.readBytes >= SIZE,
+                    "the process counts the read");
+    Close(fd);
+    Remove("IoTest");
+
+    puts(failed ? "iostatstest: FAILED\n" : "iostatstest: passed\n");
+    return failed;
+}
@@ -0,0 +1,81 @@
+/// Prueba de `Mmap` y `Munmap`.
+///
+/// Escribe un archivo, lo mapea, compara lo mapeado con lo escrito,
+/// modifica la región y después de desmapear vuelve a leer el archivo
+/// para ver que los cambios llegaron al disco.  Termina con la cantidad
+/// de pruebas que fallaron.
+///
+/// Necesita memoria virtual con carga por demanda.
+
+
+#include "syscall.h"
+#include "./lib.c"
+
+#define SIZE 200
+
+int
+Check(int ok, const char *what)
+{
+    puts(ok ? "ok   " : "FAIL ");
+    puts(what);
+    puts("\n");
+    return ok ? 0 : 1;
+}
+
+int
+main(void)
+{
+    char data[SIZE];
+    char back[SIZE];
+    int failed = 0;
+    int i;
+
+    for (i = 0; i < SIZE; i++) {
+        data[i] = 'a' + i % 26;
+    }
+
+    Create("MmTest");
+    OpenFileId fd = Open("MmTest");
+    failed += Check(fd > 1, "Open");
+    failed += Check(Write(data, SIZE, fd) == SIZE, "Write");
+
+    failed += Check(Mmap(fd, 4096) == (char *) -1,
+                    "Mmap past the end fails");
+    failed += Check(Mmap(fd, 0) == (char *) -1, "Mmap of 0 bytes fails");
+
+    char *addr = Mmap(fd, SIZE);
+    failed += Check(addr != (char *) -1, "Mmap");
+    if (addr == (char *) -1) {
+        return failed;
+    }
+
+    int same = 1;
+    for (i = 0; i < SIZE; i++) {
+        if (addr[i] != data[i]) {
+            same = 0;
+        }
+    }
+    failed += Check(same, "mapped contents match the file");
+
+    for (i = 0; i < SIZE; i++) {
+        addr[i] = 'A' + i % 26;
+    }
+    failed += Check(Munmap(addr) == 0, "Munmap");
+    failed += Check(Munmap(addr) == -1, "second Munmap fails");
+    Close(fd);
+
+    fd = Open("MmTest");
+    failed += Check(Read(back, SIZE, fd) == SIZE, "Read back");
+    same = 1;
+    for (i = 0; i < SIZE; i++) {
+        if (back[i] != 'A' + i % 26) {
+            same = 0;
+        }
+    }
+    failed += Check(same, "changes were written back");
+    Close(fd);
+    Remove("MmTest");
+
+    puts(failed ? "mmaptest: FAILED\n" : "mmaptest: passed\n");
+    return failed;
+}
@@ -172,6 +172,86 @@ CDir:
         syscall
         j       $31
         .end    CDir
+
+        .globl  SendFile
+        .ent    SendFile
+SendFile:
+        addiu   $2, $0, SC_SENDFILE
+        syscall
+        j       $31
+        .end    SendFile
+
+        .globl  AioRead
+        .ent    AioRead
+AioRead:
+        addiu   $2, $0, SC_AIOREAD
+        syscall
+        j       $31
+        .end    AioRead
+
+        .globl  AioWrite
+        .ent    AioWrite
+AioWrite:
+        addiu   $2, $0, SC_AIOWRITE
+        syscall
+        j       $31
+        .end    AioWrite
+
+        .globl  AioWait
+        .ent    AioWait
+AioWait:
+        addiu   $2, $0, SC_AIOWAIT
+        syscall
+        j       $31
+        .end    AioWait
+
+        .globl  AioPoll
+        .ent    AioPoll
+AioPoll:
+        addiu   $2, $0, SC_AIOPOLL
+        syscall
+        j       $31
+        .end    AioPoll
+
+        .globl  Mmap
+        .ent    Mmap
+Mmap:
+        addiu   $2, $0, SC_MMAP
+        syscall
+        j       $31
+        .end    Mmap
+
+        .globl  Munmap
+        .ent    Munmap
+Munmap:
+        addiu   $2, $0, SC_MUNMAP
+        syscall
+        j       $31
+        .end    Munmap
+
+        .globl  Truncate
+        .ent    Truncate
+Truncate:
+        addiu   $2, $0, SC_TRUNCATE
+        syscall
+        j       $31
+        .end    Truncate
+
+        .globl  Allocate
+        .ent    Allocate
+Allocate:
+        addiu   $2, $0, SC_ALLOCATE
+        syscall
+        j       $31
+        .end    Allocate
+
+        .globl  GetIoStats
+        .ent    GetIoStats
+GetIoStats:
+        addiu   $2, $0, SC_IOSTATS
+        syscall
+        j       $31
+        .end    GetIoStats
 /// Dummy function to keep gcc happy.
         .globl  __main
         .ent    __main
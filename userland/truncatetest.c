@@ -0,0 +1,90 @@
+/// Prueba de `Truncate` y `Allocate`.
+///
+/// Achica un archivo y comprueba el tamaño y el contenido que quedan;
+/// después le reserva lugar y comprueba que el tamaño no cambia hasta que
+/// se escribe.  Termina con la cantidad de pruebas que fallaron.
+///
+/// `Read` no se detiene en el fin de archivo, así que el tamaño se mide
+/// con `AioRead`, que sí lo hace.  Necesita el sistema de archivos real.
+
+
+#include "syscall.h"
+#include "./lib.c"
+
+#define SIZE 300
+
+int
+Check(int ok, const char *what)
+{
+    puts(ok ? "ok   " : "FAIL ");
+    puts(what);
+    puts("\n");
+    return ok ? 0 : 1;
+}
+
+/// Devuelve el tamaño del archivo `name`, leyéndolo en `buffer`.
+int
+Length(const char *name, char *buffer, int size)
+{
+    OpenFileId fd = Open(name);
+    int length = AioWait(AioRead(buffer, size, fd));
+    Close(fd);
+    return length;
+}
+
+int
+main(void)
+{
+    char data[SIZE];
+    char back[2 * SIZE];
+    int failed = 0;
+    int i;
+
+    for (i = 0; i < SIZE; i++) {
+        data[i] = 'a' + i % 26;
+    }
+
+    Create("TrTest");
+    OpenFileId fd = Open("TrTest");
+    failed += Check(fd > 1, "Open");
+    failed += Check(Write(data, SIZE, fd) == SIZE, "Write");
+
+    failed += Check(Truncate(fd, SIZE + 1) == -1, "Truncate cannot grow");
+    failed += Check(Truncate(fd, -1) == -1, "Truncate to -1 fails");
+    failed += Check(Truncate(fd, 100) == 0, "Truncate to 100 bytes");
+    Close(fd);
+
+    failed += Check(Length("TrTest", back, 2 * SIZE) == 100,
+                    "100 bytes are left");
+    int same = 1;
+    for (i = 0; i < 100; i++) {
+        if (back[i] != data[i]) {
+            same = 0;
+        }
+    }
+    failed += Check(same, "the first 100 bytes are kept");
+
+    fd = Open("TrTest");
+    failed += Check(Allocate(fd, 2 * SIZE) == 0, "Allocate");
+    failed += Check(Allocate(fd, 0x7FFFFFFF) == -1, "huge Allocate fails");
+    failed += Check(Length("TrTest", back, 2 * SIZE) == 100,
+                    "Allocate does not change the size");
+
+    // Se escribe a continuación de lo que quedó.
+    Read(back, 100, fd);
+    failed += Check(Write(data, SIZE, fd) == SIZE, "Write after Allocate");
+    Close(fd);
+    failed += Check(Length("TrTest", back, 2 * SIZE) == 100 + SIZE,
+                    "the write grows the file");
+    same = 1;
+    for (i = 0; i < SIZE; i++) {
+        if (back[100 + i] != data[i]) {
+            same = 0;
+        }
+    }
+    failed += Check(same, "the written bytes are there");
+    Remove("TrTest");
+
+    puts(failed ? "truncatetest: FAILED\n" : "truncatetest: passed\n");
+    return failed;
+}
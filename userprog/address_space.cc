@@ -31,6 +31,81 @@ void LoadPagePrintStats(uint32_t codeAddr, uint32_t codeSize, uint32_t endCodeAd
                    uint32_t badPageNumber, uint32_t badVAddr, uint32_t botBadPage, 
                    uint32_t topBadPage, uint32_t offsetPage);
 
+#ifdef USE_TLB
+/// Próximo ASID libre y generación actual.  Un ASID no se reusa dentro de
+/// una generación, así una entrada vieja de un espacio que ya no existe
+/// nunca acierta.  Cuando se acaban empieza otra generación y se vacía la
+/// TLB.
+static unsigned nextAsid = 0;
+static unsigned currentGeneration = 1;
+#endif
+
+#ifndef SWAP
+/// Marcos para las páginas de los procesos cuando no hay swap.  Con la
+/// caché de páginas salen del `core_map`, que comparten con los archivos,
+/// y si no hay libres se le saca uno a la caché.
+static int
+FindFrame(unsigned vpn)
+{
+    #ifdef PAGE_CACHE
+    return core_map->FindReclaiming(vpn, currentThread->GetPid());
+    #else
+    int frame = bit_map->Find();
+    if (frame != -1) {
+        machine->GetMMU()->ForgetDecodes(frame);
+    }
+    return frame;
+    #endif
+}
+
+/// Marcos que puede conseguir un proceso.  Con la caché de páginas, además
+/// de los libres están los de archivos, que `FindFrame` le saca a la caché.
+static unsigned
+CountFreeFrames()
+{
+    #ifdef PAGE_CACHE
+    unsigned count = 0;
+    for (unsigned i = 0; i < core_map->GetSize(); i++) {
+        if (!core_map->Test(i) || core_map->IsFilePage(i)) {
+            count++;
+        }
+    }
+    return count;
+    #else
+    return bit_map->CountClear();
+    #endif
+}
+
+static void
+ClearFrame(unsigned frame)
+{
+    #ifdef PAGE_CACHE
+    core_map->Clear(frame);
+    #else
+    bit_map->Clear(frame);
+    #endif
+}
+#endif
+
+#ifdef DEMAND_LOADING
+/// Marco libre para cargar por adelantado la página `vpn`.  A diferencia
+/// de los fallos, nunca se desaloja ni se le quita un marco a la caché: si
+/// no hay libres devuelve -1.
+static int
+FindFreeFrame(unsigned vpn)
+{
+    #if defined(SWAP) || defined(PAGE_CACHE)
+    return core_map->Find(vpn, currentThread->GetPid());
+    #else
+    int frame = bit_map->Find();
+    if (frame != -1) {
+        machine->GetMMU()->ForgetDecodes(frame);
+    }
+    return frame;
+    #endif
+}
+#endif
+
     /// First, set up the translation from program memory to physical memory.
 /// For now, this is really simple (1:1), since we are only uniprogramming,
 /// and we have a single unsegmented page table.
@@ -41,6 +116,12 @@ AddressSpace::AddressSpace(OpenFile *executable_file, int newThreadPid)
     // Guardo el pid del thread para usarlo en el destructor.
     pid = newThreadPid;
 
+    #ifdef USE_TLB
+    // El ASID se asigna la primera vez que corre.
+    asid = 0;
+    asidGeneration = 0;
+    #endif
+
     /// Creo el ejecutable
     #ifndef DEMAND_LOADING
     Executable *exe = new Executable(executable_file);
@@ -58,13 +139,26 @@ AddressSpace::AddressSpace(OpenFile *executable_file, int newThreadPid)
         // We need to increase the size to leave room for the stack.
     numPages = DivRoundUp(size, PAGE_SIZE);
     size = numPages * PAGE_SIZE; /// Recalcula el nuevo tamaño con las páginas de mas incluidas.
+
+    #ifdef DEMAND_LOADING
+    // Las regiones mapeadas se agregan después del stack.
+    mapBase  = numPages;
+    mappings = new Table<MappedRegion *>;
+
+    prefetchedAt   = new unsigned [mapBase]();
+    numFaults      = 0;
+    faultAround    = FAULT_AROUND_INITIAL;
+    lastFault      = 0;
+    prefetchIssued = 0;
+    prefetchUsed   = 0;
+    #endif
     
     // Al tener DL no se va a cargar todo el programa en memoria.
     // Se irá cargando de a partes y quizás se va liberando la memoria
     // Además quizás hay secciones del código que no se cargarán nunca y el programa entraria igual.
 
     #ifndef SWAP    
-    ASSERT(numPages <= bit_map->CountClear()); /// Calculamos la cantidad de espacio disponible según el bitmap      // Check we are not trying to run anything too big -- at least until we
+    ASSERT(numPages <= CountFreeFrames()); /// Calculamos la cantidad de espacio disponible según los marcos libres      // Check we are not trying to run anything too big -- at least until we
       // have virtual memory.
     #else
     //ASSERT(numPages <= core_map->CountClear());
@@ -104,7 +198,7 @@ AddressSpace::AddressSpace(OpenFile *executable_file, int newThreadPid)
         
         #ifndef SWAP
         /// Devolvemos el primer lugar de la memoria física libre.
-        pageTable[i].physicalPage = bit_map->Find();
+        pageTable[i].physicalPage = FindFrame(i);
         #else
         /// Devolvemos el primer lugar de la memoria física libre.
         pageTable[i].physicalPage = core_map->Find(i,currentThread->GetPid());
@@ -266,13 +360,27 @@ AddressSpace::~AddressSpace()
     #ifndef SWAP
     for (unsigned i = 0; i < numPages; i++)
         if (pageTable[i].valid){
-            bit_map->Clear(pageTable[i].physicalPage);
+            ClearFrame(pageTable[i].physicalPage);
         }
     #endif
     
     // Ver.    
     #ifdef DEMAND_LOADING
         delete exe;
+        delete [] prefetchedAt;
+
+    // Las regiones que queden no se escriben: el proceso ya cerró sus
+    // archivos.  Sus marcos se liberaron arriba.
+    for (unsigned i = 0; i < Table<MappedRegion *>::SIZE; i++) {
+        if (mappings->HasKey(i)) {
+            MappedRegion *region = mappings->Remove(i);
+            #ifdef FILESYS
+            delete [] region->filename;
+            #endif
+            delete region;
+        }
+    }
+    delete mappings;
     #endif
     #ifdef SWAP
     // Si tengo swap, elimino el archivo de swap.
@@ -327,10 +435,11 @@ AddressSpace::SaveState()
 //    printf("Guardo estado, soy %d\n", currentThread->GetPid());
     #ifdef USE_TLB
     // Defino una copia de la TLB así en un cambio de contexto no se cambian los valores.
+    // Las entradas de este espacio quedan en la TLB para cuando vuelva.
     TranslationEntry* tlb = machine->GetMMU()->tlb;
-    for (unsigned int i = 0; i < TLB_SIZE ; i++)
+    for (unsigned int i = 0; i < machine->GetMMU()->tlbSize ; i++)
     {
-        if(tlb[i].valid) 
+        if(OwnsTlbEntry(&tlb[i])) 
         {
             pageTable[tlb[i].virtualPage].dirty = tlb[i].dirty;
             pageTable[tlb[i].virtualPage].use = tlb[i].use;
@@ -347,15 +456,55 @@ void
 AddressSpace::RestoreState()
 {
     #ifdef USE_TLB
-    //Invalidar la TLB
-    for (unsigned int i = 0; i < TLB_SIZE; i++)
-        machine->GetMMU()->tlb[i].valid = false;
+    // No se invalida la TLB: alcanza con cambiar el ASID.
+    if (asidGeneration != currentGeneration)
+        AssignAsid();
+    machine->GetMMU()->currentAsid = asid;
     #else
     /// Comentar estas dos
     machine->GetMMU()->pageTable     = pageTable;
     machine->GetMMU()->pageTableSize = numPages;
     #endif
+    machine->GetMMU()->FlushMicroTlb();
+}
+
+#ifdef USE_TLB
+void
+AddressSpace::AssignAsid()
+{
+    MMU *mmu = machine->GetMMU();
+    if (nextAsid == NUM_ASIDS) {
+        DEBUG('a', "Se acabaron los ASID, vacío la TLB.\n");
+        // Los espacios que no corren ya guardaron sus bits en `SaveState`.
+        for (unsigned i = 0; i < mmu->tlbSize; i++)
+            mmu->tlb[i].valid = false;
+        currentGeneration++;
+        nextAsid = 0;
+    }
+    asid = nextAsid++;
+    asidGeneration = currentGeneration;
+    DEBUG('a', "El proceso %d usa el ASID %u.\n", pid, asid);
+}
+
+bool
+AddressSpace::OwnsTlbEntry(const TranslationEntry *e) const
+{
+    return e->valid && asidGeneration == currentGeneration && e->asid == asid;
+}
+
+void
+AddressSpace::InvalidateTlbPage(unsigned vpn)
+{
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < machine->GetMMU()->tlbSize; i++) {
+        if (OwnsTlbEntry(&tlb[i]) && tlb[i].virtualPage == vpn) {
+            pageTable[vpn].dirty = tlb[i].dirty;
+            pageTable[vpn].use = tlb[i].use;
+            tlb[i].valid = false;
+        }
+    }
 }
+#endif
 
 void
 AddressSpace::ActPageTable(unsigned virtualPage, unsigned physicalPage, bool valid, 
@@ -533,6 +682,243 @@ AddressSpace::LoadPage(unsigned badPageNumber)
     puts("No cargo nada");
     ASSERT(false);
 }
+
+int
+AddressSpace::Map(int fd, OpenFile *file, const char *filename,
+                  unsigned length)
+{
+    ASSERT(file != nullptr);
+
+    if (length == 0) {
+        return -1;
+    }
+
+    MappedRegion *region = new MappedRegion;
+    region->numPages = DivRoundUp(length, PAGE_SIZE);
+    region->length   = length;
+    region->fd       = fd;
+    region->file     = file;
+    #ifdef FILESYS
+    ASSERT(filename != nullptr);
+    region->filename = new char [strlen(filename) + 1];
+    strcpy(region->filename, filename);
+    #endif
+
+    if (mappings->Add(region) == -1) {
+        #ifdef FILESYS
+        delete [] region->filename;
+        #endif
+        delete region;
+        return -1;
+    }
+
+    // La región va al final de la tabla de paginación, que se agranda.
+    region->firstPage = numPages;
+    unsigned newNumPages = numPages + region->numPages;
+
+    TranslationEntry *newTable = new TranslationEntry[newNumPages];
+    for (unsigned i = 0; i < numPages; i++) {
+        newTable[i] = pageTable[i];
+    }
+    for (unsigned i = numPages; i < newNumPages; i++) {
+        newTable[i].virtualPage  = i;
+        newTable[i].physicalPage = -1;
+        newTable[i].valid        = false;
+        newTable[i].use          = false;
+        newTable[i].dirty        = false;
+        newTable[i].readOnly     = false;
+    }
+    delete [] pageTable;
+    pageTable = newTable;
+
+    #ifdef SWAP
+    bool *newSwapMap = new bool[newNumPages]();
+    for (unsigned i = 0; i < numPages; i++) {
+        newSwapMap[i] = swapMap[i];
+    }
+    delete [] swapMap;
+    swapMap = newSwapMap;
+    #endif
+
+    numPages = newNumPages;
+
+    DEBUG('a', "Mapeo %u bytes del archivo %d en las páginas %u a %u.\n",
+          length, fd, region->firstPage, numPages - 1);
+    return region->firstPage * PAGE_SIZE;
+}
+
+MappedRegion *
+AddressSpace::FindMapping(unsigned vpn)
+{
+    for (unsigned i = 0; i < Table<MappedRegion *>::SIZE; i++) {
+        MappedRegion *region = mappings->Get(i);
+        if (region != nullptr && region->firstPage <= vpn
+              && vpn < region->firstPage + region->numPages) {
+            return region;
+        }
+    }
+    return nullptr;
+}
+
+bool
+AddressSpace::IsMapped(unsigned vpn)
+{
+    return vpn >= mapBase && FindMapping(vpn) != nullptr;
+}
+
+void
+AddressSpace::LoadMappedPage(unsigned vpn)
+{
+    MappedRegion *region = FindMapping(vpn);
+    ASSERT(region != nullptr);
+
+    // Busco un lugar en la memoria libre.
+    #ifndef SWAP
+    pageTable[vpn].physicalPage = FindFrame(vpn);
+    #else
+    pageTable[vpn].physicalPage = core_map->Find(vpn, currentThread->GetPid());
+    if ((int) pageTable[vpn].physicalPage == -1) {
+        Swap(vpn);
+    }
+    #endif
+    ASSERT((int) pageTable[vpn].physicalPage != -1);
+
+    char *frame = &machine->mainMemory[PHYSICAL_PAGE_ADDR(vpn)];
+    memset(frame, 0, PAGE_SIZE);
+
+    // Lo que queda después del fin de archivo o de la región queda en 0.
+    unsigned offset = (vpn - region->firstPage) * PAGE_SIZE;
+    unsigned end = region->file->Length();
+    end = MIN(end, region->length);
+    if (offset < end) {
+        unsigned size = MIN(end - offset, PAGE_SIZE);
+        #ifdef FILESYS
+        fileTable->LockedReadAt(region->filename, frame, size, offset);
+        #else
+        region->file->ReadAt(frame, size, offset);
+        #endif
+    }
+
+    DEBUG('a', "Página mapeada %u cargada desde el byte %u.\n", vpn, offset);
+    pageTable[vpn].valid    = true;
+    pageTable[vpn].use      = true;
+    pageTable[vpn].dirty    = false;
+    pageTable[vpn].readOnly = false;
+}
+
+void
+AddressSpace::WriteMappedPage(unsigned vpn)
+{
+    MappedRegion *region = FindMapping(vpn);
+    ASSERT(region != nullptr);
+    ASSERT(pageTable[vpn].valid);
+
+    char *frame = &machine->mainMemory[PHYSICAL_PAGE_ADDR(vpn)];
+    unsigned offset = (vpn - region->firstPage) * PAGE_SIZE;
+
+    // Igual que al cargar: lo que está después del fin de archivo no se
+    // escribe, así el archivo no crece.
+    unsigned end = region->file->Length();
+    end = MIN(end, region->length);
+    if (offset < end) {
+        unsigned size = MIN(end - offset, PAGE_SIZE);
+        DEBUG('a', "Página mapeada %u escrita en el byte %u.\n",
+              vpn, offset);
+        #ifdef FILESYS
+        fileTable->LockedWriteAt(region->filename, frame, size, offset);
+        #else
+        region->file->WriteAt(frame, size, offset);
+        #endif
+    }
+    pageTable[vpn].dirty = false;
+}
+
+void
+AddressSpace::ReleaseRegion(int id)
+{
+    MappedRegion *region = mappings->Get(id);
+    ASSERT(region != nullptr);
+    unsigned end = region->firstPage + region->numPages;
+
+    // La TLB puede tener bits más nuevos.
+    #ifdef USE_TLB
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < machine->GetMMU()->tlbSize; i++) {
+        unsigned vpn = tlb[i].virtualPage;
+        if (OwnsTlbEntry(&tlb[i]) && region->firstPage <= vpn && vpn < end) {
+            pageTable[vpn].dirty = tlb[i].dirty;
+            tlb[i].valid = false;
+        }
+    }
+    #endif
+
+    for (unsigned vpn = region->firstPage; vpn < end; vpn++) {
+        if (!pageTable[vpn].valid) {
+            continue;
+        }
+        if (pageTable[vpn].dirty) {
+            WriteMappedPage(vpn);
+        }
+        #ifndef SWAP
+        ClearFrame(pageTable[vpn].physicalPage);
+        #else
+        core_map->Clear(pageTable[vpn].physicalPage);
+        #endif
+        pageTable[vpn].valid = false;
+    }
+
+    mappings->Remove(id);
+    #ifdef FILESYS
+    delete [] region->filename;
+    #endif
+    delete region;
+
+    // Si era la región de más arriba, la tabla vuelve a achicarse.
+    numPages = mapBase;
+    for (unsigned i = 0; i < Table<MappedRegion *>::SIZE; i++) {
+        MappedRegion *other = mappings->Get(i);
+        if (other != nullptr) {
+            numPages = MAX(numPages, other->firstPage + other->numPages);
+        }
+    }
+}
+
+bool
+AddressSpace::Unmap(unsigned addr)
+{
+    if (addr % PAGE_SIZE != 0) {
+        return false;
+    }
+    for (unsigned i = 0; i < Table<MappedRegion *>::SIZE; i++) {
+        MappedRegion *region = mappings->Get(i);
+        if (region != nullptr && region->firstPage == addr / PAGE_SIZE) {
+            ReleaseRegion(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+AddressSpace::UnmapFile(int fd)
+{
+    for (unsigned i = 0; i < Table<MappedRegion *>::SIZE; i++) {
+        MappedRegion *region = mappings->Get(i);
+        if (region != nullptr && region->fd == fd) {
+            ReleaseRegion(i);
+        }
+    }
+}
+
+void
+AddressSpace::UnmapAll()
+{
+    for (unsigned i = 0; i < Table<MappedRegion *>::SIZE; i++) {
+        if (mappings->HasKey(i)) {
+            ReleaseRegion(i);
+        }
+    }
+}
 #endif
 
 #ifdef SWAP
@@ -581,7 +967,13 @@ AddressSpace::Swap(unsigned vpn_to_store)
     int victim = core_map->PickVictim();
     
     // Si la página no está usada simplemente la marco y la uso.
-    if (!core_map->Test(victim)){
+    // Tampoco hay nada que guardar si es de la caché de páginas: las
+    // páginas de archivo nunca están sucias.
+    bool unused = !core_map->Test(victim);
+    #ifdef PAGE_CACHE
+    unused = unused || core_map->IsFilePage(victim);
+    #endif
+    if (unused){
         core_map->Mark(victim, vpn_to_store, currentThread->GetPid());
         pageTable[vpn_to_store].physicalPage = victim;
         return;
@@ -600,31 +992,24 @@ AddressSpace::Swap(unsigned vpn_to_store)
     ASSERT(t_victim != nullptr);
     
     ASSERT(vpn <= t_victim->space->GetNumPages());
-    // En el único caso que tiene sentido checkear que la TLB
-    // no tenga esta página es en el cual el hilo víctima es 
-    // el hilo actual.
-    if (currentThread == t_victim)
-    {
-        TranslationEntry* tlb = machine->GetMMU()->tlb;
-        for (unsigned int i = 0; i < TLB_SIZE ; i++)
-        {
-            // Si efectivamente la victima está en la tlb,
-            // actualizamos la pageTable.
-            if (tlb[i].virtualPage == vpn)
-            {
-               // Invalido la victima en la tlb.
-               tlb[i].valid = false;
-                
-               pageTable[vpn].dirty = tlb[i].dirty;
-               pageTable[vpn].use = tlb[i].use;
-
-            }
-        }
-    }
+    // Con ASID la TLB puede tener páginas de cualquier proceso, no sólo
+    // del actual.
+    #ifdef USE_TLB
+    t_victim->space->InvalidateTlbPage(vpn);
+    #endif
 
     // Una vez resuelto posibles conflictos con la tlb,
     // debo checkear si la página está sucia.
     
+    // Una página mapeada sucia vuelve a su archivo, no al swap.
+    #ifdef DEMAND_LOADING
+    if (t_victim->space->IsMapped(vpn))
+    {
+        if (t_victim->space->GetPageDirty(vpn))
+            t_victim->space->WriteMappedPage(vpn);
+    }
+    else
+    #endif
     // La página está sucia. Debo escribirla en swap.
     if (t_victim->space->GetPageDirty(vpn))
     {
@@ -658,12 +1043,157 @@ AddressSpace::GetFromSwap(unsigned vpn)
 }
 #endif
 
-void 
+#ifdef DEMAND_LOADING
+void
+AddressSpace::FaultAround(unsigned vpn)
+{
+    // Primero se ajusta la ventana con lo que pasó desde el fallo
+    // anterior: crece si se usaron al menos la mitad de las páginas
+    // adelantadas y se achica si no.  Con ventana de una página no se
+    // adelanta nada, así que vuelve a crecer si los fallos son seguidos.
+    if (prefetchIssued > 0) {
+        if (2 * prefetchUsed >= prefetchIssued) {
+            if (faultAround < FAULT_AROUND_MAX) {
+                faultAround *= 2;
+            }
+        } else if (faultAround > 1) {
+            faultAround /= 2;
+        }
+    } else if (faultAround == 1 && vpn == lastFault + 1) {
+        faultAround = 2;
+    }
+    prefetchIssued = 0;
+    prefetchUsed   = 0;
+    lastFault      = vpn;
+    numFaults++;
+
+    // Sólo se adelantan páginas del ejecutable: las del stack y los datos
+    // sin inicializar son ceros y no ahorran ninguna lectura.
+    uint32_t endCode = exe->GetCodeAddr() + exe->GetCodeSize();
+    uint32_t endData = exe->GetInitDataAddr() + exe->GetInitDataSize();
+    uint32_t end = endCode;
+    if (exe->GetInitDataSize() > 0 && endData > end) {
+        end = endData;
+    }
+
+    unsigned first = vpn - vpn % faultAround;
+    bool wanted[FAULT_AROUND_MAX];
+    for (unsigned n = 0; n < faultAround; n++) {
+        unsigned p = first + n;
+        wanted[n] = p != vpn && p < mapBase && p * PAGE_SIZE < end
+                      && !pageTable[p].valid;
+        #ifdef SWAP
+        // Ésta se trae del swap cuando haga falta.
+        wanted[n] = wanted[n] && !swapMap[p];
+        #endif
+    }
+
+    // Las páginas seguidas que faltan se leen juntas: primero se les
+    // busca marco y después se cargan todas de una vez.
+    unsigned n = 0;
+    bool outOfFrames = false;
+    while (n < faultAround && !outOfFrames) {
+        if (!wanted[n]) {
+            n++;
+            continue;
+        }
+        unsigned runStart = n;
+        for (; n < faultAround && wanted[n]; n++) {
+            int frame = FindFreeFrame(first + n);
+            if (frame == -1) {
+                outOfFrames = true;
+                break;
+            }
+            pageTable[first + n].physicalPage = frame;
+        }
+        if (n == runStart) {
+            break;
+        }
+        LoadPageRun(first + runStart, n - runStart);
+
+        for (unsigned p = first + runStart; p < first + n; p++) {
+            // Sin el bit de uso, el reloj la elige antes que a las que sí
+            // se usaron.
+            pageTable[p].use = false;
+            prefetchedAt[p] = numFaults;
+            prefetchIssued++;
+            stats->numPagesPrefetched++;
+        }
+        DEBUG('a', "Adelanto las páginas %u a %u (ventana %u).\n",
+              first + runStart, first + n - 1, faultAround);
+    }
+}
+
+void
+AddressSpace::LoadPageRun(unsigned firstPage, unsigned count)
+{
+    uint32_t from = firstPage * PAGE_SIZE;
+    uint32_t to   = from + count * PAGE_SIZE;
+    char *buffer  = new char [count * PAGE_SIZE];
+    memset(buffer, 0, count * PAGE_SIZE);
+
+    // La parte de cada segmento que cae en la tira se lee de una vez en un
+    // buffer intermedio; lo demás queda en cero.
+    uint32_t codeAddr = exe->GetCodeAddr();
+    uint32_t codeEnd  = codeAddr + exe->GetCodeSize();
+    if (codeAddr < to && codeEnd > from) {
+        uint32_t lo = codeAddr > from ? codeAddr : from;
+        uint32_t hi = codeEnd < to ? codeEnd : to;
+        exe->ReadCodeBlock(&buffer[lo - from], hi - lo, lo - codeAddr);
+    }
+    uint32_t dataAddr = exe->GetInitDataAddr();
+    uint32_t dataEnd  = dataAddr + exe->GetInitDataSize();
+    if (dataAddr < to && dataEnd > from) {
+        uint32_t lo = dataAddr > from ? dataAddr : from;
+        uint32_t hi = dataEnd < to ? dataEnd : to;
+        exe->ReadDataBlock(&buffer[lo - from], hi - lo, lo - dataAddr);
+    }
+
+    char *mainMemory = machine->mainMemory;
+    for (unsigned i = 0; i < count; i++) {
+        memcpy(&mainMemory[PHYSICAL_PAGE_ADDR(firstPage + i)],
+               &buffer[i * PAGE_SIZE], PAGE_SIZE);
+        pageTable[firstPage + i].valid = true;
+    }
+    delete [] buffer;
+}
+#endif
+
+#ifdef USE_TLB
+bool
 AddressSpace::UpdateTLB(unsigned indexTlb, unsigned badVAddr) 
 {
     unsigned badPageNumber = badVAddr / PAGE_SIZE;
-    ASSERT(badPageNumber <= numPages);
+    if (badPageNumber >= numPages) {
+        return false;
+    }
     
+    #ifdef DEMAND_LOADING
+    // Entre las regiones mapeadas quedan huecos de las que se desmapearon.
+    if (badPageNumber >= mapBase && FindMapping(badPageNumber) == nullptr) {
+        return false;
+    }
+
+    // Las páginas de un archivo mapeado se traen del archivo.
+    if (!pageTable[badPageNumber].valid && badPageNumber >= mapBase) {
+        LoadMappedPage(badPageNumber);
+    }
+
+    // Una página cargada por adelantado cuenta como usada la primera vez
+    // que se la pide.  Si la desalojaron antes, el adelanto no sirvió.  Para
+    // ajustar la ventana sólo cuentan las del último fallo, que son las que
+    // se comparan con `prefetchIssued`.
+    if (badPageNumber < mapBase && prefetchedAt[badPageNumber] != 0) {
+        if (pageTable[badPageNumber].valid) {
+            if (prefetchedAt[badPageNumber] == numFaults) {
+                prefetchUsed++;
+            }
+            stats->numPrefetchHits++;
+        }
+        prefetchedAt[badPageNumber] = 0;
+    }
+    #endif
+
     // La página no está en memoria, por SWAP o DL.
     #if (defined(SWAP) || defined(DEMAND_LOADING))
     if (!(pageTable[badPageNumber].valid)){
@@ -671,9 +1201,10 @@ AddressSpace::UpdateTLB(unsigned indexTlb, unsigned badVAddr)
         #ifndef SWAP
         #ifdef DEMAND_LOADING
         // Busco un lugar en la memoria libre.
-        pageTable[badPageNumber].physicalPage = bit_map->Find();
+        pageTable[badPageNumber].physicalPage = FindFrame(badPageNumber);
         ASSERT((int)pageTable[badPageNumber].physicalPage != -1);
         LoadPage(badPageNumber);
+        FaultAround(badPageNumber);
         #endif
         #else
         // Busco un lugar en la memoria libre.
@@ -693,6 +1224,7 @@ AddressSpace::UpdateTLB(unsigned indexTlb, unsigned badVAddr)
         else { 
             #ifdef DEMAND_LOADING
             LoadPage(badPageNumber);
+            FaultAround(badPageNumber);
             #else // La única forma que la página no esté en memoria sin haber DL es que haya sido swappeada.
             ASSERT(false);
             #endif
@@ -703,8 +1235,9 @@ AddressSpace::UpdateTLB(unsigned indexTlb, unsigned badVAddr)
 
     MMU* MMU = machine->GetMMU(); 
     
-    // Si es válida tengo que actualizar la pageTable.
-    if (MMU->tlb[indexTlb].valid) 
+    // Si es válida y de este espacio tengo que actualizar la pageTable.  Las
+    // de otros espacios ya se guardaron en su `SaveState`.
+    if (OwnsTlbEntry(&MMU->tlb[indexTlb])) 
     {
         unsigned pageNumber = MMU->tlb[indexTlb].virtualPage;
         ASSERT(pageNumber <= numPages);
@@ -724,7 +1257,11 @@ AddressSpace::UpdateTLB(unsigned indexTlb, unsigned badVAddr)
     MMU->tlb[indexTlb].use = pageTable[badPageNumber].use;
     MMU->tlb[indexTlb].dirty = pageTable[badPageNumber].dirty;
     MMU->tlb[indexTlb].readOnly = pageTable[badPageNumber].readOnly;
+    MMU->tlb[indexTlb].asid = asid;
+    MMU->FlushMicroTlb();
+    return true;
 }
+#endif
 
 
 void LoadPagePrintStats(uint32_t codeAddr, uint32_t codeSize, uint32_t endCodeAddr, 
@@ -23,6 +23,28 @@
 
 const unsigned USER_STACK_SIZE = 1024;  ///< Increase this as necessary!
 
+#ifdef DEMAND_LOADING
+/// Páginas que se cargan juntas en un fallo al empezar y como máximo.
+/// Son potencias de dos.
+const unsigned FAULT_AROUND_INITIAL = 4;
+const unsigned FAULT_AROUND_MAX = 8;
+
+/// Región de un archivo mapeado en memoria con `Mmap`.
+///
+/// Sus páginas se agregan a la tabla de paginación después del stack y se
+/// traen del archivo cuando fallan, igual que las del ejecutable con DL.
+struct MappedRegion {
+    unsigned firstPage;  ///< Primera página virtual de la región.
+    unsigned numPages;   ///< Cantidad de páginas de la región.
+    unsigned length;     ///< Bytes del archivo que se mapearon.
+    int fd;              ///< Descriptor con el que se mapeó.
+    OpenFile *file;      ///< Archivo mapeado.
+    #ifdef FILESYS
+    char *filename;      ///< Nombre en la `fileTable`.
+    #endif
+};
+#endif
+
 
 class AddressSpace {
 public:
@@ -50,12 +72,38 @@ public:
     void SaveState();
     void RestoreState();
 
-    /// Update Tlb
-    void UpdateTLB(unsigned indexTlb, unsigned badVAddr);
+    #ifdef USE_TLB
+    /// Carga en la entrada `indexTlb` la traducción de `badVAddr`, trayendo
+    /// la página si hace falta.  Devuelve falso si la dirección no es del
+    /// espacio.
+    bool UpdateTLB(unsigned indexTlb, unsigned badVAddr);
+    #endif
 
     #ifdef DEMAND_LOADING
     // Using for DL
     void LoadPage(unsigned badVAddr);
+
+    /// Mapea los primeros `length` bytes del archivo abierto `fd` y
+    /// devuelve la dirección virtual de la región, o -1 si no se pudo.
+    /// `filename` sólo se usa con el sistema de archivos real.
+    int Map(int fd, OpenFile *file, const char *filename, unsigned length);
+
+    /// Desmapea la región que empieza en `addr`, escribiendo en el archivo
+    /// las páginas modificadas.  Devuelve falso si no hay tal región.
+    bool Unmap(unsigned addr);
+
+    /// Desmapea todas las regiones del descriptor `fd`.  Se llama antes de
+    /// cerrarlo.
+    void UnmapFile(int fd);
+
+    /// Desmapea todas las regiones.  Se llama al terminar el proceso.
+    void UnmapAll();
+
+    /// Si la página `vpn` pertenece a un archivo mapeado.
+    bool IsMapped(unsigned vpn);
+
+    /// Escribe la página mapeada `vpn` en su archivo.
+    void WriteMappedPage(unsigned vpn);
     #endif
     #ifdef SWAP
     // Using for SWAP
@@ -96,10 +144,58 @@ private:
     // Pid del thread al cual pertenece este addresspace.
     int pid;
 
+    #ifdef USE_TLB
+    /// Identificador en la TLB y generación en la que se asignó.  Si la
+    /// generación ya pasó, el espacio no tiene entradas en la TLB y se le
+    /// asigna otro ASID al volver a correr.
+    unsigned asid;
+    unsigned asidGeneration;
+
+    void AssignAsid();
+
+    /// Si la entrada de la TLB es una traducción válida de este espacio.
+    bool OwnsTlbEntry(const TranslationEntry *e) const;
+
+    /// Invalida la traducción de `vpn` en la TLB, si la hay, guardando
+    /// antes sus bits de uso en la tabla de paginación.
+    void InvalidateTlbPage(unsigned vpn);
+    #endif
+
     #ifdef DEMAND_LOADING
     // Using for DL
         Executable *exe; 
         OpenFile *exe_file;
+
+        /// Primera página después del stack.  Desde acá se ubican las
+        /// regiones mapeadas y `numPages` crece para cubrirlas.
+        unsigned mapBase;
+
+        /// Regiones mapeadas con `Mmap`.
+        Table<MappedRegion *> *mappings;
+
+        MappedRegion *FindMapping(unsigned vpn);
+        void LoadMappedPage(unsigned vpn);
+        void ReleaseRegion(int id);
+
+        /// Fallo en el que se adelantó cada página que todavía no se
+        /// pidió, o 0.  Los fallos se cuentan desde 1 en `numFaults`.
+        unsigned *prefetchedAt;
+        unsigned numFaults;
+
+        /// Páginas que se cargan juntas en cada fallo, alineadas a su
+        /// tamaño.  Se adapta según cuántas de las adelantadas se usan.
+        unsigned faultAround;
+        unsigned lastFault;
+        unsigned prefetchIssued;  ///< Adelantadas en el último fallo.
+        unsigned prefetchUsed;    ///< De ésas, las que ya se pidieron.
+
+        /// Después de cargar `vpn`, carga las páginas vecinas del
+        /// ejecutable que no estén en memoria, mientras haya marcos libres.
+        void FaultAround(unsigned vpn);
+
+        /// Carga `count` páginas seguidas desde `firstPage`, que ya tienen
+        /// marco, con una lectura del ejecutable por segmento.
+        void LoadPageRun(unsigned firstPage, unsigned count);
     #endif
 
     #ifdef SWAP
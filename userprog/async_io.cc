@@ -0,0 +1,209 @@
+/// Rutinas de entrada/salida asincrónica.
+///
+/// Ver `async_io.hh`.
+
+
+#include "async_io.hh"
+#include "threads/condition.hh"
+#include "threads/lock.hh"
+#include "threads/system.hh"
+
+
+AsyncIO::AsyncIO()
+{
+    queue         = new List<AioRequest *>;
+    requests      = new Table<AioRequest *>;
+    lock          = new Lock("AsyncIOLock");
+    workAvailable = new Condition("AsyncIOWork", lock);
+    requestDone   = new Condition("AsyncIODone", lock);
+    workerStarted = false;
+}
+
+AsyncIO::~AsyncIO()
+{
+    for (unsigned i = 0; i < Table<AioRequest *>::SIZE; i++) {
+        if (requests->HasKey(i)) {
+            Free(requests->Remove(i));
+        }
+    }
+    delete requestDone;
+    delete workAvailable;
+    delete lock;
+    delete requests;
+    delete queue;
+}
+
+int
+AsyncIO::Submit(AioRequest *request)
+{
+    ASSERT(request != nullptr);
+
+    lock->Acquire();
+    if (!workerStarted) {
+        Thread *worker = new Thread("AsyncIOWorker", false);
+        worker->Fork(Worker, this);
+        workerStarted = true;
+    }
+
+    int ticket = requests->Add(request);
+    if (ticket != -1) {
+        request->ticket    = ticket;
+        request->done      = false;
+        request->delivered = false;
+        queue->Append(request);
+        workAvailable->Signal();
+        DEBUG('e', "Pedido asincrónico %d del proceso %d encolado.\n",
+              ticket, request->pid);
+    }
+    lock->Release();
+    return ticket;
+}
+
+AioRequest *
+AsyncIO::Find(int ticket, int pid)
+{
+    if (ticket < 0 || !requests->HasKey(ticket)) {
+        return nullptr;
+    }
+    AioRequest *request = requests->Get(ticket);
+    return request->pid == pid ? request : nullptr;
+}
+
+int
+AsyncIO::Poll(int ticket, int pid)
+{
+    lock->Acquire();
+    AioRequest *request = Find(ticket, pid);
+    int status = request == nullptr ? -1 : request->done ? 1 : 0;
+    lock->Release();
+    return status;
+}
+
+AioRequest *
+AsyncIO::Finished(int ticket, int pid)
+{
+    lock->Acquire();
+    AioRequest *request = Find(ticket, pid);
+    if (request != nullptr && !request->done) {
+        request = nullptr;
+    }
+    lock->Release();
+    return request;
+}
+
+AioRequest *
+AsyncIO::Wait(int ticket, int pid)
+{
+    lock->Acquire();
+    AioRequest *request = Find(ticket, pid);
+    if (request != nullptr) {
+        while (!request->done) {
+            requestDone->Wait();
+        }
+        requests->Remove(ticket);
+    }
+    lock->Release();
+    return request;
+}
+
+void
+AsyncIO::Free(AioRequest *request)
+{
+    ASSERT(request != nullptr);
+    delete [] request->filename;
+    delete [] request->buffer;
+    delete request;
+}
+
+void
+AsyncIO::Drain(OpenFile *file)
+{
+    lock->Acquire();
+    bool pending = true;
+    while (pending) {
+        pending = false;
+        for (unsigned i = 0; i < Table<AioRequest *>::SIZE; i++) {
+            if (requests->HasKey(i)) {
+                AioRequest *request = requests->Get(i);
+                if (request->file == file && !request->done) {
+                    pending = true;
+                }
+            }
+        }
+        if (pending) {
+            requestDone->Wait();
+        }
+    }
+    lock->Release();
+}
+
+void
+AsyncIO::Forget(int pid)
+{
+    lock->Acquire();
+    for (unsigned i = 0; i < Table<AioRequest *>::SIZE; i++) {
+        if (!requests->HasKey(i)) {
+            continue;
+        }
+        AioRequest *request = requests->Get(i);
+        if (request->pid != pid) {
+            continue;
+        }
+        while (!request->done) {
+            requestDone->Wait();
+        }
+        Free(requests->Remove(i));
+    }
+    lock->Release();
+}
+
+void
+AsyncIO::Perform(AioRequest *request)
+{
+    ASSERT(request != nullptr);
+
+    DEBUG('e', "Atiendo el pedido asincrónico %d: %s de %u bytes en %u.\n",
+          request->ticket, request->write ? "escritura" : "lectura",
+          request->size, request->position);
+
+    if (request->write) {
+        request->result = fileTable->LockedWriteAt(request->filename,
+                                                   request->buffer,
+                                                   request->size,
+                                                   request->position);
+    } else {
+        // `ReadAt` no corta en el fin de archivo, así que se limita acá.
+        unsigned length = request->file->Length();
+        unsigned size = 0;
+        if (request->position < length) {
+            size = length - request->position < request->size
+                     ? length - request->position : request->size;
+        }
+        request->result = size == 0 ? 0
+          : fileTable->LockedReadAt(request->filename, request->buffer,
+                                    size, request->position);
+    }
+}
+
+void
+AsyncIO::Worker(void *arg)
+{
+    AsyncIO *aio = (AsyncIO *) arg;
+    ASSERT(aio != nullptr);
+
+    for (;;) {
+        aio->lock->Acquire();
+        while (aio->queue->IsEmpty()) {
+            aio->workAvailable->Wait();
+        }
+        AioRequest *request = aio->queue->Pop();
+        aio->lock->Release();
+
+        aio->Perform(request);
+
+        aio->lock->Acquire();
+        request->done = true;
+        aio->requestDone->Broadcast();
+        aio->lock->Release();
+    }
+}
@@ -0,0 +1,115 @@
+/// Entrada/salida asincrónica de archivos para programas de usuario.
+///
+/// `AioRead` y `AioWrite` encolan un pedido y devuelven enseguida un ticket.
+/// Un thread del kernel (el “worker”) atiende los pedidos de a uno; mientras
+/// espera al disco, los procesos de usuario siguen corriendo.  Con
+/// `AioPoll` se pregunta si un pedido terminó y con `AioWait` se espera a
+/// que termine y se recoge su resultado.
+///
+/// El worker no tiene el espacio de direcciones del proceso que hizo el
+/// pedido, así que los datos viajan en un buffer del kernel: al encolar una
+/// escritura se copian desde el usuario, y los de una lectura se copian al
+/// usuario la primera vez que el proceso ve que terminó, con `AioPoll` o
+/// con `AioWait`.  A diferencia de un AIO real, entonces, el buffer del
+/// usuario no se llena cuando termina el disco sino cuando el proceso lo
+/// pregunta; mientras tanto los datos ocupan memoria del kernel.
+///
+/// Sólo existe con el sistema de archivos real: usa los locks de lectores y
+/// escritores de la `fileTable`.
+
+#ifndef NACHOS_USERPROG_ASYNCIO__HH
+#define NACHOS_USERPROG_ASYNCIO__HH
+
+
+#include "lib/list.hh"
+#include "lib/table.hh"
+#include "filesys/open_file.hh"
+
+class Lock;
+class Condition;
+
+
+struct AioRequest {
+    int ticket;          ///< Identificador devuelto al usuario.
+    int pid;             ///< Proceso que hizo el pedido.
+    bool write;          ///< Escritura o lectura.
+    OpenFile *file;      ///< Archivo sobre el que se opera.
+    char *filename;      ///< Nombre en la `fileTable`.
+    unsigned position;   ///< Desde dónde leer o escribir.
+    unsigned size;       ///< Cantidad de bytes pedidos.
+    char *buffer;        ///< Buffer del kernel con los datos.
+    int userBuffer;      ///< Dirección del buffer en el espacio del usuario.
+    int result;          ///< Bytes transferidos, o -1.
+    bool done;           ///< Si el worker ya lo atendió.
+    bool delivered;      ///< Si los datos leídos ya están en `userBuffer`.
+};
+
+
+class AsyncIO {
+public:
+
+    AsyncIO();
+
+    ~AsyncIO();
+
+    /// Encola un pedido y devuelve su ticket, o -1 si hay demasiados
+    /// pedidos sin recoger.  Si se encola, el pedido pasa a ser de
+    /// `AsyncIO`.
+    int Submit(AioRequest *request);
+
+    /// Devuelve 1 si el pedido `ticket` del proceso `pid` terminó, 0 si
+    /// todavía no, o -1 si no existe.
+    int Poll(int ticket, int pid);
+
+    /// Devuelve el pedido `ticket` del proceso `pid` si ya terminó, sin
+    /// sacarlo de la tabla, o `nullptr` si no terminó o no existe.
+    AioRequest *Finished(int ticket, int pid);
+
+    /// Espera a que el pedido `ticket` del proceso `pid` termine y lo saca
+    /// de la tabla.  Devuelve `nullptr` si no existe.  Quien llama debe
+    /// liberarlo con `Free`.
+    AioRequest *Wait(int ticket, int pid);
+
+    /// Libera un pedido devuelto por `Wait`.
+    static void Free(AioRequest *request);
+
+    /// Espera a que no queden pedidos pendientes sobre `file`.  Se llama
+    /// antes de cerrar un archivo.
+    void Drain(OpenFile *file);
+
+    /// Espera a que terminen los pedidos del proceso `pid`, que está
+    /// terminando, y los descarta.
+    void Forget(int pid);
+
+private:
+
+    /// Cuerpo del thread worker.
+    static void Worker(void *arg);
+
+    /// Atiende un pedido.  Se llama sin el lock tomado.
+    void Perform(AioRequest *request);
+
+    /// Busca un pedido en la tabla.  Se llama con el lock tomado.
+    AioRequest *Find(int ticket, int pid);
+
+    /// Pedidos esperando al worker.
+    List<AioRequest *> *queue;
+
+    /// Todos los pedidos que todavía no se recogieron, indexados por
+    /// ticket.
+    Table<AioRequest *> *requests;
+
+    Lock *lock;
+
+    /// Se señala cuando llega un pedido nuevo.
+    Condition *workAvailable;
+
+    /// Se difunde cada vez que termina un pedido.
+    Condition *requestDone;
+
+    /// El worker se crea con el primer pedido.
+    bool workerStarted;
+};
+
+
+#endif
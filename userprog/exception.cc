@@ -24,6 +24,9 @@
 
 #include "filesys/file_system.hh"
 #include "filesys/open_file.hh"
+#ifdef FILESYS
+#include "filesys/file_header.hh"
+#endif
 #include "transfer.hh"
 #include "syscall.h"
 #include "filesys/directory_entry.hh"
@@ -32,8 +35,6 @@
 
 #include <stdio.h>
 
-unsigned IndexTLB = 0;
-
 static void
 IncrementPC()
 {
@@ -65,13 +66,59 @@ DefaultHandler(ExceptionType et) /// Cambia por PageFaultHandler. No incrementar
     ASSERT(false);
 }
 
+/// Termina el proceso actual con `status`, como la llamada `Exit`.
+static void
+ExitProcess(int status)
+{
+    #ifdef FILESYS
+    // No dejo pedidos asincrónicos sin recoger.
+    asyncIO->Forget(currentThread->GetPid());
+    #endif
+
+    #ifdef DEMAND_LOADING
+    // Los archivos mapeados quedan actualizados.
+    currentThread->space->UnmapAll();
+    #endif
+
+    if (space_table->Get(0) == currentThread) // Main thread Exit
+        interrupt->Halt();
+
+    currentThread->Finish(status);
+}
+
+#ifdef FILESYS
+/// Copia al usuario los datos de una lectura asincrónica que terminó, si
+/// todavía no se copiaron.
+///
+/// Se llama desde `AioPoll` y `AioWait`, con el proceso corriendo, y no
+/// desde el worker al terminar: el worker no puede escribir en el espacio
+/// de otro proceso, cuyas páginas pueden no estar cargadas y cuya TLB no es
+/// la actual.  Hasta entonces los datos esperan en el buffer del kernel.
+static void
+DeliverRead(AioRequest *request)
+{
+    ASSERT(request != nullptr && request->done);
+    if (!request->write && !request->delivered && request->result > 0)
+        WriteBufferToUser(request->buffer, request->userBuffer,
+                          request->result);
+    request->delivered = true;
+}
+#endif
+
 #ifdef USE_TLB
 static void
 PageFaultHandler(ExceptionType et) 
 {
     unsigned badVAddr = machine->ReadRegister(BAD_VADDR_REG);
-    currentThread->space->UpdateTLB(IndexTLB, badVAddr);
-    IndexTLB = (IndexTLB + 1) % TLB_SIZE;
+    unsigned victim = tlbPolicy->Victim();
+    // Una dirección fuera del espacio es un error del programa, no del
+    // kernel: se termina el proceso.
+    if (!currentThread->space->UpdateTLB(victim, badVAddr)) {
+        DEBUG('e', "Error: bad address 0x%X, process %d exits.\n",
+              badVAddr, currentThread->GetPid());
+        ExitProcess(-1);
+    }
+    tlbPolicy->Loaded(victim);
 }
 #endif
 
@@ -254,6 +301,12 @@ SyscallHandler(ExceptionType _et)
                 DEBUG('e', "Bad fd id %u.\n", fid);
                 status = -1;
             }
+            #ifdef DEMAND_LOADING
+            // Las regiones mapeadas del archivo se escriben y se desmapean.
+            if (!status)
+                currentThread->space->UnmapFile(fid);
+            #endif
+
             // Sacarlo de la tabla
             #ifndef FILESYS
             if (!status && !(file = currentThread->fileTableIds->Remove(fid))){
@@ -277,6 +330,9 @@ SyscallHandler(ExceptionType _et)
                 // Hay que eliminarlo unicamente si el proceso es el último
                 // en tenerlo abierto.
                 
+                // Que no quede ningún pedido asincrónico usándolo.
+                asyncIO->Drain(file);
+
                 fileTable->FileORLock(filename, ACQUIRE);
                 
                 int opens = fileTable->GetOpen(filename);
@@ -535,7 +591,7 @@ SyscallHandler(ExceptionType _et)
                 // Por lo tanto, escribo.
                 ReadBufferFromUser(bufferToRead, bufferTransfer, bytesToWrite);
                 status = file->WriteAt(bufferTransfer, bytesToWrite, currentThread->GetFileSeek(id));
-                currentThread->AddFileSeek(id, bytesToWrite); 
+                currentThread->AddFileSeek(id, status);
                 DEBUG('f', "Escribí %s con una cantidad de bytes de %d en file %s. Offset actual: %d\n", bufferTransfer, status, filename, currentThread->GetFileSeek(id));
                 
                 machine->WriteRegister(2,status);
@@ -567,6 +623,370 @@ SyscallHandler(ExceptionType _et)
             machine->WriteRegister(2, status);
             break;
         }
+        case SC_SENDFILE: {
+
+            OpenFileId outId = machine->ReadRegister(4);
+            OpenFileId inId = machine->ReadRegister(5);
+            int offset = machine->ReadRegister(6);
+            int count = machine->ReadRegister(7);
+            OpenFile *in, *out;
+
+            DEBUG('e', "`SendFile` requested from %d to %d, %d bytes.\n",
+                  inId, outId, count);
+
+            // La consola no es un archivo, para eso están Read y Write.
+            if (inId <= 1 || outId <= 1 || inId == outId) {
+                DEBUG('e', "Error: bad file ids %d and %d.\n", inId, outId);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            if (count < 0) {
+                DEBUG('e', "Error: Bytes to copy is negative. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            #ifndef FILESYS
+            in = currentThread->fileTableIds->Get(inId);
+            out = currentThread->fileTableIds->Get(outId);
+            if (in == nullptr || out == nullptr) {
+                DEBUG('e', "Error: File not found. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            unsigned chunk = SECTOR_SIZE;
+            // El stub lee hasta que `Read` devuelva 0.
+            unsigned position = offset < 0 ? 0 : offset;
+            unsigned left = count;
+            #else
+            in = currentThread->GetFile(inId);
+            out = currentThread->GetFile(outId);
+            char *inName = currentThread->GetFileName(inId);
+            char *outName = currentThread->GetFileName(outId);
+            if (in == nullptr || out == nullptr
+                  || inName == nullptr || outName == nullptr) {
+                DEBUG('e', "Error: File not found. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            if (in == out) {
+                DEBUG('e', "Error: cannot copy a file onto itself. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            // Se copia de a un bloque del file system, así cada escritura
+            // completa es un único pedido al disco.
+            unsigned chunk = FileHeader::GetBlockSize();
+
+            // `ReadAt` no corta en el fin de archivo, así que se limita acá.
+            unsigned position = offset < 0 ? currentThread->GetFileSeek(inId)
+                                           : offset;
+            unsigned length = in->Length();
+            unsigned left = 0;
+            if (position < length)
+                left = (unsigned) count < length - position
+                         ? count : length - position;
+            #endif
+
+            char *buffer = new char [chunk];
+            int copied = 0;
+            while (left > 0) {
+                unsigned n = left < chunk ? left : chunk;
+                #ifndef FILESYS
+                int status = offset < 0 ? in->Read(buffer, n)
+                                        : in->ReadAt(buffer, n, position);
+                if (status <= 0)
+                    break;
+                out->Write(buffer, status);
+                #else
+                // Cada pedazo toma y suelta los locks por separado, así dos
+                // copias cruzadas no pueden quedar esperándose.
+                int status = fileTable->LockedReadAt(inName, buffer, n,
+                                                     position);
+                if (status <= 0)
+                    break;
+                fileTable->LockedWriteAt(outName, buffer, status,
+                                         currentThread->GetFileSeek(outId));
+                currentThread->AddFileSeek(outId, status);
+                if (offset < 0)
+                    currentThread->AddFileSeek(inId, status);
+                #endif
+                position += status;
+                left -= status;
+                copied += status;
+            }
+            delete [] buffer;
+
+            DEBUG('f', "SendFile copió %d bytes.\n", copied);
+            machine->WriteRegister(2, copied);
+            break;
+        }
+        #ifndef FILESYS
+        case SC_AIOREAD:
+        case SC_AIOWRITE:
+        case SC_AIOWAIT:
+        case SC_AIOPOLL:
+            DEBUG('e', "Error: asynchronous I/O needs the real file system.\n");
+            machine->WriteRegister(2, -1);
+            break;
+        #else
+        case SC_AIOREAD:
+        case SC_AIOWRITE: {
+
+            int userBuffer = machine->ReadRegister(4);
+            int size = machine->ReadRegister(5);
+            OpenFileId id = machine->ReadRegister(6);
+            bool write = scid == SC_AIOWRITE;
+
+            if (id == 0 || id == 1) {
+                DEBUG('e', "Error: no asynchronous I/O on the console.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            if (userBuffer == 0 || size <= 0) {
+                DEBUG('e', "Error: bad buffer or size. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            OpenFile *file = currentThread->GetFile(id);
+            char *filename = currentThread->GetFileName(id);
+            if (file == nullptr || filename == nullptr) {
+                DEBUG('e', "Error: File not found. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            // El buffer del kernel es del tamaño del pedido.  Una escritura
+            // no puede dejar el archivo más grande que el máximo, así que se
+            // rechaza antes de pedir la memoria.
+            unsigned maxSize = MAX_FILE_SIZE * FileHeader::GetSectorsPerBlock();
+            unsigned position = currentThread->GetFileSeek(id);
+            if (write && (position > maxSize
+                            || (unsigned) size > maxSize - position)) {
+                DEBUG('e', "Error: write of %d bytes at %u is too large.\n",
+                      size, position);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            AioRequest *request = new AioRequest;
+            request->pid        = currentThread->GetPid();
+            request->write      = write;
+            request->file       = file;
+            request->filename   = new char [strlen(filename) + 1];
+            strcpy(request->filename, filename);
+            request->position   = position;
+            // Una lectura no pasa del fin de archivo, así que tampoco su
+            // buffer ni lo que avanza la posición.
+            if (!write) {
+                unsigned length = file->Length();
+                unsigned left = request->position < length
+                                  ? length - request->position : 0;
+                if ((unsigned) size > left)
+                    size = left;
+            }
+            request->size       = size;
+            request->buffer     = new char [size];
+            request->userBuffer = userBuffer;
+            request->result     = -1;
+
+            // Los datos a escribir se copian ahora: el worker no tiene
+            // acceso a la memoria del proceso.
+            if (write)
+                ReadBufferFromUser(userBuffer, request->buffer, size);
+
+            int ticket = asyncIO->Submit(request);
+            if (ticket == -1) {
+                DEBUG('e', "Error: too many asynchronous requests.\n");
+                AsyncIO::Free(request);
+            } else {
+                currentThread->AddFileSeek(id, size);
+            }
+            machine->WriteRegister(2, ticket);
+            break;
+        }
+        case SC_AIOWAIT: {
+
+            int ticket = machine->ReadRegister(4);
+            AioRequest *request = asyncIO->Wait(ticket,
+                                                currentThread->GetPid());
+            if (request == nullptr) {
+                DEBUG('e', "Error: unknown asynchronous ticket %d.\n", ticket);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            int status = request->result;
+            DeliverRead(request);
+            AsyncIO::Free(request);
+
+            machine->WriteRegister(2, status);
+            break;
+        }
+        case SC_AIOPOLL: {
+
+            int ticket = machine->ReadRegister(4);
+            int status = asyncIO->Poll(ticket, currentThread->GetPid());
+            // Cuando se informa que terminó, los datos ya están en el buffer.
+            if (status == 1)
+                DeliverRead(asyncIO->Finished(ticket,
+                                              currentThread->GetPid()));
+            machine->WriteRegister(2, status);
+            break;
+        }
+        #endif
+        #ifndef DEMAND_LOADING
+        case SC_MMAP:
+        case SC_MUNMAP:
+            DEBUG('e', "Error: memory-mapped files need demand loading.\n");
+            machine->WriteRegister(2, -1);
+            break;
+        #else
+        case SC_MMAP: {
+
+            OpenFileId id = machine->ReadRegister(4);
+            int length = machine->ReadRegister(5);
+
+            if (id <= 1) {
+                DEBUG('e', "Error: cannot map fd id %d.\n", id);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            if (length <= 0) {
+                DEBUG('e', "Error: bad length %d.\n", length);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            #ifndef FILESYS
+            OpenFile *file = currentThread->fileTableIds->Get(id);
+            const char *filename = nullptr;
+            #else
+            OpenFile *file = currentThread->GetFile(id);
+            const char *filename = currentThread->GetFileName(id);
+            #endif
+            if (file == nullptr) {
+                DEBUG('e', "Error: File not found. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            // Más allá del archivo no hay nada que leer ni escribir.
+            unsigned maxLength = DivRoundUp(file->Length(), PAGE_SIZE)
+                                   * PAGE_SIZE;
+            if ((unsigned) length > maxLength) {
+                DEBUG('e', "Error: length %d past the end of the file.\n",
+                      length);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            int addr = currentThread->space->Map(id, file, filename, length);
+            DEBUG('e', "`Mmap` of fd %d, %d bytes, at 0x%X.\n",
+                  id, length, addr);
+            machine->WriteRegister(2, addr);
+            break;
+        }
+        case SC_MUNMAP: {
+
+            int addr = machine->ReadRegister(4);
+            int status = currentThread->space->Unmap(addr) ? 0 : -1;
+            DEBUG('e', "`Munmap` of 0x%X, status %d.\n", addr, status);
+            machine->WriteRegister(2, status);
+            break;
+        }
+        #endif
+        #ifndef FILESYS
+        case SC_TRUNCATE:
+        case SC_ALLOCATE:
+            DEBUG('e', "Error: truncate and allocate need the real file system.\n");
+            machine->WriteRegister(2, -1);
+            break;
+        #else
+        case SC_TRUNCATE:
+        case SC_ALLOCATE: {
+
+            OpenFileId id = machine->ReadRegister(4);
+            int length = machine->ReadRegister(5);
+
+            if (id <= 1) {
+                DEBUG('e', "Error: cannot resize fd id %d.\n", id);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            if (length < 0) {
+                DEBUG('e', "Error: bad length %d.\n", length);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            OpenFile *file = currentThread->GetFile(id);
+            char *filename = currentThread->GetFileName(id);
+            if (file == nullptr || filename == nullptr) {
+                DEBUG('e', "Error: File not found. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            // Cambian los bloques del archivo: se toma como escritor, igual
+            // que en `Write`.
+            fileTable->BeginWrite(filename);
+            bool ok = scid == SC_TRUNCATE ? file->Truncate(length)
+                                          : file->Allocate(length);
+            fileTable->EndWrite(filename);
+
+            DEBUG('f', "%s de %s a %d bytes: %s.\n",
+                  scid == SC_TRUNCATE ? "Truncate" : "Allocate",
+                  filename, length, ok ? "ok" : "error");
+            machine->WriteRegister(2, ok ? 0 : -1);
+            break;
+        }
+        #endif
+        #ifndef FILESYS
+        case SC_IOSTATS:
+            DEBUG('e', "Error: I/O statistics need the real file system.\n");
+            machine->WriteRegister(2, -1);
+            break;
+        #else
+        case SC_IOSTATS: {
+
+            OpenFileId id = machine->ReadRegister(4);
+            int infoAddr = machine->ReadRegister(5);
+
+            if (infoAddr == 0) {
+                DEBUG('e', "Error: address to info is null.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            const IoStats *io = nullptr;
+            if (id == -1) {
+                io = &currentThread->io;
+            } else if (id > 1 && currentThread->GetFileName(id) != nullptr) {
+                io = fileTable->GetIoStats(currentThread->GetFileName(id));
+            }
+            if (io == nullptr) {
+                DEBUG('e', "Error: File not found. \n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            // En el orden de `IoInfo`.
+            unsigned info[] = {
+                (unsigned) io->readBytes, (unsigned) io->writtenBytes,
+                (unsigned) io->diskReads, (unsigned) io->diskWrites,
+                (unsigned) io->cacheHits, (unsigned) io->waitTicks
+            };
+            WriteBufferToUser((const char *) info, infoAddr, sizeof info);
+            machine->WriteRegister(2, 0);
+            break;
+        }
+        #endif
         case SC_EXEC:{
 
             int filenameAddr = machine->ReadRegister(4); 
@@ -709,11 +1129,7 @@ SyscallHandler(ExceptionType _et)
         case SC_EXIT: {
 
             int ret = machine->ReadRegister(4);            
-
-            if (space_table->Get(0) == currentThread) // Main thread Exit
-                interrupt->Halt();
-
-            currentThread->Finish(ret); 
+            ExitProcess(ret);
             break;
         }
         case SC_JOIN: {
@@ -36,6 +36,16 @@
 #define SC_RMDIR   18
 #define SC_LSDIR   19
 #define SC_CDIR    20
+#define SC_SENDFILE 21
+#define SC_AIOREAD  22
+#define SC_AIOWRITE 23
+#define SC_AIOWAIT  24
+#define SC_AIOPOLL  25
+#define SC_MMAP     26
+#define SC_MUNMAP   27
+#define SC_TRUNCATE 28
+#define SC_ALLOCATE 29
+#define SC_IOSTATS  30
 
 #ifndef IN_ASM
 
@@ -145,6 +155,89 @@ int LsDir();
 // puede ser un nombre o un path.
 int CDir(const char* name);
 
+/// Copia hasta `count` bytes del archivo `inId` al archivo `outId` sin
+/// pasar por memoria de usuario.
+///
+/// Si `offset` es negativo se lee desde la posición actual de `inId` y se
+/// la avanza; si no, se lee desde `offset` y la posición de `inId` no
+/// cambia.  Se escribe en la posición actual de `outId`.
+///
+/// Devuelve la cantidad de bytes copiados (0 en fin de archivo), o -1 si
+/// hubo un error.
+int SendFile(OpenFileId outId, OpenFileId inId, int offset, int count);
+
+
+/// Entrada/salida asincrónica: `AioRead`, `AioWrite`, `AioWait` y
+/// `AioPoll`.  Sólo con el sistema de archivos real.
+
+/// Encola la lectura de hasta `size` bytes del archivo `id`, desde su
+/// posición actual, y vuelve enseguida.  La lectura no pasa del fin de
+/// archivo y la posición avanza lo que se va a leer.
+///
+/// Devuelve un ticket para recoger el resultado, o -1 si hubo un error.
+/// `buffer` se llena recién cuando `AioPoll` devuelve 1 o `AioWait`
+/// vuelve, aunque la lectura haya terminado antes.
+int AioRead(char *buffer, int size, OpenFileId id);
+
+/// Encola la escritura de `size` bytes de `buffer` en el archivo `id`, en
+/// su posición actual, y vuelve enseguida.  `buffer` se copia antes de
+/// volver, así que se puede reusar.  Devuelve -1 si la escritura dejaría
+/// el archivo más grande que el máximo.
+int AioWrite(const char *buffer, int size, OpenFileId id);
+
+/// Espera a que termine el pedido `ticket` y devuelve la cantidad de bytes
+/// transferidos, o -1 si el ticket no existe.  El ticket deja de ser
+/// válido.
+int AioWait(int ticket);
+
+/// Devuelve 1 si el pedido `ticket` terminó, 0 si todavía no, o -1 si el
+/// ticket no existe.
+int AioPoll(int ticket);
+
+/// Mapea en memoria los primeros `length` bytes del archivo `id` y
+/// devuelve la dirección donde quedaron, o -1 si hubo un error.  Las
+/// páginas se leen del archivo a medida que se usan y las modificadas se
+/// escriben de vuelta al desmapear, al cerrar el archivo o al terminar el
+/// proceso.  `length` no puede pasar del fin del archivo redondeado a una
+/// página, y lo que quede después del fin no se escribe.  Necesita memoria
+/// virtual con carga por demanda.
+char *Mmap(OpenFileId id, int length);
+
+/// Desmapea la región que empieza en `addr`.  Devuelve 0, o -1 si no hay
+/// una región mapeada ahí.
+int Munmap(char *addr);
+
+/// Achica el archivo `id` a `length` bytes y libera en el disco los bloques
+/// que sobran.  No lo agranda.  Sólo con el sistema de archivos real.
+///
+/// Devuelve 0, o -1 si hubo un error.
+int Truncate(OpenFileId id, int length);
+
+/// Reserva en el disco lugar para los primeros `length` bytes del archivo
+/// `id`, en lo posible contiguo, sin cambiar su tamaño; las escrituras
+/// siguientes hasta ese tamaño no buscan sectores libres.  Sólo con el
+/// sistema de archivos real.
+///
+/// Devuelve 0, o -1 si no hay lugar o hubo un error.
+int Allocate(OpenFileId id, int length);
+
+/// Contadores de entrada/salida que devuelve `GetIoStats`.
+typedef struct {
+    unsigned readBytes;     ///< Bytes leídos.
+    unsigned writtenBytes;  ///< Bytes escritos.
+    unsigned diskReads;     ///< Pedidos de lectura al disco.
+    unsigned diskWrites;    ///< Pedidos de escritura al disco.
+    unsigned cacheHits;     ///< Páginas leídas de la caché.
+    unsigned waitTicks;     ///< Ticks esperando al disco.
+} IoInfo;
+
+/// Llena `info` con los contadores de entrada/salida del archivo `id`, o
+/// con los del proceso que llama si `id` es -1.  Sólo con el sistema de
+/// archivos real.
+///
+/// Devuelve 0, o -1 si hubo un error.
+int GetIoStats(OpenFileId id, IoInfo *info);
+
 
 #endif
 
@@ -0,0 +1,133 @@
+/// Rutinas de las políticas de reemplazo de la TLB.
+///
+/// Ver `tlb_policy.hh`.
+
+
+#include "tlb_policy.hh"
+#include "threads/system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+
+static const char *const POLICY_NAMES[] = {
+    "invalid-first", "random", "fifo", "lru", "clock"
+};
+
+TlbPolicy::TlbPolicy(TlbPolicyKind aKind)
+{
+    unsigned size = machine->GetMMU()->tlbSize;
+    ASSERT(size > 0);
+
+    kind = aKind;
+    hand = 0;
+    loadedAt = new unsigned long [size];
+    passedAt = new unsigned long [size];
+    for (unsigned i = 0; i < size; i++) {
+        loadedAt[i] = 0;
+        passedAt[i] = 0;
+    }
+    loads = 0;
+    evictions = 0;
+}
+
+TlbPolicy::~TlbPolicy()
+{
+    delete [] loadedAt;
+    delete [] passedAt;
+}
+
+bool
+TlbPolicy::Parse(const char *name, TlbPolicyKind *kind)
+{
+    ASSERT(name != nullptr);
+    ASSERT(kind != nullptr);
+
+    for (unsigned i = 0; i < sizeof POLICY_NAMES / sizeof *POLICY_NAMES; i++) {
+        if (!strcmp(name, POLICY_NAMES[i])) {
+            *kind = (TlbPolicyKind) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned
+TlbPolicy::Victim()
+{
+    MMU *mmu = machine->GetMMU();
+    unsigned size = mmu->tlbSize;
+
+    for (unsigned i = 0; i < size; i++) {
+        if (!mmu->tlb[i].valid) {
+            return i;
+        }
+    }
+
+    unsigned victim = 0;
+    switch (kind) {
+        case TLB_INVALID_FIRST:
+            victim = hand;
+            hand = (hand + 1) % size;
+            break;
+
+        case TLB_RANDOM:
+            victim = SystemDep::Random() % size;
+            break;
+
+        case TLB_FIFO:
+            for (unsigned i = 1; i < size; i++) {
+                if (loadedAt[i] < loadedAt[victim]) {
+                    victim = i;
+                }
+            }
+            break;
+
+        case TLB_LRU:
+            for (unsigned i = 1; i < size; i++) {
+                if (mmu->tlbLastUse[i] < mmu->tlbLastUse[victim]) {
+                    victim = i;
+                }
+            }
+            break;
+
+        case TLB_CLOCK:
+            // Termina en a lo sumo dos vueltas: en la primera se marcan
+            // todas como vistas.
+            while (mmu->tlbLastUse[hand] > passedAt[hand]) {
+                passedAt[hand] = mmu->tlbAccesses;
+                hand = (hand + 1) % size;
+            }
+            victim = hand;
+            hand = (hand + 1) % size;
+            break;
+    }
+    evictions++;
+    DEBUG('a', "TLB: reemplazo la entrada %u (página %u).\n",
+          victim, mmu->tlb[victim].virtualPage);
+    return victim;
+}
+
+void
+TlbPolicy::Loaded(unsigned i)
+{
+    MMU *mmu = machine->GetMMU();
+    ASSERT(i < mmu->tlbSize);
+
+    loadedAt[i] = ++loads;
+    mmu->tlbLastUse[i] = mmu->tlbAccesses;
+    passedAt[i] = mmu->tlbAccesses;
+}
+
+void
+TlbPolicy::Print() const
+{
+    // Después de cada fallo se reintenta el acceso, que acierta.
+    unsigned long misses = stats->numPageFaults;
+    unsigned long hits = stats->numPageHits - misses;
+    unsigned long total = hits + misses;
+    printf("TLB: %u entries, policy %s, hits %lu, misses %lu (%lu%% hits), "
+           "evictions %lu\n",
+           machine->GetMMU()->tlbSize, POLICY_NAMES[kind], hits, misses,
+           total > 0 ? hits * 100 / total : 0, evictions);
+}
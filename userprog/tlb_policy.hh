@@ -0,0 +1,69 @@
+/// Políticas de reemplazo de la TLB.
+///
+/// La TLB la maneja el kernel: en cada fallo `PageFaultHandler` pide a la
+/// política la entrada donde cargar la traducción.  Si hay una entrada
+/// inválida (por ejemplo, después de un cambio de contexto) se usa esa con
+/// cualquier política; si no, cada política elige una víctima:
+///
+/// * `invalid-first`: en orden circular, como hacía `PageFaultHandler`.
+/// * `random`: una al azar.
+/// * `fifo`: la cargada hace más tiempo.
+/// * `lru`: la que hace más que no acierta, según `MMU::tlbLastUse`.
+/// * `clock`: la primera que no acertó desde la última vuelta de la aguja.
+///
+/// Se elige con `-tlbp` y el tamaño de la TLB con `-tlb`.  Al terminar se
+/// imprimen los aciertos y fallos junto con la política usada.
+
+#ifndef NACHOS_USERPROG_TLBPOLICY__HH
+#define NACHOS_USERPROG_TLBPOLICY__HH
+
+
+enum TlbPolicyKind {
+    TLB_INVALID_FIRST,
+    TLB_RANDOM,
+    TLB_FIFO,
+    TLB_LRU,
+    TLB_CLOCK
+};
+
+
+class TlbPolicy {
+public:
+
+    /// Se crea después de la máquina: toma el tamaño de su TLB.
+    TlbPolicy(TlbPolicyKind aKind);
+
+    ~TlbPolicy();
+
+    /// Traduce el nombre de una política.  Devuelve falso si no existe.
+    static bool Parse(const char *name, TlbPolicyKind *kind);
+
+    /// Entrada donde cargar la próxima traducción.
+    unsigned Victim();
+
+    /// Avisa que se cargó una traducción en la entrada `i`.
+    void Loaded(unsigned i);
+
+    /// Imprime la política y los aciertos y fallos de la TLB.
+    void Print() const;
+
+private:
+
+    TlbPolicyKind kind;
+
+    /// Próxima entrada a mirar en `invalid-first` y `clock`.
+    unsigned hand;
+
+    /// Orden de carga de cada entrada, para `fifo`.
+    unsigned long *loadedAt;
+
+    /// Valor de `MMU::tlbAccesses` la última vez que la aguja pasó por
+    /// cada entrada, para `clock`.
+    unsigned long *passedAt;
+
+    unsigned long loads;
+    unsigned long evictions;  ///< Reemplazos de entradas válidas.
+};
+
+
+#endif
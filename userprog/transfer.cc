@@ -10,13 +10,49 @@
 // en la memoria de la máquina donde se ejecuta NACHOS.
 
 // En este archivo están las funciones para copiar datos desde el núcleo al espacio de memoria virtual del usuario y vicecersa.
+// Se traduce una vez por página y se copia el tramo entero con `memcpy`.
 
 #include "transfer.hh"
 #include "lib/utility.hh"
 #include "threads/system.hh"
 
+#include <string.h>
 
 
+/// Dirección del host donde está `userAddress`.  Con TLB, si la traducción
+/// falla se atiende la excepción como si la hubiera causado el programa
+/// (así el espacio de direcciones carga la página) y se reintenta.
+static char *
+UserToHost(int userAddress, bool writing)
+{
+    MMU *mmu = machine->GetMMU();
+    unsigned physicalAddress;
+    ExceptionType e;
+#ifdef USE_TLB
+    unsigned tries = 0;
+    while ((e = mmu->TranslateForKernel(userAddress, writing,
+                                        &physicalAddress)) != NO_EXCEPTION) {
+        ASSERT(++tries < NUM_EXCEPTION_TYPES);
+        machine->RaiseException(e, userAddress);
+    }
+#else
+    e = mmu->TranslateForKernel(userAddress, writing, &physicalAddress);
+    ASSERT(e == NO_EXCEPTION);
+#endif
+    if (writing) {
+        // Puede haber instrucciones de la página ya decodificadas.
+        mmu->ForgetDecodes(physicalAddress / PAGE_SIZE);
+    }
+    return &machine->mainMemory[physicalAddress];
+}
+
+/// Bytes desde `userAddress` hasta el fin de su página, como mucho `count`.
+static unsigned
+SpanInPage(int userAddress, unsigned count)
+{
+    unsigned left = PAGE_SIZE - (unsigned) userAddress % PAGE_SIZE;
+    return count < left ? count : left;
+}
 
 void ReadBufferFromUser(int userAddress, char *outBuffer,
                         unsigned byteCount)
@@ -25,26 +61,15 @@ void ReadBufferFromUser(int userAddress, char *outBuffer,
     ASSERT(outBuffer != nullptr);
     ASSERT(byteCount != 0);
 
-    unsigned count = 0;
-    do {
-        int temp;
-        count++;
-#ifdef USE_TLB
-        int i;
-        for(i = 0; i < NUM_EXCEPTION_TYPES && !machine->ReadMem(userAddress, 1, &temp); i++);
-        userAddress++;
-        ASSERT(i != NUM_EXCEPTION_TYPES);
-#else
-        ASSERT(machine->ReadMem(userAddress++, 1, &temp));
-#endif
-        *outBuffer = (unsigned char) temp;
-        outBuffer++;
-    } while (count < byteCount);
-
-    return;
+    while (byteCount > 0) {
+        unsigned span = SpanInPage(userAddress, byteCount);
+        memcpy(outBuffer, UserToHost(userAddress, false), span);
+        userAddress += span;
+        outBuffer += span;
+        byteCount -= span;
+    }
 }
 
-/// Cambiar los ASSERT cuando se haga el soporte para TLB
 bool ReadStringFromUser(int userAddress, char *outString,
                         unsigned maxByteCount)
 {
@@ -52,22 +77,20 @@ bool ReadStringFromUser(int userAddress, char *outString,
     ASSERT(outString != nullptr);
     ASSERT(maxByteCount != 0);
 
-    unsigned count = 0;
-    do {
-        int temp;
-        count++;
-#ifdef USE_TLB
-        int i;
-        for(i = 0; i < NUM_EXCEPTION_TYPES && !machine->ReadMem(userAddress, 1, &temp); i++);
-        userAddress++;
-        ASSERT(i != NUM_EXCEPTION_TYPES);
-#else
-        ASSERT(machine->ReadMem(userAddress++, 1, &temp));
-#endif
-        *outString = (unsigned char) temp;
-    } while (*outString++ != '\0' && count < maxByteCount);
-
-    return *(outString - 1) == '\0';
+    while (maxByteCount > 0) {
+        unsigned span = SpanInPage(userAddress, maxByteCount);
+        const char *from = UserToHost(userAddress, false);
+        const char *end = (const char *) memchr(from, '\0', span);
+        if (end != nullptr) {
+            memcpy(outString, from, end - from + 1);
+            return true;
+        }
+        memcpy(outString, from, span);
+        userAddress += span;
+        outString += span;
+        maxByteCount -= span;
+    }
+    return false;
 }
 
 void WriteBufferToUser(const char *buffer, int userAddress,
@@ -77,23 +100,13 @@ void WriteBufferToUser(const char *buffer, int userAddress,
     ASSERT(buffer != nullptr);
     ASSERT(byteCount != 0);
 
-    unsigned count = 0;
-    do {
-        int temp;
-        temp = *((int*)buffer++);
-        count++;
-#ifdef USE_TLB
-        int i;
-        for(i = 0; i < NUM_EXCEPTION_TYPES && !machine->WriteMem(userAddress, 1, temp); i++);
-        userAddress++;
-        ASSERT(i != NUM_EXCEPTION_TYPES);
-#else
-        ASSERT(machine->WriteMem(userAddress++, 1, temp));
-#endif
-    } while (count < byteCount);
-
-    return;
-
+    while (byteCount > 0) {
+        unsigned span = SpanInPage(userAddress, byteCount);
+        memcpy(UserToHost(userAddress, true), buffer, span);
+        userAddress += span;
+        buffer += span;
+        byteCount -= span;
+    }
 }
 
 void WriteStringToUser(const char *string, int userAddress)
@@ -101,18 +114,5 @@ void WriteStringToUser(const char *string, int userAddress)
     ASSERT(userAddress != 0);
     ASSERT(string != nullptr);
 
-    do {
-        int temp;
-        temp = *((int*)string++);
-#ifdef USE_TLB
-        int i;
-        for(i = 0; i < NUM_EXCEPTION_TYPES && !machine->WriteMem(userAddress, 1, temp); i++);
-        userAddress++;
-        ASSERT(i != NUM_EXCEPTION_TYPES);
-#else
-        ASSERT(machine->WriteMem(userAddress++, 1, temp));
-#endif
-    } while (*string != '\0');
-
-    return;
+    WriteBufferToUser(string, userAddress, strlen(string) + 1);
 }